@@ -0,0 +1,328 @@
+#ifndef __NGPT_ANTEX_INDEX_HPP__
+#define __NGPT_ANTEX_INDEX_HPP__
+
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "grid.hpp"
+
+namespace ngpt
+{
+
+/// @brief PCO/PCV values for one frequency of an ANTEX antenna block.
+struct antex_frequency_pcv
+{
+    std::string_view    freq;   ///< Frequency code, e.g. "G01".
+    double              neu[3]; ///< Phase centre offset (north, east, up) mm.
+    std::vector<double> noazi;  ///< Non-azimouth-dependent pcv, per zenith.
+    /// Azimouth-dependent pcv, stored as grid_storage_type::rm_bl with
+    /// azimouth on the x-axis and zenith on the y-axis; i.e. the value at
+    /// azimouth index i and zenith index j is values[j*num_azi+i]. If the
+    /// block has no azimouth-dependent values (DAZI=0), the noazi values are
+    /// copied for azimouths 0 and 360.
+    std::vector<double> values;
+};
+
+/// @brief The (parsed) PCO/PCV values of an ANTEX antenna block.
+struct antex_pcv
+{
+    double dazi, ///< Azimouth step (decimal degrees); 0 means no azimouth.
+           zen1, ///< First zenith (decimal degrees).
+           zen2, ///< Last zenith (decimal degrees).
+           dzen; ///< Zenith step (decimal degrees).
+    std::vector<antex_frequency_pcv> freqs; ///< One entry per frequency.
+
+    /// Return the pcv grid of the i-th frequency, as a data_grid2d (x-axis
+    /// is azimouth, y-axis is zenith). The grid's data array points to
+    /// freqs[i].values, so this instance must outlive the returned grid.
+    data_grid2d<double, double, grid_storage_type::rm_bl>
+    grid(std::size_t i) noexcept
+    {
+        double step = dazi > 0e0 ? dazi : 360e0;
+        data_grid2d<double, double, grid_storage_type::rm_bl> g(0e0, 360e0,
+            step, zen1, zen2, dzen);
+        g.data() = freqs[i].values.data();
+        return g;
+    }
+};
+
+/// @class antex_index
+/// @brief An (antenna type, serial number) index over an ANTEX file.
+///
+/// The index is built once, by reading the whole ANTEX file in memory and
+/// recording the start (offset) of every antenna block. Entries are kept in
+/// an open-addressing (linear probing) flat hash table, keyed on the antenna
+/// type (including the radome, e.g. "LEIATX1230+GNSS NONE") and the serial
+/// number. Keys are std::string_view's pointing into the file buffer, so a
+/// lookup is O(1), involves no string copies and never allocates.
+///
+/// Trailing whitespace is not part of a key (neither in the file nor in the
+/// query). Receiver antenna type-means have a blank serial number.
+/// Antenna blocks sharing the same key (e.g. satellite antennas with
+/// different validity intervals) are chained, in file order, through the
+/// entry::next member.
+///
+/// @example test_antex_index.cc
+class antex_index
+{
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    /// An antenna block of the ANTEX file.
+    struct entry
+    {
+        std::string_view type;   ///< Antenna type and radome (cols 1-20).
+        std::string_view serial; ///< Serial number or satellite code.
+        std::size_t      offset; ///< Offset of the 'START OF ANTENNA' line.
+        std::size_t      next;   ///< Next entry with the same key, or npos.
+    };
+
+    antex_index() = default;
+
+    // entries point into the file buffer; the index can not be copied.
+    antex_index(const antex_index&) = delete;
+    antex_index& operator=(const antex_index&) = delete;
+
+    /// Build the index from an ANTEX file.
+    ///
+    /// @param[in] path The ANTEX file.
+    /// @return         0 on success; any other value denotes an error (i.e.
+    ///                 failed to read the file).
+    int
+    build(const char* path)
+    {
+        _buf.clear();
+        _entries.clear();
+        if ( read_file(path, _buf) ) return 1;
+
+        std::size_t pos = 0, start = npos;
+        std::string_view line;
+        while ( next_line(pos, line) ) {
+            std::string_view lbl = label(line);
+            if ( lbl == "START OF ANTENNA" ) {
+                start = line.data() - _buf.data();
+            } else if ( lbl == "TYPE / SERIAL NO" && start != npos ) {
+                _entries.push_back({trim(field(line, 0, 20)),
+                                    trim(field(line, 20, 20)), start, npos});
+                start = npos;
+            }
+        }
+        this->hash_entries();
+        return 0;
+    }
+
+    /// Number of antenna blocks in the index.
+    std::size_t
+    size() const noexcept { return _entries.size(); }
+
+    /// All antenna blocks, in file order.
+    const std::vector<entry>&
+    entries() const noexcept { return _entries; }
+
+    /// Find an antenna block given its type (including radome) and serial
+    /// number; e.g. find("LEIATX1230+GNSS NONE").
+    ///
+    /// @param[in] type   Antenna type and radome.
+    /// @param[in] serial Serial number; empty for (receiver) type-means.
+    /// @return           Pointer to the (first) matching entry, or nullptr
+    ///                   if no such antenna exists.
+    const entry*
+    find(std::string_view type, std::string_view serial = {}) const noexcept
+    {
+        if ( _table.empty() ) return nullptr;
+        type   = trim(type);
+        serial = trim(serial);
+        std::size_t mask = _table.size() - 1;
+        for (std::size_t i = hash(type, serial) & mask; ; i = (i+1) & mask) {
+            std::uint32_t e = _table[i];
+            if ( e == empty ) return nullptr;
+            if ( _entries[e].type == type && _entries[e].serial == serial )
+                return &_entries[e];
+        }
+    }
+
+    /// Parse the PCO/PCV values of an antenna block.
+    ///
+    /// @param[in]  e   An entry of this index.
+    /// @param[out] pcv At output, the antenna's PCO/PCV values; its vectors
+    ///                 are reused, so loading many antennas in the same
+    ///                 antex_pcv instance seldom reallocates. Frequency codes
+    ///                 point into the index's file buffer.
+    /// @return         0 on success; any other value denotes an error (i.e.
+    ///                 the block is malformed).
+    int
+    load(const entry& e, antex_pcv& pcv) const
+    {
+        std::size_t pos = e.offset, nfreq = 0;
+        std::string_view line;
+        antex_frequency_pcv* cur = nullptr;
+        std::size_t nzen = 0, nazi = 0, iazi = 0;
+        pcv.dazi = pcv.zen1 = pcv.zen2 = pcv.dzen = 0e0;
+
+        while ( next_line(pos, line) ) {
+            std::string_view lbl = label(line);
+            if ( lbl == "COMMENT" ) {
+                continue;
+            } else if ( lbl == "END OF ANTENNA" ) {
+                pcv.freqs.resize(nfreq);
+                return !nfreq;
+            } else if ( lbl == "DAZI" ) {
+                if ( to_double(field(line, 2, 6), pcv.dazi) ) return 1;
+            } else if ( lbl == "ZEN1 / ZEN2 / DZEN" ) {
+                if ( to_double(field(line, 2, 6), pcv.zen1)
+                  || to_double(field(line, 8, 6), pcv.zen2)
+                  || to_double(field(line, 14, 6), pcv.dzen)
+                  || pcv.dzen <= 0e0 ) return 1;
+            } else if ( lbl == "START OF FREQUENCY" ) {
+                if ( pcv.freqs.size() <= nfreq ) pcv.freqs.emplace_back();
+                cur = &pcv.freqs[nfreq++];
+                cur->freq = trim(field(line, 3, 3));
+                nzen = static_cast<std::size_t>((pcv.zen2-pcv.zen1)/pcv.dzen+.5)+1;
+                nazi = pcv.dazi > 0e0
+                     ? static_cast<std::size_t>(360e0/pcv.dazi+.5)+1 : 2;
+                cur->noazi.resize(nzen);
+                cur->values.resize(nzen*nazi);
+                iazi = 0;
+            } else if ( lbl == "NORTH / EAST / UP" && cur ) {
+                for (int i = 0; i < 3; i++) {
+                    if ( to_double(field(line, 10*i, 10), cur->neu[i]) ) return 1;
+                }
+            } else if ( lbl == "END OF FREQUENCY" && cur ) {
+                if ( pcv.dazi <= 0e0 ) {
+                    for (std::size_t j = 0; j < nzen; j++) {
+                        cur->values[j*2] = cur->values[j*2+1] = cur->noazi[j];
+                    }
+                } else if ( iazi != nazi ) {
+                    return 1;
+                }
+                cur = nullptr;
+            } else if ( cur && line.size() >= 8 ) {
+                // a pcv record; either NOAZI or an azimouth row (note that
+                // long records extend over the label columns)
+                double* row;
+                if ( field(line, 3, 5) == "NOAZI" ) {
+                    row = cur->noazi.data();
+                } else {
+                    if ( iazi >= nazi ) return 1;
+                    row = nullptr;
+                }
+                for (std::size_t j = 0; j < nzen; j++) {
+                    double& val = row ? row[j] : cur->values[j*nazi+iazi];
+                    if ( to_double(field(line, 8+8*j, 8), val) ) return 1;
+                }
+                if ( !row ) ++iazi;
+            }
+        }
+        return 1;
+    }
+
+private:
+    static constexpr std::uint32_t empty = static_cast<std::uint32_t>(-1);
+
+    /// Read a whole file into a string.
+    static int
+    read_file(const char* path, std::string& buf)
+    {
+        std::FILE* fp = std::fopen(path, "rb");
+        if ( !fp ) return 1;
+        char chunk[1<<16];
+        std::size_t n;
+        while ( (n = std::fread(chunk, 1, sizeof chunk, fp)) > 0 ) buf.append(chunk, n);
+        int err = std::ferror(fp);
+        std::fclose(fp);
+        return err;
+    }
+
+    /// Get the line starting at pos (without the newline) and advance pos to
+    /// the start of the next line. Returns false at end of buffer.
+    bool
+    next_line(std::size_t& pos, std::string_view& line) const noexcept
+    {
+        if ( pos >= _buf.size() ) return false;
+        std::size_t end = _buf.find('\n', pos);
+        if ( end == std::string::npos ) end = _buf.size();
+        line = std::string_view(_buf.data()+pos, end-pos);
+        if ( !line.empty() && line.back() == '\r' ) line.remove_suffix(1);
+        pos = end + 1;
+        return true;
+    }
+
+    /// Sub-field of a line (cols [start, start+len)), clipped to the line.
+    static std::string_view
+    field(std::string_view line, std::size_t start, std::size_t len) noexcept
+    { return start < line.size() ? line.substr(start, len) : std::string_view{}; }
+
+    /// The (trimmed) header label of an ANTEX line (columns 61-80).
+    static std::string_view
+    label(std::string_view line) noexcept
+    { return trim(field(line, 60, 20)); }
+
+    /// Remove leading and trailing whitespace.
+    static std::string_view
+    trim(std::string_view s) noexcept
+    {
+        std::size_t b = s.find_first_not_of(' ');
+        if ( b == std::string_view::npos ) return {};
+        return s.substr(b, s.find_last_not_of(' ')-b+1);
+    }
+
+    /// Resolve a (fixed-width) numeric field to a double; a blank field is
+    /// an error.
+    static int
+    to_double(std::string_view s, double& val) noexcept
+    {
+        s = trim(s);
+        if ( s.empty() ) return 1;
+        auto res = std::from_chars(s.data(), s.data()+s.size(), val);
+        return res.ec != std::errc{};
+    }
+
+    /// FNV-1a hash of the (type, serial) pair.
+    static std::size_t
+    hash(std::string_view type, std::string_view serial) noexcept
+    {
+        std::uint64_t h = 14695981039346656037ULL;
+        for (unsigned char c : type)   h = (h ^ c) * 1099511628211ULL;
+        h = (h ^ 0xff) * 1099511628211ULL;
+        for (unsigned char c : serial) h = (h ^ c) * 1099511628211ULL;
+        return static_cast<std::size_t>(h ^ (h >> 32));
+    }
+
+    /// (Re)build the hash table; load factor is kept <= 0.5.
+    void
+    hash_entries()
+    {
+        std::size_t cap = 16;
+        while ( cap < 2*_entries.size() ) cap <<= 1;
+        _table.assign(cap, empty);
+        std::size_t mask = cap - 1;
+        for (std::uint32_t e = 0; e < _entries.size(); e++) {
+            const entry& en = _entries[e];
+            for (std::size_t i = hash(en.type, en.serial) & mask; ; i = (i+1) & mask) {
+                if ( _table[i] == empty ) {
+                    _table[i] = e;
+                    break;
+                }
+                entry& prev = _entries[_table[i]];
+                if ( prev.type == en.type && prev.serial == en.serial ) {
+                    // same key; append to the chain
+                    std::size_t last = _table[i];
+                    while ( _entries[last].next != npos ) last = _entries[last].next;
+                    _entries[last].next = e;
+                    break;
+                }
+            }
+        }
+    }
+
+    std::string                _buf;     ///< The whole ANTEX file.
+    std::vector<entry>         _entries; ///< Antenna blocks, in file order.
+    std::vector<std::uint32_t> _table;   ///< Hash table of entry indexes.
+}; // class antex_index
+
+} // namespace ngpt
+
+#endif
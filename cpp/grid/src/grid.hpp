@@ -432,6 +432,18 @@ public:
     at(std::size_t xidx, std::size_t yidx) noexcept
     { return _data[this->xy_idx2d_idx(xidx, yidx)]; }
 
+    /// Return the data array element corresponding to a given pair of x and
+    /// y tick indexes (const version).
+    ///
+    /// @param[in] xidx The x index value.
+    /// @param[in] yidx The y index value.
+    /// @return         (const reference to) the data array element
+    ///                 corresponding to the given (x,y) index pair.
+    /// @warning        No check is performed on the validity of the indexes.
+    const D&
+    at(std::size_t xidx, std::size_t yidx) const noexcept
+    { return _data[this->xy_idx2d_idx(xidx, yidx)]; }
+
     /// Bilinear interpolation at the given x, y point.
     D
     interpolate(T x, T y) const
@@ -516,10 +528,26 @@ public:
     is_out_of_range(T&& xval, T&& yval) const noexcept
     { return _grid.is_out_of_range(xval, yval); }
 
+    /// Number of ticks on the x-axis.
+    std::size_t
+    xpts() const noexcept { return _xpts; }
+
+    /// Number of ticks on the y-axis.
+    std::size_t
+    ypts() const noexcept { return _ypts; }
+
+    /// The underlying (data-less) grid, i.e. the x- and y-axis.
+    const grid2d<T>&
+    grid() const noexcept { return _grid; }
+
     /// @todo kinda dangerous ....
     D*&
     data() noexcept {return _data;}
 
+    /// The data array (const version).
+    const D*
+    data() const noexcept {return _data;}
+
 private:
     /// A static constant of type grid_storage_type::rm_bl
     typedef std::integral_constant<grid_storage_type,
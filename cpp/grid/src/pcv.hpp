@@ -0,0 +1,176 @@
+#ifndef __NGPT_PCV_HPP__
+#define __NGPT_PCV_HPP__
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "grid.hpp"
+
+namespace ngpt
+{
+
+/// @class pcv_corrector
+/// @brief Batch antenna phase-centre-variation (PCV) corrections.
+///
+/// A pcv_corrector holds a table of PCV grids, one per (antenna, frequency)
+/// pair; every grid is an azimouth-by-zenith data_grid2d, with azimouth (in
+/// decimal degrees) on the x-axis and zenith (in decimal degrees) on the
+/// y-axis, i.e. the layout of d3js/antex-plots/antex.json.
+///
+/// Corrections are computed for a whole batch of observations (e.g. all
+/// satellite-receiver pairs of an epoch) in one call. The queries are first
+/// grouped (via a counting sort) by (antenna, frequency), so that every grid
+/// is only touched once per call and stays in cache while all of its queries
+/// are interpolated. The results are scattered back to the input order.
+/// Scratch buffers are kept between calls, so that (once they have grown to
+/// the largest batch size) no allocation happens.
+///
+/// Azimouth values are wrapped into [0, 360); zenith values are clamped to
+/// the y-axis range of the grid.
+///
+/// @tparam T The tick-axis type(s), can be any floating point type.
+/// @tparam D The type of the (actual) pcv data.
+/// @tparam G The order the data is allocated in (any of grid_storage_type).
+///
+/// @warning The grids are not owned by the pcv_corrector; they must outlive
+///          it and have their data arrays already set.
+///
+/// @example test_pcv.cc
+template<typename T,
+         typename D,
+         grid_storage_type G
+         >
+    class pcv_corrector
+{
+public:
+    typedef data_grid2d<T, D, G> grid_type;
+
+    /// Constructor.
+    /// @param[in] num_freqs Number of frequencies each antenna has PCV
+    ///                      grids for.
+    explicit
+    pcv_corrector(std::size_t num_freqs) noexcept
+    : _nfreq{num_freqs}
+    {}
+
+    /// Add an antenna, i.e. its PCV grids for every frequency.
+    ///
+    /// @param[in] grids Array of num_freqs pointers to grids; grids[i] is the
+    ///                  PCV grid for frequency index i. A nullptr grid means
+    ///                  that the antenna has no PCV for this frequency (its
+    ///                  corrections are set to zero).
+    /// @return          The index of the antenna, to be used in queries.
+    std::size_t
+    add_antenna(const grid_type* const* grids)
+    {
+        _grids.insert(_grids.end(), grids, grids + _nfreq);
+        return _grids.size() / _nfreq - 1;
+    }
+
+    /// Number of antennas.
+    std::size_t
+    num_antennas() const noexcept { return _nfreq ? _grids.size()/_nfreq : 0; }
+
+    /// Number of frequencies.
+    std::size_t
+    num_freqs() const noexcept { return _nfreq; }
+
+    /// Compute PCV corrections for a batch of (azimouth, zenith) queries.
+    ///
+    /// @param[in]  ant  Array of n antenna indexes (as returned by
+    ///                  pcv_corrector::add_antenna).
+    /// @param[in]  freq Array of n frequency indexes, in range [0, num_freqs).
+    /// @param[in]  azi  Array of n azimouth values (decimal degrees).
+    /// @param[in]  zen  Array of n zenith values (decimal degrees).
+    /// @param[out] pcv  Array of n values; at output, the PCV corrections.
+    /// @param[in]  n    Number of queries.
+    /// @warning    No check is performed on the antenna/frequency indexes.
+    void
+    correct(const std::size_t* ant, const std::size_t* freq, const T* azi,
+            const T* zen, D* pcv, std::size_t n)
+    {
+        this->group(ant, freq, n);
+        for (std::size_t g = 0; g + 1 < _first.size(); ++g) {
+            const grid_type* grid = _grids[g];
+            for (std::size_t k = _first[g]; k < _first[g+1]; ++k) {
+                std::size_t i = _order[k];
+                pcv[i] = grid ? this->interpolate(*grid, azi[i], zen[i]) : D{0};
+            }
+        }
+    }
+
+    /// Compute PCV corrections for a batch of line-of-sight vectors.
+    ///
+    /// The line-of-sight vectors must be given in the local topocentric
+    /// (east, north, up) frame of the antenna; they need not be normalized.
+    ///
+    /// @param[in]  ant  Array of n antenna indexes (as returned by
+    ///                  pcv_corrector::add_antenna).
+    /// @param[in]  freq Array of n frequency indexes, in range [0, num_freqs).
+    /// @param[in]  enu  Array of 3*n values; the i-th line-of-sight vector is
+    ///                  (enu[3*i], enu[3*i+1], enu[3*i+2]).
+    /// @param[out] pcv  Array of n values; at output, the PCV corrections.
+    /// @param[in]  n    Number of queries.
+    /// @warning    No check is performed on the antenna/frequency indexes.
+    void
+    correct_los(const std::size_t* ant, const std::size_t* freq, const T* enu,
+                D* pcv, std::size_t n)
+    {
+        constexpr T rad2deg = T(180) / T(3.14159265358979323846);
+        this->group(ant, freq, n);
+        for (std::size_t g = 0; g + 1 < _first.size(); ++g) {
+            const grid_type* grid = _grids[g];
+            for (std::size_t k = _first[g]; k < _first[g+1]; ++k) {
+                std::size_t i = _order[k];
+                if ( !grid ) {
+                    pcv[i] = D{0};
+                    continue;
+                }
+                const T* v = enu + 3*i;
+                T hor = std::sqrt(v[0]*v[0] + v[1]*v[1]);
+                T azi = std::atan2(v[0], v[1]) * rad2deg;
+                T zen = std::atan2(hor, v[2]) * rad2deg;
+                pcv[i] = this->interpolate(*grid, azi, zen);
+            }
+        }
+    }
+
+private:
+    /// Bilinear interpolation on a pcv grid, after wrapping azimouth and
+    /// clamping zenith to the valid grid range.
+    static D
+    interpolate(const grid_type& grid, T azi, T zen) noexcept
+    {
+        azi = std::fmod(azi, T(360));
+        if ( azi < T(0) ) azi += T(360);
+        const grid2d<T>& g = grid.grid();
+        T zmin = std::min(g.y_start(), g.y_stop()),
+          zmax = std::max(g.y_start(), g.y_stop());
+        zen = std::min(std::max(zen, zmin), zmax);
+        return grid.interpolate(azi, zen);
+    }
+
+    /// Counting sort of the queries by (antenna, frequency). At output,
+    /// _order[_first[g]] ... _order[_first[g+1]-1] are the indexes of all
+    /// queries referring to the grid _grids[g].
+    void
+    group(const std::size_t* ant, const std::size_t* freq, std::size_t n)
+    {
+        _first.assign(_grids.size()+1, 0);
+        _order.resize(n);
+        for (std::size_t i = 0; i < n; ++i) ++_first[ant[i]*_nfreq+freq[i]+1];
+        for (std::size_t g = 1; g < _first.size(); ++g) _first[g] += _first[g-1];
+        _next.assign(_first.begin(), _first.end()-1);
+        for (std::size_t i = 0; i < n; ++i) _order[_next[ant[i]*_nfreq+freq[i]]++] = i;
+    }
+
+    std::size_t                    _nfreq; ///< Number of frequencies.
+    std::vector<const grid_type*>  _grids; ///< Grids; index ant*_nfreq+freq.
+    std::vector<std::size_t>       _first, ///< Start of each group in _order.
+                                   _next,  ///< Scratch for the counting sort.
+                                   _order; ///< Query indexes, grouped by grid.
+}; // class pcv_corrector
+
+} // namespace ngpt
+
+#endif
@@ -0,0 +1,289 @@
+#ifndef __NGPT_PCV_JSON_HPP__
+#define __NGPT_PCV_JSON_HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "grid.hpp"
+#include "../../matrix/src/run_threads.hpp"
+
+namespace ngpt
+{
+
+/// @brief Meta-data written in the header of a (d3js) antex JSON file.
+///
+/// These are the (string) fields preceding the pcv grid in files such as
+/// d3js/antex-plots/antex.json. An empty antex field is not written at all.
+struct pcv_json_header
+{
+    std::string_view antex;          ///< Name of the originating ANTEX file.
+    std::string_view master_antenna; ///< e.g. "LEIATX1230+GNSS NONE"
+    std::string_view slave_antenna;  ///< Usualy empty.
+    std::string_view type;           ///< e.g. "azi" or "noazi"
+};
+
+/// @class pcv_json_writer
+/// @brief Stream a PCV data_grid2d to a file, in the d3js antex JSON format.
+///
+/// The grid is expected to have azimouth on the x-axis and zenith on the
+/// y-axis; the written "pcv_values" array holds one row per zenith tick
+/// (in y-axis order), each row holding one value per azimouth tick (in x-axis
+/// order). That is exactly what d3js/antex-plots/antex.js expects.
+///
+/// Numeric values are formatted with std::to_chars (shortest round-trip
+/// representation) directly into an internal buffer, which is flushed to the
+/// file whenever it fills up. The buffer is allocated once (at construction)
+/// and reused for every file written via this instance, so writing a grid
+/// performs no per-value allocation.
+///
+/// @warning A pcv_json_writer instance is not thread-safe; use one instance
+///          per thread (see export_pcv_json).
+///
+/// @example test_pcv_json.cc
+class pcv_json_writer
+{
+public:
+    /// Constructor; allocate the (reusable) output buffer.
+    ///
+    /// @param[in] bufsz Size of the output buffer in bytes; anything less than
+    ///                  min_bufsz is silently increased to min_bufsz.
+    explicit
+    pcv_json_writer(std::size_t bufsz = 1<<16)
+    : _buf(bufsz < min_bufsz ? min_bufsz : bufsz),
+      _pos{0},
+      _fp{nullptr},
+      _err{0}
+    {}
+
+    pcv_json_writer(const pcv_json_writer&) = delete;
+    pcv_json_writer& operator=(const pcv_json_writer&) = delete;
+
+    ~pcv_json_writer() noexcept { this->close(); }
+
+    /// Write a PCV grid (and its header) to a file, in the d3js antex JSON
+    /// format. Any previous content of the file is truncated.
+    ///
+    /// @param[in] path   The name of the file to write.
+    /// @param[in] hdr    Header (meta-data) fields.
+    /// @param[in] grid   The PCV grid; x-axis is azimouth, y-axis is zenith.
+    /// @return           0 on success; any other value denotes an error (i.e.
+    ///                   failed to open or write the file).
+    template<typename T, typename D, grid_storage_type G>
+        int
+        write(const char* path, const pcv_json_header& hdr,
+              const data_grid2d<T, D, G>& grid) noexcept
+    {
+        if ( !(_fp = std::fopen(path, "wb")) ) return 1;
+        _pos = 0;
+        _err = 0;
+
+        this->put("{\n");
+        if ( !hdr.antex.empty() ) this->put_field("antex", hdr.antex);
+        this->put_field("master_antenna", hdr.master_antenna);
+        this->put_field("slave_antenna", hdr.slave_antenna);
+        this->put_field("type", hdr.type);
+
+        const grid2d<T>& g = grid.grid();
+        this->put("  \"zenith_range\": ");
+        this->put_range(g.y_start(), g.y_stop(), g.y_step());
+        this->put(",\n  \"azimouth_range\": ");
+        this->put_range(g.x_start(), g.x_stop(), g.x_step());
+        this->put(",\n  \"pcv_values\": [\n");
+
+        const std::size_t xpts = grid.xpts(),
+                          ypts = grid.ypts();
+        for (std::size_t y = 0; y < ypts; ++y) {
+            this->put('[');
+            for (std::size_t x = 0; x < xpts; ++x) {
+                if (x) this->put(", ");
+                this->put_num(grid.at(x, y));
+            }
+            this->put(y+1 < ypts ? "],\n" : "]");
+        }
+        this->put("]\n}\n");
+
+        return this->close();
+    }
+
+    /// Minimum size of the output buffer; must fit any formatted number.
+    static constexpr std::size_t min_bufsz = 256;
+
+private:
+    /// Flush the buffer to the file.
+    void
+    flush() noexcept
+    {
+        if ( _pos && std::fwrite(_buf.data(), 1, _pos, _fp) != _pos ) _err = 1;
+        _pos = 0;
+    }
+
+    /// Flush the buffer and close the file (if open).
+    /// @return 0 if everything was written succesefully.
+    int
+    close() noexcept
+    {
+        if ( !_fp ) return _err;
+        this->flush();
+        if ( std::fclose(_fp) ) _err = 1;
+        _fp = nullptr;
+        return _err;
+    }
+
+    /// Make sure there is room for (at least) n more chars in the buffer.
+    void
+    reserve(std::size_t n) noexcept
+    { if ( _pos + n > _buf.size() ) this->flush(); }
+
+    void
+    put(char c) noexcept
+    {
+        this->reserve(1);
+        _buf[_pos++] = c;
+    }
+
+    void
+    put(std::string_view s) noexcept
+    {
+        while ( !s.empty() ) {
+            this->reserve(1);
+            std::size_t n = std::min(s.size(), _buf.size() - _pos);
+            std::memcpy(_buf.data() + _pos, s.data(), n);
+            _pos += n;
+            s.remove_prefix(n);
+        }
+    }
+
+    /// Write a quoted (and escaped) JSON string.
+    void
+    put_string(std::string_view s) noexcept
+    {
+        static const char hex[] = "0123456789abcdef";
+        this->put('"');
+        for (unsigned char c : s) {
+            if ( c == '"' || c == '\\' ) {
+                this->put('\\');
+                this->put(static_cast<char>(c));
+            } else if ( c < 0x20 ) {
+                char esc[] = {'\\', 'u', '0', '0', hex[c>>4], hex[c&0xf]};
+                this->put(std::string_view(esc, sizeof esc));
+            } else {
+                this->put(static_cast<char>(c));
+            }
+        }
+        this->put('"');
+    }
+
+    /// Write a header line of type: '  "key": "value",\n'
+    void
+    put_field(std::string_view key, std::string_view value) noexcept
+    {
+        this->put("  ");
+        this->put_string(key);
+        this->put(": ");
+        this->put_string(value);
+        this->put(",\n");
+    }
+
+    /// Write a number; non-finite values are written as null (JSON has no
+    /// representation for them).
+    template<typename D>
+        void
+        put_num(D val) noexcept
+    {
+        if ( !std::isfinite(val) ) {
+            this->put("null");
+            return;
+        }
+        this->reserve(min_bufsz);
+        auto res = std::to_chars(_buf.data() + _pos,
+                                 _buf.data() + _buf.size(), val);
+        _pos = res.ptr - _buf.data();
+    }
+
+    /// Write an axis range, as: [start, stop, step]
+    template<typename T>
+        void
+        put_range(T start, T stop, T step) noexcept
+    {
+        this->put('[');
+        this->put_num(start);
+        this->put(", ");
+        this->put_num(stop);
+        this->put(", ");
+        this->put_num(step);
+        this->put(']');
+    }
+
+    std::vector<char> _buf; ///< The (reusable) output buffer.
+    std::size_t       _pos; ///< Number of chars currently in the buffer.
+    std::FILE*        _fp;  ///< The file currently written.
+    int               _err; ///< Non-zero if any write has failed.
+}; // class pcv_json_writer
+
+/// @brief A single export job, i.e. a grid to be written to a file.
+template<typename T, typename D, grid_storage_type G>
+    struct pcv_json_job
+{
+    std::string                   path;   ///< The output file.
+    pcv_json_header               header; ///< Header (meta-data) fields.
+    const data_grid2d<T, D, G>*   grid;   ///< The PCV grid to write.
+};
+
+/// @brief Export a number of PCV grids (e.g. all antennas of an ANTEX file)
+///        to individual JSON files, in parallel.
+///
+/// The jobs are distributed to (at most) num_threads worker threads; each
+/// thread owns a single pcv_json_writer, reused for all the files it writes.
+///
+/// @param[in] jobs        Pointer to an array of export jobs.
+/// @param[in] njobs       Number of jobs in the jobs array.
+/// @param[in] num_threads Max number of threads to use; if 0, then
+///                        std::thread::hardware_concurrency is used.
+/// @return                The number of jobs that failed (0 means all files
+///                        were written succesefuly).
+template<typename T, typename D, grid_storage_type G>
+    std::size_t
+    export_pcv_json(const pcv_json_job<T, D, G>* jobs, std::size_t njobs,
+                    unsigned num_threads = 0)
+{
+    if ( !num_threads ) num_threads = std::thread::hardware_concurrency();
+    if ( !num_threads ) num_threads = 1;
+    if ( num_threads > njobs ) num_threads = static_cast<unsigned>(njobs);
+
+    std::atomic<std::size_t> next {0},
+                             failed {0};
+    auto worker = [&](int) {
+        // a thread that cannot allocate its writer takes no jobs; they are
+        // left to the other threads (or counted as failed below)
+        try {
+            pcv_json_writer writer;
+            for (std::size_t i = next++; i < njobs; i = next++) {
+                if ( writer.write(jobs[i].path.c_str(), jobs[i].header,
+                                  *jobs[i].grid) ) ++failed;
+            }
+        } catch (std::bad_alloc&) {
+        }
+    };
+
+    // jobs are handed out by the atomic counter, so if a thread cannot be
+    // started the ones already running (and this one) write its files
+    run_threads(static_cast<int>(num_threads), worker);
+
+    // jobs never taken (no thread could allocate a writer) were not written
+    const std::size_t taken = next;
+    if ( taken < njobs ) failed += njobs - taken;
+
+    return failed;
+}
+
+} // namespace ngpt
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef __NGPT_SH_SYNTHESIS_HPP__
+#define __NGPT_SH_SYNTHESIS_HPP__
+
+#include <atomic>
+#include <cmath>
+#include <new>
+#include <thread>
+#include <vector>
+#include "grid.hpp"
+#include "../../matrix/src/run_threads.hpp"
+
+namespace ngpt
+{
+
+/// @brief Index of the (n,m) coefficient in triangular storage.
+///
+/// Spherical harmonic coefficients up to degree nmax are stored in arrays of
+/// size (nmax+1)*(nmax+2)/2, ordered by degree and then order, i.e.
+/// C00, C10, C11, C20, C21, C22, ...
+inline std::size_t
+sh_index(int n, int m) noexcept
+{ return static_cast<std::size_t>(n)*(n+1)/2 + m; }
+
+/// @brief Spherical harmonic synthesis on a (regular) latitude/longitude grid.
+///
+/// Evaluate the (fully normalized) spherical harmonic expansion
+/// \f[ f(\phi,\lambda) = \sum_{n=0}^{N}\sum_{m=0}^{n} \bar{P}_{nm}(\sin\phi)
+///     \left(\bar{C}_{nm}\cos m\lambda + \bar{S}_{nm}\sin m\lambda\right) \f]
+/// at every node of a data_grid2d, where the x-axis is (geocentric)
+/// longitude and the y-axis is (geocentric) latitude, both in decimal
+/// degrees.
+///
+/// The regular structure of the grid is exploited:
+///   - the Legendre functions are computed only once per latitude row (via
+///     the standard column-wise recursion) and immediately reduced to the
+///     Fourier coefficients \f$ a_m = \sum_n \bar{C}_{nm}\bar{P}_{nm} \f$,
+///     \f$ b_m = \sum_n \bar{S}_{nm}\bar{P}_{nm} \f$, in O(N^2);
+///   - the longitude sums \f$ \sum_m a_m\cos m\lambda + b_m\sin m\lambda \f$
+///     are evaluated with the Clenshaw recurrence (so only \f$\cos\lambda\f$
+///     and \f$\sin\lambda\f$ are needed per node), in O(N) per node;
+///   - rows are independent and are distributed over num_threads threads.
+/// The total cost is thus O(rows*(N^2 + N*cols)), instead of
+/// O(rows*cols*N^2) for a node-by-node evaluation.
+///
+/// To avoid underflow of the sectorial functions close to the poles, the
+/// recursions are performed on \f$ 10^{-280}\bar{P}_{nm}/\cos^m\phi \f$ and
+/// rescaled afterwards (Holmes & Featherstone, 2002); this is stable up to
+/// degree ~2700.
+///
+/// @param[in]     C           The \f$\bar{C}_{nm}\f$ coefficients, in
+///                            triangular storage (see sh_index).
+/// @param[in]     S           The \f$\bar{S}_{nm}\f$ coefficients, in
+///                            triangular storage (see sh_index).
+/// @param[in]     nmax        Maximum degree (and order) of the expansion.
+/// @param[in,out] grid        The grid; its data array must already be
+///                            allocated. At output it holds the synthesized
+///                            values.
+/// @param[in]     num_threads Max number of threads to use; if 0, then
+///                            std::thread::hardware_concurrency is used.
+/// @return                    0 on success; any other value denotes an error
+///                            (i.e. nmax < 0 or no data array).
+///
+/// Reference: Holmes, S.A. & Featherstone, W.E., A unified approach to the
+///            Clenshaw summation and the recursive computation of very high
+///            degree and order normalised associated Legendre functions,
+///            Journal of Geodesy (2002) 76: 279-299
+///
+/// @example test_sh_synthesis.cc
+template<typename T, typename D, grid_storage_type G>
+    int
+    sh_synthesis(const D* C, const D* S, int nmax, data_grid2d<T, D, G>& grid,
+                 unsigned num_threads = 0)
+{
+    if ( nmax < 0 || !grid.data() ) return 1;
+
+    constexpr double scale    {1e-280},
+                     invscale {1e280},
+                     deg2rad  {3.14159265358979323846/180e0};
+
+    // Recursion coefficients, P(n,m) = a(n,m)*t*P(n-1,m) - b(n,m)*P(n-2,m),
+    // in triangular storage, plus the sectorial factors. Shared by all rows.
+    const std::size_t ncoef = sh_index(nmax+1, 0);
+    std::vector<double> anm(ncoef), bnm(ncoef), sec(nmax+1);
+    for (int m = 0; m <= nmax; ++m) {
+        sec[m] = (m == 0) ? 1e0 : (m == 1) ? std::sqrt(3e0)
+               : std::sqrt((2e0*m+1e0)/(2e0*m));
+        for (int n = m+1; n <= nmax; ++n) {
+            double nm = static_cast<double>(n-m)*(n+m);
+            anm[sh_index(n,m)] = std::sqrt((2e0*n-1e0)*(2e0*n+1e0)/nm);
+            bnm[sh_index(n,m)] = (n < m+2) ? 0e0
+                : std::sqrt((2e0*n+1e0)*(n+m-1e0)*(n-m-1e0)/(nm*(2e0*n-3e0)));
+        }
+    }
+
+    // cos/sin of the longitudes; shared by all rows.
+    const std::size_t xpts = grid.xpts(),
+                      ypts = grid.ypts();
+    const grid2d<T>& g = grid.grid();
+    std::vector<double> cosl(xpts), sinl(xpts);
+    for (std::size_t i = 0; i < xpts; ++i) {
+        double lon = (g.x_start() + i*g.x_step()) * deg2rad;
+        cosl[i] = std::cos(lon);
+        sinl[i] = std::sin(lon);
+    }
+
+    std::atomic<std::size_t> next {0};
+    auto worker = [&](int) {
+        std::vector<double> am(nmax+1), bm(nmax+1);
+        for (std::size_t j = next++; j < ypts; j = next++) {
+            double lat = (g.y_start() + j*g.y_step()) * deg2rad;
+            double t   = std::sin(lat),
+                   u   = std::cos(lat),
+                   pmm = scale,  // scaled sectorial P(m,m)/u^m
+                   um  = 1e0;    // u^m
+            // Legendre functions, one order (column) at a time, reduced on
+            // the fly to the Fourier coefficients of the row.
+            for (int m = 0; m <= nmax; ++m) {
+                pmm *= sec[m];
+                double p2 = 0e0,
+                       p1 = pmm;
+                std::size_t k = sh_index(m,m);
+                double a = C[k]*p1,
+                       b = S[k]*p1;
+                for (int n = m+1; n <= nmax; ++n) {
+                    k = sh_index(n,m);
+                    double p = anm[k]*t*p1 - bnm[k]*p2;
+                    a += C[k]*p;
+                    b += S[k]*p;
+                    p2 = p1;
+                    p1 = p;
+                }
+                am[m] = (a*um)*invscale;
+                bm[m] = (b*um)*invscale;
+                um *= u;
+            }
+            // Clenshaw summation over the order, for every longitude
+            for (std::size_t i = 0; i < xpts; ++i) {
+                double c2 = 2e0*cosl[i],
+                       ya1 = 0e0, ya2 = 0e0,
+                       yb1 = 0e0, yb2 = 0e0;
+                for (int m = nmax; m > 0; --m) {
+                    double ya = am[m] + c2*ya1 - ya2,
+                           yb = bm[m] + c2*yb1 - yb2;
+                    ya2 = ya1; ya1 = ya;
+                    yb2 = yb1; yb1 = yb;
+                }
+                grid.at(i, j) = static_cast<D>(am[0] + cosl[i]*ya1 - ya2
+                                               + sinl[i]*yb1);
+            }
+        }
+    };
+
+    if ( !num_threads ) num_threads = std::thread::hardware_concurrency();
+    if ( !num_threads ) num_threads = 1;
+    if ( num_threads > ypts ) num_threads = static_cast<unsigned>(ypts);
+    // rows are handed out by the atomic counter, so if a thread cannot be
+    // started the ones already running (and this one) do its share
+    run_threads(static_cast<int>(num_threads), worker);
+
+    return 0;
+}
+
+} // namespace ngpt
+
+#endif
@@ -0,0 +1,175 @@
+#include "grid.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+///
+/// Benchmark for data_grid2d::interpolate.
+///
+/// For both storage types (grid_storage_type::rm_bl and rm_tl), a range of
+/// grid sizes (from a few KB up to a max size given on the command line) and
+/// three query patterns:
+///   - seq:       queries sweep the grid in storage order,
+///   - random:    queries uniformly distributed over the grid,
+///   - clustered: groups of queries within a few cells of a random centre,
+/// the benchmark runs a number of warm-up and timed repetitions over a
+/// (pre-generated) batch of queries and reports per-query statistics.
+///
+/// Output is CSV (one line per case) on stdout, with a header line:
+///   storage,grid_bytes,pattern,queries,reps,ns_min,ns_median,ns_mean,ns_stddev,gbps
+/// where ns_* are nanoseconds per query and gbps is the effective bandwidth,
+/// i.e. the bytes of the 4 cell nodes read per query, at the median time.
+///
+/// Usage: bench_grid [MAX_BYTES [QUERIES [REPS]]]
+///   MAX_BYTES may have a K, M or G suffix (default 256M; e.g. 4G).
+///   QUERIES is the number of queries per repetition (default 1048576).
+///   REPS is the number of timed repetitions (default 10; plus 2 warm-up).
+///
+
+using ngpt::data_grid2d;
+using ngpt::grid_storage_type;
+
+using Clock = std::chrono::steady_clock;
+
+/// Keep the compiler from optimizing away the computation of a value.
+template<typename T>
+    inline void
+    do_not_optimize(const T& val) noexcept
+{ asm volatile("" : : "r,m"(val) : "memory"); }
+
+/// Parse a size with an optional K/M/G suffix.
+std::size_t
+parse_size(const char* str) noexcept
+{
+    char* end;
+    double val = std::strtod(str, &end);
+    switch (*end) {
+        case 'G': case 'g': val *= 1024e0;
+        [[fallthrough]];
+        case 'M': case 'm': val *= 1024e0;
+        [[fallthrough]];
+        case 'K': case 'k': val *= 1024e0;
+    }
+    return static_cast<std::size_t>(val);
+}
+
+enum class pattern : char { seq, random, clustered };
+
+const char*
+pattern_str(pattern p) noexcept
+{
+    switch (p) {
+        case pattern::seq:    return "seq";
+        case pattern::random: return "random";
+        default:              return "clustered";
+    }
+}
+
+/// Generate n query points (x,y) on a global grid with k cells along the
+/// x-axis ([-180,180]) and k/2 along the y-axis ([-90,90]).
+void
+make_queries(pattern p, std::size_t k, std::size_t n, std::mt19937& eng,
+    std::vector<double>& x, std::vector<double>& y)
+{
+    const double step = 360e0 / k;
+    const std::size_t kx = k, ky = k/2;
+    std::uniform_real_distribution<double> unit(0e0, 1e0);
+    x.resize(n);
+    y.resize(n);
+    switch (p) {
+        case pattern::seq:
+            // visit cells in storage (row-major) order, wrapping around
+            for (std::size_t i = 0; i < n; i++) {
+                std::size_t cell = i % (kx*ky);
+                x[i] = -180e0 + (cell % kx + unit(eng)) * step;
+                y[i] =  -90e0 + (cell / kx + unit(eng)) * step;
+            }
+            break;
+        case pattern::random:
+            for (std::size_t i = 0; i < n; i++) {
+                x[i] = -180e0 + unit(eng) * (360e0 - 1e-9);
+                y[i] =  -90e0 + unit(eng) * (180e0 - 1e-9);
+            }
+            break;
+        case pattern::clustered:
+            // clusters of 64 queries, within +/- 2 cells of a random centre
+            for (std::size_t i = 0; i < n; i += 64) {
+                double cx = -180e0 + (2e0 + unit(eng)*(kx-4e0)) * step,
+                       cy =  -90e0 + (2e0 + unit(eng)*(ky-4e0)) * step;
+                for (std::size_t j = i; j < std::min(n, i+64); j++) {
+                    x[j] = cx + (unit(eng)*4e0 - 2e0) * step;
+                    y[j] = cy + (unit(eng)*4e0 - 2e0) * step;
+                }
+            }
+            break;
+    }
+}
+
+template<grid_storage_type G>
+    void
+    run(const char* gname, std::size_t bytes, std::size_t nq, int reps,
+        std::mt19937& eng)
+{
+    // number of cells along the x-axis; k*(k/2) nodes ~ bytes/8
+    std::size_t k = static_cast<std::size_t>(std::sqrt(2e0*bytes/sizeof(double)));
+    k = std::max<std::size_t>(k & ~std::size_t(1), 8);
+    const double step = 360e0 / k;
+    data_grid2d<double, double, G> g(-180e0, 180e0, step, -90e0, 90e0, step);
+    std::vector<double> data(g.num_pts());
+    for (auto& d : data) d = eng() * 1e-9;
+    g.data() = data.data();
+
+    std::vector<double> x, y, times(reps);
+    for (pattern p : {pattern::seq, pattern::random, pattern::clustered}) {
+        make_queries(p, k, nq, eng, x, y);
+        for (int r = -2; r < reps; r++) {
+            auto start = Clock::now();
+            double sum = 0e0;
+            for (std::size_t i = 0; i < nq; i++) {
+                sum += g.interpolate(x[i], y[i]);
+            }
+            do_not_optimize(sum);
+            auto stop = Clock::now();
+            // negative reps are warm-up
+            if (r >= 0) times[r] = std::chrono::duration<double, std::nano>(stop-start).count() / nq;
+        }
+        std::sort(times.begin(), times.end());
+        double mean = 0e0, var = 0e0;
+        for (double t : times) mean += t;
+        mean /= reps;
+        for (double t : times) var += (t-mean)*(t-mean);
+        double stddev = reps > 1 ? std::sqrt(var/(reps-1)) : 0e0;
+        double median = (reps % 2) ? times[reps/2]
+                                   : (times[reps/2-1] + times[reps/2]) / 2e0;
+        double gbps = 4e0 * sizeof(double) / median;
+        std::printf("%s,%zu,%s,%zu,%d,%.3f,%.3f,%.3f,%.3f,%.3f\n", gname,
+            data.size()*sizeof(double), pattern_str(p), nq, reps, times[0],
+            median, mean, stddev, gbps);
+        std::fflush(stdout);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t max_bytes = (argc > 1) ? parse_size(argv[1]) : (256u << 20);
+    std::size_t nq        = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : (1u << 20);
+    int         reps      = (argc > 3) ? std::atoi(argv[3]) : 10;
+    if ( !nq || reps < 1 ) {
+        std::fprintf(stderr, "Usage: %s [MAX_BYTES [QUERIES [REPS]]]\n", argv[0]);
+        return 1;
+    }
+
+    std::mt19937 eng(42);
+    std::printf("storage,grid_bytes,pattern,queries,reps,ns_min,ns_median,"
+                "ns_mean,ns_stddev,gbps\n");
+    for (std::size_t bytes = 16u << 10; bytes <= max_bytes; bytes *= 16) {
+        run<grid_storage_type::rm_bl>("rm_bl", bytes, nq, reps, eng);
+        run<grid_storage_type::rm_tl>("rm_tl", bytes, nq, reps, eng);
+    }
+
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include "antex_index.hpp"
+#include <iostream>
+#include <cstdio>
+#include <cassert>
+#include <cmath>
+
+using ngpt::antex_index;
+using ngpt::antex_pcv;
+
+// A (shortened) ANTEX file, holding a receiver antenna with azimouth-
+// dependent pcv, a receiver antenna with only NOAZI values and two blocks of
+// the same satellite antenna.
+const char* atx =
+"     1.4            M                                       ANTEX VERSION / SYST\n"
+"A                                                           PCV TYPE / REFANT   \n"
+"                                                            END OF HEADER       \n"
+"                                                            START OF ANTENNA    \n"
+"LEIATX1230+GNSS NONE                                        TYPE / SERIAL NO    \n"
+"   180.0                                                    DAZI                \n"
+"     0.0  90.0  45.0                                        ZEN1 / ZEN2 / DZEN  \n"
+"     2                                                      # OF FREQUENCIES    \n"
+"   G01                                                      START OF FREQUENCY  \n"
+"      0.49      0.07     66.22                              NORTH / EAST / UP   \n"
+"   NOAZI    0.00   -0.50    1.00\n"
+"     0.0    0.00   -0.40    1.10\n"
+"   180.0    0.10   -0.60    0.90\n"
+"   360.0    0.00   -0.40    1.10\n"
+"   G01                                                      END OF FREQUENCY    \n"
+"   G02                                                      START OF FREQUENCY  \n"
+"     -0.15      0.76     64.92                              NORTH / EAST / UP   \n"
+"   NOAZI    0.00   -0.20    2.00\n"
+"     0.0    0.00   -0.20    2.00\n"
+"   180.0    0.00   -0.20    2.00\n"
+"   360.0    0.00   -0.20    2.00\n"
+"   G02                                                      END OF FREQUENCY    \n"
+"                                                            END OF ANTENNA      \n"
+"                                                            START OF ANTENNA    \n"
+"TRM59800.00     SCIS                                        TYPE / SERIAL NO    \n"
+"     0.0                                                    DAZI                \n"
+"     0.0  90.0  30.0                                        ZEN1 / ZEN2 / DZEN  \n"
+"   G01                                                      START OF FREQUENCY  \n"
+"      1.00      2.00     90.00                              NORTH / EAST / UP   \n"
+"   NOAZI    0.00    1.00    2.00    3.00\n"
+"   G01                                                      END OF FREQUENCY    \n"
+"                                                            END OF ANTENNA      \n"
+"                                                            START OF ANTENNA    \n"
+"BLOCK IIR-M         G05                 G050      2005-052A TYPE / SERIAL NO    \n"
+"                                                            END OF ANTENNA      \n"
+"                                                            START OF ANTENNA    \n"
+"BLOCK IIR-M         G05                 G050      2005-052A TYPE / SERIAL NO    \n"
+"                                                            END OF ANTENNA      \n";
+
+int main()
+{
+    const char* path = "test_antex_index.atx";
+    std::FILE* fp = std::fopen(path, "w");
+    std::fputs(atx, fp);
+    std::fclose(fp);
+
+    antex_index idx;
+    int rc = idx.build(path);
+    assert( !rc );
+    assert( idx.size() == 4 );
+
+    // lookups
+    assert( idx.find("NOSUCHANTENNA   NONE") == nullptr );
+    auto e = idx.find("LEIATX1230+GNSS NONE");
+    assert( e && e->type == "LEIATX1230+GNSS NONE" && e->serial.empty() );
+    assert( idx.find("TRM59800.00     SCIS    ") );
+    auto s = idx.find("BLOCK IIR-M", "G05");
+    assert( s && s->next != antex_index::npos );
+    assert( idx.entries()[s->next].next == antex_index::npos );
+
+    // parse the pcv grids
+    antex_pcv pcv;
+    rc = idx.load(*e, pcv);
+    assert( !rc );
+    assert( pcv.freqs.size() == 2 && pcv.freqs[1].freq == "G02" );
+    assert( pcv.freqs[0].neu[2] == 66.22 );
+    auto g = pcv.grid(0);
+    assert( g.xpts() == 3 && g.ypts() == 3 );
+    assert( g.at(1, 0) == 0.10 && g.at(1, 1) == -0.60 && g.at(2, 2) == 1.10 );
+    assert( std::abs(g.interpolate(90e0, 45e0) - (-0.50)) < 1e-12 );
+
+    // NOAZI-only antenna
+    rc = idx.load(*idx.find("TRM59800.00     SCIS"), pcv);
+    assert( !rc );
+    assert( pcv.freqs.size() == 1 );
+    g = pcv.grid(0);
+    assert( std::abs(g.interpolate(123e0, 75e0) - 2.5) < 1e-12 );
+
+    // satellite block without frequencies is malformed
+    rc = idx.load(*s, pcv);
+    assert( rc );
+
+    std::remove(path);
+    std::cout<<"\nAntex index checked ("<<idx.size()<<" antennas).\n";
+    return 0;
+}
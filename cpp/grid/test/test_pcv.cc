@@ -0,0 +1,76 @@
+#include "pcv.hpp"
+#include <iostream>
+#include <random>
+#include <cassert>
+#include <vector>
+
+using ngpt::data_grid2d;
+using ngpt::grid_storage_type;
+using ngpt::pcv_corrector;
+
+typedef data_grid2d<double, double, grid_storage_type::rm_bl> pcv_grid;
+
+// A pcv pattern that bilinear interpolation reproduces exactly.
+double
+pattern(int ant, int frq, double azi, double zen)
+{ return (ant+1)*0.01*azi - (frq+1)*0.02*zen; }
+
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+    std::uniform_real_distribution<double> distr(0e0, 1e0);
+
+    const int num_ants = 3,
+              num_frqs = 2;
+    std::vector<pcv_grid>            grids;
+    std::vector<std::vector<double>> data(num_ants*num_frqs);
+    for (int i = 0; i < num_ants*num_frqs; i++) grids.emplace_back(0, 360, 5, 0, 90, 5);
+
+    pcv_corrector<double, double, grid_storage_type::rm_bl> pcv(num_frqs);
+    for (int a = 0; a < num_ants; a++) {
+        const pcv_grid* ptrs[num_frqs];
+        for (int f = 0; f < num_frqs; f++) {
+            pcv_grid& g = grids[a*num_frqs+f];
+            data[a*num_frqs+f].resize(g.num_pts());
+            g.data() = data[a*num_frqs+f].data();
+            for (std::size_t y = 0; y < g.ypts(); y++)
+                for (std::size_t x = 0; x < g.xpts(); x++)
+                    g.at(x, y) = pattern(a, f, x*5e0, y*5e0);
+            ptrs[f] = &g;
+        }
+        const std::size_t id = pcv.add_antenna(ptrs);
+        assert( id == (std::size_t)a );
+    }
+    assert( pcv.num_antennas() == num_ants );
+
+    // a batch of random queries
+    const std::size_t n = 500;
+    std::vector<std::size_t> ant(n), frq(n);
+    std::vector<double> azi(n), zen(n), enu(3*n), res(n);
+    for (std::size_t i = 0; i < n; i++) {
+        ant[i] = eng() % num_ants;
+        frq[i] = eng() % num_frqs;
+        azi[i] = distr(eng) * 360e0;
+        zen[i] = distr(eng) * 90e0;
+    }
+    pcv.correct(ant.data(), frq.data(), azi.data(), zen.data(), res.data(), n);
+    for (std::size_t i = 0; i < n; i++) {
+        assert( std::abs(res[i]-pattern(ant[i], frq[i], azi[i], zen[i])) < 1e-9 );
+    }
+
+    // same queries, as line-of-sight vectors
+    const double d2r = 3.14159265358979323846 / 180e0;
+    for (std::size_t i = 0; i < n; i++) {
+        enu[3*i]   = std::sin(zen[i]*d2r) * std::sin(azi[i]*d2r) * 2e7;
+        enu[3*i+1] = std::sin(zen[i]*d2r) * std::cos(azi[i]*d2r) * 2e7;
+        enu[3*i+2] = std::cos(zen[i]*d2r) * 2e7;
+    }
+    pcv.correct_los(ant.data(), frq.data(), enu.data(), res.data(), n);
+    for (std::size_t i = 0; i < n; i++) {
+        assert( std::abs(res[i]-pattern(ant[i], frq[i], azi[i], zen[i])) < 1e-6 );
+    }
+
+    std::cout<<"\nAll "<<n<<" pcv corrections checked.\n";
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include "pcv_json.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using ngpt::data_grid2d;
+using ngpt::grid_storage_type;
+using ngpt::pcv_json_header;
+using ngpt::pcv_json_job;
+
+using pcv_grid = data_grid2d<double, double, grid_storage_type::rm_bl>;
+
+// When set, allocations of a pcv_json_writer buffer (or larger) fail; set
+// before the export threads are started, so no further synchronization.
+static bool fail_big_allocs = false;
+
+void*
+operator new(std::size_t size)
+{
+    if ( fail_big_allocs && size >= (1<<16) ) throw std::bad_alloc();
+    if ( void* p = std::malloc(size ? size : 1) ) return p;
+    throw std::bad_alloc();
+}
+
+// (not inlined: GCC would then warn of free() on memory from operator new)
+[[gnu::noinline]] void
+operator delete(void* p) noexcept
+{ std::free(p); }
+
+[[gnu::noinline]] void
+operator delete(void* p, std::size_t) noexcept
+{ std::free(p); }
+
+// A new (empty) temporary file; its name.
+static std::string
+temp_path()
+{
+    char path[] = "/tmp/test_pcv_json_XXXXXX";
+    const int fd = mkstemp(path);
+    assert( fd >= 0 );
+    close(fd);
+    return path;
+}
+
+static std::string
+read_file(const std::string& path)
+{
+    std::ifstream fin(path);
+    std::stringstream ss;
+    ss << fin.rdbuf();
+    return ss.str();
+}
+
+int main()
+{
+    // A tiny pcv grid; x-axis is azimouth [0, 360, 180], y-axis is zenith
+    // [0, 90, 45].
+    pcv_grid g(0, 360, 180, 0, 90, 45);
+    std::vector<double> data(g.num_pts());
+    g.data() = data.data();
+    for (std::size_t y = 0; y < g.ypts(); y++)
+        for (std::size_t x = 0; x < g.xpts(); x++)
+            g.at(x, y) = y*0.25 - x*1.5;
+
+    pcv_json_header hdr {"foo.atx", "LEIATX1230+GNSS NONE", "", "azi"};
+    ngpt::pcv_json_writer writer;
+    const std::string single = temp_path();
+    int rc = writer.write(single.c_str(), hdr, g);
+    assert( !rc );
+
+    const char expected[] =
+        "{\n"
+        "  \"antex\": \"foo.atx\",\n"
+        "  \"master_antenna\": \"LEIATX1230+GNSS NONE\",\n"
+        "  \"slave_antenna\": \"\",\n"
+        "  \"type\": \"azi\",\n"
+        "  \"zenith_range\": [0, 90, 45],\n"
+        "  \"azimouth_range\": [0, 360, 180],\n"
+        "  \"pcv_values\": [\n"
+        "[0, -1.5, -3],\n"
+        "[0.25, -1.25, -2.75],\n"
+        "[0.5, -1, -2.5]]\n"
+        "}\n";
+    const std::string out = read_file(single);
+    std::cout << out;
+    assert( out == expected );
+    std::remove(single.c_str());
+
+    // export a number of antennas (each with its own grid values) in
+    // parallel; every file must be what a single writer produces for the
+    // same grid
+    const int nant = 16;
+    std::vector<pcv_grid> grids(nant, g);
+    std::vector<std::vector<double>> values(nant, data);
+    std::vector<pcv_json_job<double, double, grid_storage_type::rm_bl>> jobs;
+    for (int i = 0; i < nant; i++) {
+        grids[i].data() = values[i].data();
+        for (auto& v : values[i]) v = v*(i+1) + 0.125*i;
+        jobs.push_back({temp_path(), hdr, &grids[i]});
+    }
+    std::size_t nfailed = ngpt::export_pcv_json(jobs.data(), jobs.size(), 4);
+    assert( !nfailed );
+
+    // no thread can allocate its writer: every job fails, nothing throws
+    fail_big_allocs = true;
+    nfailed = ngpt::export_pcv_json(jobs.data(), jobs.size(), 4);
+    fail_big_allocs = false;
+    assert( nfailed == jobs.size() );
+
+    for (int i = 0; i < nant; i++) {
+        const std::string ref = temp_path();
+        rc = writer.write(ref.c_str(), hdr, grids[i]);
+        assert( !rc );
+        assert( read_file(jobs[i].path) == read_file(ref) );
+        std::remove(ref.c_str());
+        std::remove(jobs[i].path.c_str());
+    }
+
+    std::cout<<"\n";
+    return 0;
+}
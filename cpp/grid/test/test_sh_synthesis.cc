@@ -0,0 +1,77 @@
+#include "sh_synthesis.hpp"
+#include <iostream>
+#include <random>
+#include <cassert>
+#include <chrono>
+#include <vector>
+
+using ngpt::data_grid2d;
+using ngpt::grid_storage_type;
+using ngpt::sh_index;
+
+// Direct (node by node) evaluation of the expansion, via the (unnormalized)
+// std::assoc_legendre.
+double
+direct(const double* C, const double* S, int nmax, double lat, double lon)
+{
+    const double d2r = 3.14159265358979323846 / 180e0;
+    double t = std::sin(lat*d2r), f = 0e0;
+    for (int n = 0; n <= nmax; n++) {
+        for (int m = 0; m <= n; m++) {
+            double norm = std::sqrt((m ? 2e0 : 1e0) * (2*n+1)
+                          * std::tgamma(n-m+1) / std::tgamma(n+m+1));
+            double p = norm * std::assoc_legendre(n, m, t);
+            f += p * (C[sh_index(n,m)]*std::cos(m*lon*d2r)
+                    + S[sh_index(n,m)]*std::sin(m*lon*d2r));
+        }
+    }
+    return f;
+}
+
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+    std::uniform_real_distribution<double> distr(-1e0, 1e0);
+
+    // random coefficients, degree 20
+    int nmax = 20;
+    std::vector<double> C(sh_index(nmax+1,0)), S(C.size());
+    for (int n = 0; n <= nmax; n++) {
+        for (int m = 0; m <= n; m++) {
+            C[sh_index(n,m)] = distr(eng) / (n+1);
+            S[sh_index(n,m)] = m ? distr(eng) / (n+1) : 0e0;
+        }
+    }
+
+    data_grid2d<double, double, grid_storage_type::rm_tl> g(-180, 180, 10, 90, -90, -10);
+    std::vector<double> data(g.num_pts());
+    g.data() = data.data();
+    int rc = ngpt::sh_synthesis(C.data(), S.data(), nmax, g, 4);
+    assert( !rc );
+    for (std::size_t j = 0; j < g.ypts(); j++) {
+        for (std::size_t i = 0; i < g.xpts(); i++) {
+            double f = direct(C.data(), S.data(), nmax, 90e0-10e0*j, -180e0+10e0*i);
+            assert( std::abs(g.at(i, j) - f) < 1e-10 );
+        }
+    }
+    std::cout<<"\nSynthesis checked against direct evaluation (nmax="<<nmax<<").";
+
+    // timing at high degree
+    nmax = 360;
+    C.assign(sh_index(nmax+1,0), 0e0);
+    S.assign(C.size(), 0e0);
+    for (auto& c : C) c = distr(eng) * 1e-6;
+    C[0] = 1e0;
+    data_grid2d<double, double, grid_storage_type::rm_bl> h(0, 360, .5, -90, 90, .5);
+    data.resize(h.num_pts());
+    h.data() = data.data();
+    auto start = std::chrono::steady_clock::now();
+    rc = ngpt::sh_synthesis(C.data(), S.data(), nmax, h);
+    auto stop = std::chrono::steady_clock::now();
+    assert( !rc );
+    std::cout<<"\nSynthesis of degree "<<nmax<<" on a "<<h.ypts()<<"x"<<h.xpts()
+        <<" grid: "<<std::chrono::duration_cast<std::chrono::milliseconds>(stop-start).count()
+        <<" ms\n";
+    return 0;
+}
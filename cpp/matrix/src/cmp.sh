@@ -1,4 +1,26 @@
 #! /bin/bash
-g++ -Wall -std=c++14 -DDEBUG -c -o qr.o qr.cpp
+g++ -Wall -std=c++14 -DDEBUG -pthread -c -o qr.o qr.cpp
 # g++ -Wall -std=c++14 -DDEBUG test_qr.cpp qr.o
-g++ -Wall -std=c++14 -DDEBUG test_times.cc qr.o
+g++ -Wall -std=c++14 -DDEBUG -pthread -c -o tiled_qr.o tiled_qr.cpp
+g++ -Wall -std=c++14 -DDEBUG -pthread -c -o tsqr.o tsqr.cpp
+g++ -Wall -std=c++14 -DDEBUG -pthread -c -o lu.o lu.cpp
+g++ -Wall -std=c++14 -DDEBUG -pthread test_times.cc qr.o tiled_qr.o tsqr.o lu.o
+# g++ -Wall -std=c++14 -DDEBUG test_qr_blocked.cpp qr.o
+# g++ -Wall -std=c++14 -DDEBUG -pthread test_tiled_qr.cpp qr.o tiled_qr.o
+# g++ -Wall -std=c++14 -DDEBUG -pthread test_tsqr.cpp qr.o tsqr.o
+# g++ -Wall -std=c++14 -DDEBUG -pthread test_updatable_qr.cpp updatable_qr.cpp qr_covariance.cpp
+# g++ -Wall -std=c++14 -DDEBUG test_qr_pivot.cpp qr.o
+# g++ -Wall -std=c++14 -DDEBUG test_qr_multi.cpp qr.o
+# g++ -Wall -std=c++14 -O3 -march=native -DDEBUG test_qr_batched.cpp qr.o
+# g++ -Wall -std=c++14 -DDEBUG test_qr_fixed.cpp qr.o
+# g++ -Wall -std=c++14 -DDEBUG test_qr_workspace.cpp qr.o
+# g++ -Wall -std=c++14 -DDEBUG -pthread test_qr_operator.cpp qr.o qr_operator.cpp
+# g++ -Wall -std=c++14 -O3 -march=native -DDEBUG test_qr_mixed.cpp qr.o qr_mixed.cpp
+# g++ -Wall -std=c++14 -DDEBUG -pthread test_qr_covariance.cpp qr.o qr_covariance.cpp
+# g++ -Wall -std=c++14 -DDEBUG -pthread test_triangular_solve.cpp qr.o
+# g++ -Wall -std=c++14 -DDEBUG -pthread test_lu.cpp qr.o lu.o
+# g++ -Wall -std=c++14 -DDEBUG test_matrix_view.cpp qr.o
+# g++ -Wall -std=c++14 -DDEBUG test_qr_robust.cpp qr.o qr_robust.cpp
+# g++ -Wall -std=c++14 -DDEBUG -pthread test_srif.cpp qr.o srif.cpp qr_covariance.cpp
+# g++ -Wall -std=c++14 -DDEBUG -pthread test_qr_ooc.cpp qr.o qr_ooc.cpp
+# g++ -Wall -std=c++14 -DDEBUG -pthread test_matrix_file.cpp qr.o qr_ooc.cpp matrix_file.cpp
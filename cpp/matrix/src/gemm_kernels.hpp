@@ -0,0 +1,148 @@
+#ifndef __GEMM_KERNELS_HPP__
+#define __GEMM_KERNELS_HPP__
+
+#include <algorithm>
+
+/// @brief Small matrix-matrix kernels, used to apply block reflectors
+///        \f$I - V T V^T\f$ (with V stored dense) to blocks of columns.
+///
+/// All matrices are stored column-wise, with explicit leading dimensions.
+
+/// @brief Compute \f$W \leftarrow W + V^T C\f$.
+///
+/// V is mr-by-kb, C is mr-by-nc and W is kb-by-nc, all column-wise with
+/// leading dimensions ldv, ldc and ldw. The dot products are accumulated in
+/// (2-wide) partial sums, two rows by four columns of W at a time, so that
+/// every element of V loaded is used four times and every element of C
+/// twice.
+inline void
+gemm_tn_acc(int mr, int kb, int nc, const double *__restrict__ v, int ldv,
+    const double *__restrict__ c, int ldc, double *__restrict__ w, int ldw)
+noexcept
+{
+    constexpr int vl = 2;
+    int q, j, l, r, ii;
+    for (j = 0; j < nc; j += 4) {
+        // for fewer than four columns left, the last one is repeated
+        const int nj = std::min(4, nc-j);
+        const double *__restrict__ c0 = c + j*ldc;
+        const double *__restrict__ c1 = c + (j+std::min(1, nj-1))*ldc;
+        const double *__restrict__ c2 = c + (j+std::min(2, nj-1))*ldc;
+        const double *__restrict__ c3 = c + (j+nj-1)*ldc;
+        for (q = 0; q < kb; q += 2) {
+            const int q1 = std::min(q+1, kb-1);
+            const double *__restrict__ v0 = v + q*ldv;
+            const double *__restrict__ v1 = v + q1*ldv;
+            double a[4][vl] = {{0e0}}, b[4][vl] = {{0e0}};
+            for (r = 0; r + vl <= mr; r += vl) {
+                for (ii = 0; ii < vl; ii++) {
+                    const double x0 = v0[r+ii], x1 = v1[r+ii];
+                    a[0][ii] += x0*c0[r+ii]; b[0][ii] += x1*c0[r+ii];
+                    a[1][ii] += x0*c1[r+ii]; b[1][ii] += x1*c1[r+ii];
+                    a[2][ii] += x0*c2[r+ii]; b[2][ii] += x1*c2[r+ii];
+                    a[3][ii] += x0*c3[r+ii]; b[3][ii] += x1*c3[r+ii];
+                }
+            }
+            const double *cl[4] = {c0, c1, c2, c3};
+            for (l = 0; l < nj; l++) {
+                double s0 = 0e0, s1 = 0e0;
+                for (ii = 0; ii < vl; ii++) {
+                    s0 += a[l][ii];
+                    s1 += b[l][ii];
+                }
+                for (int rr = r; rr < mr; rr++) {
+                    s0 += v0[rr]*cl[l][rr];
+                    s1 += v1[rr]*cl[l][rr];
+                }
+                w[(j+l)*ldw+q] += s0;
+                if (q1 > q) w[(j+l)*ldw+q1] += s1;
+            }
+        }
+    }
+}
+
+/// @brief Compute \f$C \leftarrow C - V W\f$.
+///
+/// V is mr-by-kb, W is kb-by-nc and C is mr-by-nc, all column-wise with
+/// leading dimensions ldv, ldw and ldc. Four columns of V are applied to two
+/// columns of C per sweep, so that every element loaded is used twice.
+inline void
+gemm_nn_sub(int mr, int kb, int nc, const double *__restrict__ v, int ldv,
+    const double *__restrict__ w, int ldw, double *__restrict__ c, int ldc)
+noexcept
+{
+    int q, j, r;
+    for (j = 0; j < nc; j += 2) {
+        const int j1 = std::min(j+1, nc-1);
+        double *__restrict__ c0 = c + j*ldc;
+        double *__restrict__ c1 = c + j1*ldc;
+        const double *__restrict__ w0 = w + j*ldw;
+        // for an odd number of columns, the last one is processed alone
+        const double *__restrict__ w1 = (j1 > j) ? (w + j1*ldw) : nullptr;
+        for (q = 0; q < kb; q += 4) {
+            const int nq = std::min(4, kb-q);
+            double a[4] = {0e0}, b[4] = {0e0};
+            const double *__restrict__ vq[4];
+            for (int l = 0; l < 4; l++) {
+                vq[l] = v + (q + std::min(l, nq-1))*ldv;
+                if (l < nq) {
+                    a[l] = w0[q+l];
+                    b[l] = w1 ? w1[q+l] : 0e0;
+                }
+            }
+            if (w1) {
+                for (r = 0; r < mr; r++) {
+                    const double x0 = vq[0][r], x1 = vq[1][r],
+                                 x2 = vq[2][r], x3 = vq[3][r];
+                    c0[r] -= x0*a[0] + x1*a[1] + x2*a[2] + x3*a[3];
+                    c1[r] -= x0*b[0] + x1*b[1] + x2*b[2] + x3*b[3];
+                }
+            } else {
+                for (r = 0; r < mr; r++) {
+                    c0[r] -= vq[0][r]*a[0] + vq[1][r]*a[1] + vq[2][r]*a[2]
+                           + vq[3][r]*a[3];
+                }
+            }
+        }
+    }
+}
+
+/// @brief Compute \f$W \leftarrow T^T W\f$, T kb-by-kb upper triangular.
+///
+/// W is kb-by-nc (column-wise, leading dimension ldw).
+inline void
+trmm_tn(int kb, int nc, const double *__restrict__ t, int ldt,
+    double *__restrict__ w, int ldw)
+noexcept
+{
+    double sum;
+    for (int j = 0; j < nc; j++) {
+        double *__restrict__ wj = w + j*ldw;
+        for (int i = kb-1; i >= 0; i--) {
+            sum = 0e0;
+            for (int r = 0; r <= i; r++) sum += t[i*ldt+r]*wj[r];
+            wj[i] = sum;
+        }
+    }
+}
+
+/// @brief Compute \f$W \leftarrow T W\f$, T kb-by-kb upper triangular.
+///
+/// W is kb-by-nc (column-wise, leading dimension ldw).
+inline void
+trmm_nn(int kb, int nc, const double *__restrict__ t, int ldt,
+    double *__restrict__ w, int ldw)
+noexcept
+{
+    double sum;
+    for (int j = 0; j < nc; j++) {
+        double *__restrict__ wj = w + j*ldw;
+        for (int i = 0; i < kb; i++) {
+            sum = 0e0;
+            for (int r = i; r < kb; r++) sum += t[r*ldt+i]*wj[r];
+            wj[i] = sum;
+        }
+    }
+}
+
+#endif
@@ -1,24 +1,198 @@
+#include <cmath>
+#include <algorithm>
+#include <new>
+#include <vector>
+#include "qr.hpp"
+#include "lu.hpp"
+#include "gemm_kernels.hpp"
+#include "run_threads.hpp"
+
 /// \brief LU decomposition of a square matrix.
 ///
 /// This function computes the LU decomposition of a square matrix, using an
 /// outer-product Gaussian elimination algorithm.
-/// Suppose \f$A \in \Re^{x\times n} \f$ has the property that \f$A(1:k, 1:k)\f$
+/// Suppose \f$A \in \Re^{n\times n} \f$ has the property that \f$A(1:k, 1:k)\f$
 /// is non-singular for \f$k=1:n-1\f$. This algorithm computes the factorization
-/// \f$M_{n-1}...M_{1}A=U\f$ where \f$U\f$ is upper triangular and each \fM_k \f$
+/// \f$M_{n-1}...M_{1}A=U\f$ where \f$U\f$ is upper triangular and each \f$M_k \f$
 /// is a Gauss transform. \f$U\f$ is stored in the upper triangle of A. The
 /// multipliers associated with \f$M_k \f$ are stored in
 /// \f$A(k+1:n,k), i.e., A(k+1:n,k)=-M_{k}(k:1:n,k)\f$.
 ///
-/// \param[in,out] a  The matrix A of size nxn at input; at output, its upper
-///                   triangle is overwritten by U.
+/// There is no pivoting; use lu_factor for a general (nonsingular) matrix.
+///
+/// \param[in,out] a  The matrix A of size nxn at input (column-wise); at
+///                   output, its upper triangle is overwritten by U and its
+///                   strictly lower triangle by the multipliers (i.e. by L,
+///                   with implicit unit diagonal).
 /// \param[in]     n  Dimension of A; A has size nxn.
 ///
+/// Reference: Matrix Computations, G.H. Colub, CF.V. Loan, 1996, pg. 98
 void
-square_lu(double *__restrict__ a, int n)
+square_lu(double *__restrict__ a, int n) noexcept
 {
     int k,i,j;
     for (k = 0; k < n-1; k++) {
-        for (i = k+1; i < n; i++) a[i*n+k] /= a[k*n+k];
+        double *__restrict__ ak = a + k*n;
+        for (i = k+1; i < n; i++) ak[i] /= ak[k];
         for (j = k+1; j < n; j++) {
+            double *__restrict__ aj = a + j*n;
+            const double t = aj[k];
+            for (i = k+1; i < n; i++) aj[i] -= ak[i]*t;
+        }
+    }
+    return;
+}
+
+/// Rows of the trailing matrix updated at a time (so that a chunk of
+/// \f$L_{21}\f$ stays in cache while all columns are updated).
+constexpr int lu_update_rows = 256;
+
+/// \brief Factor the panel A(j0:n, j0:j0+jb) with partial pivoting
+///        (unblocked, right-looking within the panel).
+///
+/// Row interchanges are applied to the panel columns only.
+/// \return 0, or 1 if a zero pivot was found.
+static int
+lu_panel(double *__restrict__ a, int n, int j0, int jb,
+    int *__restrict__ ipiv)
+noexcept
+{
+    int status = 0;
+    for (int k = j0; k < j0+jb; k++) {
+        double *__restrict__ ak = a + (long)k*n;
+        int p = k;
+        double amax = std::abs(ak[k]);
+        for (int i = k+1; i < n; i++) {
+            if (std::abs(ak[i]) > amax) {
+                amax = std::abs(ak[i]);
+                p = i;
+            }
+        }
+        ipiv[k] = p;
+        if (amax == 0e0) {
+            // singular; nothing to eliminate in this column
+            status = 1;
+            continue;
+        }
+        if (p != k) {
+            for (int j = j0; j < j0+jb; j++) std::swap(a[(long)j*n+k], a[(long)j*n+p]);
+        }
+        const double r = 1e0 / ak[k];
+        for (int i = k+1; i < n; i++) ak[i] *= r;
+        for (int j = k+1; j < j0+jb; j++) {
+            double *__restrict__ aj = a + (long)j*n;
+            const double t = aj[k];
+            for (int i = k+1; i < n; i++) aj[i] -= ak[i]*t;
+        }
+    }
+    return status;
+}
+
+/// Apply the row interchanges ipiv[k0:k1] to the columns c0:c1 of A
+/// (leading dimension lda).
+static void
+lu_swap_rows(double *__restrict__ a, int lda, int c0, int c1,
+    const int *__restrict__ ipiv, int k0, int k1)
+noexcept
+{
+    for (int j = c0; j < c1; j++) {
+        double *__restrict__ aj = a + (long)j*lda;
+        for (int k = k0; k < k1; k++) {
+            if (ipiv[k] != k) std::swap(aj[k], aj[ipiv[k]]);
+        }
+    }
+}
+
+/// \brief LU factorization with partial pivoting, blocked.
+///
+/// Compute \f$PA = LU\f$ (see lu.hpp). At output, the upper triangle of a
+/// holds U and its strictly lower triangle the multipliers (L, with
+/// implicit unit diagonal); ipiv holds the row interchanges.
+///
+/// The factorization is completed even if A is singular (in which case a
+/// solution with lu_solve would divide by zero).
+///
+/// \param[in,out] a           The nxn matrix A (column-wise); at output its
+///                            LU factorization.
+/// \param[in]     n           Dimension of A.
+/// \param[out]    ipiv        Array of size n; at output the pivot indexes.
+/// \param[in]     nb          Block size (columns per panel); if nb >= n the
+///                            unblocked algorithm is used.
+/// \param[in]     num_threads Number of threads for the trailing updates; if
+///                            <= 0, then std::thread::hardware_concurrency is
+///                            used.
+/// \return        0 on success, 1 if A is singular (U has a zero on its
+///                diagonal).
+///
+/// Reference: Matrix Computations, G.H. Colub, CF.V. Loan, 1996, pg. 116
+int
+lu_factor(double *__restrict__ a, int n, int *__restrict__ ipiv, int nb,
+    int num_threads)
+{
+    if (nb < 1 || nb >= n) return lu_panel(a, n, 0, n, ipiv);
+    num_threads = resolve_threads(num_threads);
+
+    int status = 0;
+    for (int j0 = 0; j0 < n; j0 += nb) {
+        const int jb = std::min(nb, n-j0), j1 = j0 + jb;
+        status |= lu_panel(a, n, j0, jb, ipiv);
 
+        // interchanges, left of the panel
+        lu_swap_rows(a, n, 0, j0, ipiv, j0, j1);
+        if (j1 == n) break;
+
+        // trailing columns, split among threads: interchanges,
+        // U12 = L11^{-1} A12 and A22 -= L21 U12
+        const int nc = n - j1, mr = n - j1;
+        const double *__restrict__ l11 = a + (long)j0*n + j0;
+        const double *__restrict__ l21 = a + (long)j0*n + j1;
+        auto update = [=](int c0, int c1) {
+            if (c0 >= c1) return;
+            lu_swap_rows(a, n, j1+c0, j1+c1, ipiv, j0, j1);
+            double *__restrict__ u12 = a + (long)(j1+c0)*n + j0;
+            double *__restrict__ a22 = a + (long)(j1+c0)*n + j1;
+            triangular_solve(false, true, l11, n, u12, n, jb, c1-c0);
+            for (int r0 = 0; r0 < mr; r0 += lu_update_rows) {
+                gemm_nn_sub(std::min(lu_update_rows, mr-r0), jb, c1-c0,
+                    l21 + r0, n, u12, n, a22 + r0, n);
+            }
+        };
+        // at least nb columns per thread
+        const int nt = std::max(1, std::min(num_threads, nc/nb));
+        if (nt == 1) {
+            update(0, nc);
+            continue;
+        }
+        // the calling thread does the first part, and any part whose thread
+        // could not be created
+        run_threads(nt, [=](int tid) {
+            update((long)nc*tid/nt, (long)nc*(tid+1)/nt);
+        });
+    }
+    return status;
+}
+
+/// \brief Solve \f$AX=B\f$, given the LU factorization of A.
+///
+/// Apply the row interchanges to B, then solve \f$LY=PB\f$ (forward) and
+/// \f$UX=Y\f$ (back substitution), with triangular_solve.
+///
+/// \param[in]     a           The LU factorization of A, as computed by
+///                            lu_factor.
+/// \param[in]     n           Dimension of A.
+/// \param[in]     ipiv        The pivot indexes, as computed by lu_factor.
+/// \param[in,out] b           The nxk matrix B (column-wise, leading
+///                            dimension ldb); at output the solution X.
+/// \param[in]     ldb         Leading dimension of b (\f$ldb \geq n\f$).
+/// \param[in]     k           Number of right-hand sides (columns of B).
+/// \param[in]     num_threads Number of threads (see triangular_solve).
+/// \return        0 on success, 1 if A is singular (B is then left
+///                permuted and partially solved).
+int
+lu_solve(const double *__restrict__ a, int n, const int *__restrict__ ipiv,
+    double *__restrict__ b, int ldb, int k, int num_threads)
+{
+    lu_swap_rows(b, ldb, 0, k, ipiv, 0, n);
+    triangular_solve(false, true, a, n, b, ldb, n, k, num_threads);
+    return triangular_solve(true, false, a, n, b, ldb, n, k, num_threads);
 }
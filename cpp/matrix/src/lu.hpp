@@ -0,0 +1,43 @@
+#ifndef __LU_HPP__
+#define __LU_HPP__
+
+/// \brief LU factorization of square matrices, and linear system solution.
+///
+/// The LU factorization with partial pivoting of \f$A\in\Re^{n\times n}\f$
+/// is \f$PA = LU\f$, where P is a permutation matrix, L is unit lower
+/// triangular (with all multipliers \f$|l_{ij}| \leq 1\f$) and U is upper
+/// triangular. It exists for any A; A is singular iff U has a zero diagonal
+/// element. Once A is factored, \f$Ax=b\f$ is solved for any number of
+/// right-hand sides by a row permutation and two triangular solves, in
+/// \f$O(n^2)\f$ per right-hand side (lu_factor costs \f$2n^3/3\f$ flops).
+///
+/// lu_factor is blocked and right-looking: for every block of nb columns,
+/// the panel is factored (with row interchanges over its full height), the
+/// interchanges are applied to the rest of the matrix, the block row of U
+/// is computed by a triangular solve, and the trailing matrix is updated by
+/// a matrix-matrix product \f$A_{22} \leftarrow A_{22} - L_{21} U_{12}\f$
+/// (which is most of the work). The trailing update, and the triangular
+/// solve that precedes it, are split by columns among num_threads threads.
+///
+/// The pivots are stored LAPACK-style (0-based): at step k, row k was
+/// interchanged with row ipiv[k] (\f$ipiv[k] \geq k\f$).
+///
+/// \note All matrices are stored in column-major form.
+///
+/// Reference: Matrix Computations, G.H. Colub, CF.V. Loan, 1996, ch. 3.2,
+///            3.4
+///
+/// \example test_lu.cpp
+
+void
+square_lu(double *__restrict__ a, int n) noexcept;
+
+int
+lu_factor(double *__restrict__ a, int n, int *__restrict__ ipiv, int nb = 64,
+    int num_threads = 1);
+
+int
+lu_solve(const double *__restrict__ a, int n, const int *__restrict__ ipiv,
+    double *__restrict__ b, int ldb, int k, int num_threads = 1);
+
+#endif
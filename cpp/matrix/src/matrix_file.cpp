@@ -0,0 +1,262 @@
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "matrix_file.hpp"
+
+/// Byte offset of the payload: the header, rounded up to matrix_alignment.
+static constexpr long payload_offset =
+    (sizeof(matrix_file_header) + matrix_alignment - 1)
+    / matrix_alignment * matrix_alignment;
+
+/// Elements per (row-major) chunk of the gather buffer.
+static constexpr long gather_size = 8192;
+
+/// Write size bytes of buf at byte offset off of fd (pwrite, retried on
+/// short writes and EINTR).
+/// @return 0 on success, 1 on I/O error.
+static int
+write_fully(int fd, long off, const char *buf, long size) noexcept
+{
+    while (size > 0) {
+        const ssize_t put = pwrite(fd, buf, size, off);
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) return 1;
+        buf  += put;
+        off  += put;
+        size -= put;
+    }
+    return 0;
+}
+
+static void
+fill_header(matrix_file_header &h, long rows, long cols, long ld,
+    matrix_layout layout) noexcept
+{
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, matrix_file_magic, sizeof(h.magic));
+    h.byte_order = matrix_file_byte_order;
+    h.version    = matrix_file_version;
+    h.dtype      = static_cast<std::uint8_t>(matrix_dtype::float64);
+    h.layout     = layout == matrix_layout::row_major;
+    h.rows       = rows;
+    h.cols       = cols;
+    h.ld         = ld;
+    h.payload    = payload_offset;
+}
+
+mapped_matrix::mapped_matrix(mapped_matrix &&o) noexcept
+: _map(o._map), _size(o._size), _data(o._data), _rows(o._rows),
+  _cols(o._cols), _ld(o._ld), _payload(o._payload), _layout(o._layout)
+{
+    o._map  = nullptr;
+    o._data = nullptr;
+    o._size = 0;
+}
+
+mapped_matrix&
+mapped_matrix::operator=(mapped_matrix &&o) noexcept
+{
+    std::swap(_map, o._map);
+    std::swap(_size, o._size);
+    std::swap(_data, o._data);
+    std::swap(_rows, o._rows);
+    std::swap(_cols, o._cols);
+    std::swap(_ld, o._ld);
+    std::swap(_payload, o._payload);
+    std::swap(_layout, o._layout);
+    return *this;
+}
+
+/// @brief Map the matrix file path.
+///
+/// The header is checked (magic, byte order, version, element type,
+/// dimensions against the size of the file) and the whole file is mapped
+/// private and writable: the payload is not read until it is accessed, and
+/// pages written through a view are copied, never written back. A file
+/// already open is closed first.
+///
+/// @param[in] path Matrix file.
+/// @return    0 on success, 1 if the file cannot be opened or mapped, or is
+///            not a valid matrix file.
+int
+mapped_matrix::open(const char *path) noexcept
+{
+    close();
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return 1;
+
+    matrix_file_header h;
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && pread(fd, &h, sizeof(h), 0) == sizeof(h);
+    if (ok) {
+        const long outer = h.layout ? h.rows : h.cols,
+                   inner = h.layout ? h.cols : h.rows;
+        ok = !std::memcmp(h.magic, matrix_file_magic, sizeof(h.magic))
+             && h.byte_order == matrix_file_byte_order
+             && h.version == matrix_file_version
+             && h.dtype == static_cast<std::uint8_t>(matrix_dtype::float64)
+             && h.layout <= 1 && h.rows >= 0 && h.cols >= 0 && h.ld >= inner
+             && h.payload >= (long)sizeof(h)
+             && h.payload % matrix_alignment == 0 && h.payload <= st.st_size
+             && (h.ld == 0 || outer <= (st.st_size - h.payload)
+                                       / (long)sizeof(double) / h.ld);
+    }
+    if (ok) {
+        _map = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+            fd, 0);
+        ok = _map != MAP_FAILED;
+        if (!ok) _map = nullptr;
+    }
+    ::close(fd);
+    if (!ok) return 1;
+
+    _size    = st.st_size;
+    _data    = reinterpret_cast<double*>(static_cast<char*>(_map) + h.payload);
+    _rows    = h.rows;
+    _cols    = h.cols;
+    _ld      = h.ld;
+    _payload = h.payload;
+    _layout  = h.layout ? matrix_layout::row_major : matrix_layout::col_major;
+    return 0;
+}
+
+/// Unmap the file (views of it become invalid).
+void
+mapped_matrix::close() noexcept
+{
+    if (_map) munmap(_map, _size);
+    _map  = nullptr;
+    _data = nullptr;
+    _size = 0;
+    _rows = _cols = _ld = _payload = 0;
+}
+
+/// @brief Create (or truncate) the matrix file path, for writing.
+///
+/// @param[in] path   Matrix file.
+/// @param[in] cols   Number of columns.
+/// @param[in] layout Layout of the file.
+/// @param[in] rows   Number of rows: required (> 0) for a column-major
+///                   file; for a row-major one, 0 if unknown, else close()
+///                   checks that exactly rows rows were appended.
+/// @return    0 on success, 1 on invalid sizes (including rows or cols
+///            above INT_MAX, which mapped_matrix could not view), I/O or
+///            allocation error.
+int
+matrix_file_writer::open(const char *path, long cols, matrix_layout layout,
+    long rows) noexcept
+{
+    close();
+    const bool row_major = layout == matrix_layout::row_major;
+    if (cols < 1 || rows < 0 || (!row_major && rows < 1)) return 1;
+    if (cols > INT32_MAX || rows > INT32_MAX) return 1;
+    // padding never takes the leading dimension above INT_MAX
+    if (!row_major && rows > INT32_MAX - matrix_alignment) return 1;
+    _ld = row_major ? cols : aligned_matrix<double>::padded_ld(rows);
+    try {
+        _buf.resize(std::max(gather_size, row_major ? cols : 0));
+    } catch (std::bad_alloc&) {
+        return 1;
+    }
+    _fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (_fd < 0) return 1;
+    _rows   = rows;
+    _cols   = cols;
+    _count  = 0;
+    _status = 0;
+    _layout = layout;
+
+    matrix_file_header h;
+    fill_header(h, rows, cols, _ld, layout);
+    if (write_fully(_fd, 0, reinterpret_cast<const char*>(&h), sizeof(h)))
+        _status = 1;
+    // a column-major file has its full size from the start (the padding
+    // and the rows not yet written read as zeros)
+    if (!row_major
+        && ftruncate(_fd, payload_offset + _ld*cols*(long)sizeof(double)))
+        _status = 1;
+    return _status;
+}
+
+/// Write count doubles from p at element offset off of the payload.
+int
+matrix_file_writer::write_at(long off, const double *p, long count) noexcept
+{
+    return write_fully(_fd, payload_offset + off*(long)sizeof(double),
+        reinterpret_cast<const char*>(p), count*(long)sizeof(double));
+}
+
+/// @brief Append the k rows of the k-by-n block a (layout l, leading
+/// dimension lda); n must be the number of columns of the file, and the
+/// file can hold at most INT32_MAX rows (a matrix_view could not map more).
+/// @return 0 on success, 1 on invalid sizes or I/O error (after which the
+///         file is incomplete, and close() fails).
+int
+matrix_file_writer::append_rows(const double *a, int k, long n, int lda,
+    matrix_layout l) noexcept
+{
+    if (_fd < 0 || _status || n != _cols || k < 0
+        || (_rows && _count + k > _rows) || _count + k > INT32_MAX) return 1;
+    if (k == 0) return 0;
+    const bool row_block = l == matrix_layout::row_major;
+    double *__restrict__ buf = _buf.data();
+
+    if (_layout == matrix_layout::row_major) {
+        if (row_block && lda == n) {
+            _status = write_at(_count*n, a, k*n);
+        } else {
+            // gather whole rows into the buffer
+            const long chunk = (long)_buf.size() / n;
+            for (long i0 = 0; i0 < k && !_status; i0 += chunk) {
+                const long kb = std::min<long>(chunk, k-i0);
+                for (long i = 0; i < kb; i++) {
+                    for (long j = 0; j < n; j++) {
+                        buf[i*n+j] = row_block ? a[(i0+i)*lda+j]
+                                               : a[j*lda+i0+i];
+                    }
+                }
+                _status = write_at((_count+i0)*n, buf, kb*n);
+            }
+        }
+    } else {
+        // one write per column (and buffer load, if the block is row-major)
+        const long chunk = (long)_buf.size();
+        for (long j = 0; j < n && !_status; j++) {
+            if (!row_block) {
+                _status = write_at(j*_ld+_count, a+j*lda, k);
+                continue;
+            }
+            for (long i0 = 0; i0 < k && !_status; i0 += chunk) {
+                const long kb = std::min<long>(chunk, k-i0);
+                for (long i = 0; i < kb; i++) buf[i] = a[(i0+i)*lda+j];
+                _status = write_at(j*_ld+_count+i0, buf, kb);
+            }
+        }
+    }
+    if (!_status) _count += k;
+    return _status;
+}
+
+/// @brief Complete the header and close the file.
+/// @return 0 on success, 1 if a write failed, or fewer rows than declared
+///         were appended; also 1 if no file is open.
+int
+matrix_file_writer::close() noexcept
+{
+    if (_fd < 0) return 1;
+    int status = _status || (_rows && _count != _rows);
+    if (!status && _layout == matrix_layout::row_major && !_rows) {
+        matrix_file_header h;
+        fill_header(h, _count, _cols, _ld, _layout);
+        status = write_fully(_fd, 0, reinterpret_cast<const char*>(&h),
+            sizeof(h));
+    }
+    if (::close(_fd)) status = 1;
+    _fd = -1;
+    return status;
+}
@@ -0,0 +1,226 @@
+#ifndef __MATRIX_FILE_HPP__
+#define __MATRIX_FILE_HPP__
+
+#include <cstdint>
+#include <vector>
+#include "matrix_view.hpp"
+
+/// @brief Binary matrix files: a fixed header and an aligned payload.
+///
+/// A matrix file is the 64-byte matrix_file_header (dimensions, layout,
+/// element type and leading dimension) followed, at the byte offset
+/// header.payload (a multiple of matrix_alignment), by the elements in
+/// native byte order, column-wise or row-wise with leading dimension ld,
+/// exactly as a matrix_view addresses them. So
+///   - mapped_matrix maps a file (mmap) and hands out a matrix_view of the
+///     payload, without reading or copying it: the view can be passed
+///     directly to householder_qr, ls_qrsolve etc. The mapping is private
+///     (copy-on-write), so factorizing in place costs a copy of the pages
+///     actually written and never modifies the file;
+///   - matrix_file_writer writes a file from blocks of rows, appended one
+///     after the other, so a matrix can be produced (e.g. by a previous
+///     processing stage) without ever being in memory as a whole;
+///   - a row-major file with n+1 columns holds the records [A b] that
+///     ls_qrsolve_ooc reads, starting at payload_offset().
+///
+/// Column-major files have the leading dimension padded as for
+/// aligned_matrix, so every column starts on a cache line of the mapping;
+/// row-major files are written without padding (ld = cols). The header
+/// carries a byte order mark; files of the other byte order, of an unknown
+/// version or of an unsupported element type are rejected.
+///
+/// @example test_matrix_file.cpp
+
+/// Element type of a matrix file.
+enum class matrix_dtype : std::uint8_t { float64 = 1 };
+
+/// Header of a matrix file.
+struct matrix_file_header
+{
+    char          magic[8];    ///< matrix_file_magic
+    std::uint32_t byte_order;  ///< matrix_file_byte_order, as written
+    std::uint8_t  version;     ///< matrix_file_version
+    std::uint8_t  dtype;       ///< matrix_dtype
+    std::uint8_t  layout;      ///< 0: column-major, 1: row-major
+    std::uint8_t  reserved0;
+    std::int64_t  rows;        ///< number of rows
+    std::int64_t  cols;        ///< number of columns
+    std::int64_t  ld;          ///< leading dimension (in elements)
+    std::int64_t  payload;     ///< byte offset of element (0,0)
+    std::int64_t  reserved[2];
+};
+
+static_assert(sizeof(matrix_file_header) == 64,
+    "matrix_file_header must be 64 bytes");
+
+constexpr char          matrix_file_magic[8]  = {'M','A','T','R','I','X','\0','\n'};
+constexpr std::uint32_t matrix_file_byte_order = 0x01020304;
+constexpr std::uint8_t  matrix_file_version    = 1;
+
+/// @brief Read-only, zero-copy access to a matrix file, via mmap.
+///
+/// The mapping lives as long as the object (it can be moved but not
+/// copied); views obtained from it must not outlive it.
+class mapped_matrix
+{
+public:
+    mapped_matrix() noexcept = default;
+
+    mapped_matrix(mapped_matrix &&o) noexcept;
+
+    mapped_matrix&
+    operator=(mapped_matrix &&o) noexcept;
+
+    mapped_matrix(const mapped_matrix&) = delete;
+    mapped_matrix&
+    operator=(const mapped_matrix&) = delete;
+
+    ~mapped_matrix() noexcept
+    { close(); }
+
+    int
+    open(const char *path) noexcept;
+
+    void
+    close() noexcept;
+
+    /// View of the payload; 1 if no file is open, the file is not of
+    /// layout L, or its rows, columns or leading dimension exceed INT_MAX
+    /// (the int sizes of a matrix_view).
+    template<matrix_layout L>
+    int
+    view(matrix_view<double, L> &v) noexcept
+    {
+        if (!_data || L != _layout || _rows > INT32_MAX || _cols > INT32_MAX
+            || _ld > INT32_MAX) return 1;
+        v = matrix_view<double, L>(_data, _rows, _cols, _ld);
+        return 0;
+    }
+
+    template<matrix_layout L>
+    int
+    view(matrix_view<const double, L> &v) const noexcept
+    {
+        if (!_data || L != _layout || _rows > INT32_MAX || _cols > INT32_MAX
+            || _ld > INT32_MAX) return 1;
+        v = matrix_view<const double, L>(_data, _rows, _cols, _ld);
+        return 0;
+    }
+
+    long
+    rows() const noexcept
+    { return _rows; }
+
+    long
+    cols() const noexcept
+    { return _cols; }
+
+    long
+    ld() const noexcept
+    { return _ld; }
+
+    matrix_layout
+    layout() const noexcept
+    { return _layout; }
+
+    /// Byte offset of the payload in the file (e.g. for ls_qrsolve_ooc).
+    long
+    payload_offset() const noexcept
+    { return _payload; }
+
+private:
+    void          *_map     = nullptr; ///< the mapping (whole file)
+    std::size_t    _size    = 0;       ///< size of the mapping
+    double        *_data    = nullptr; ///< element (0,0)
+    long           _rows    = 0,
+                   _cols    = 0,
+                   _ld      = 0,
+                   _payload = 0;
+    matrix_layout  _layout  = matrix_layout::col_major;
+};
+
+/// @brief Streaming writer of a matrix file, by blocks of rows.
+///
+/// For a row-major file the number of rows need not be known in advance:
+/// the header is completed by close(). For a column-major file it must be
+/// (each appended block is scattered over the columns, so large blocks are
+/// cheaper). Blocks of either layout can be appended to a file of either
+/// layout.
+class matrix_file_writer
+{
+public:
+    matrix_file_writer() noexcept = default;
+
+    matrix_file_writer(const matrix_file_writer&) = delete;
+    matrix_file_writer&
+    operator=(const matrix_file_writer&) = delete;
+
+    /// Closes the file, if still open (ignoring errors; call close() to
+    /// check them).
+    ~matrix_file_writer() noexcept
+    { close(); }
+
+    int
+    open(const char *path, long cols,
+        matrix_layout layout = matrix_layout::row_major, long rows = 0)
+    noexcept;
+
+    template<matrix_layout L>
+    int
+    append(matrix_view<const double, L> a) noexcept
+    { return append_rows(a.data(), a.rows(), a.cols(), a.ld(), L); }
+
+    template<matrix_layout L>
+    int
+    append(matrix_view<double, L> a) noexcept
+    { return append_rows(a.data(), a.rows(), a.cols(), a.ld(), L); }
+
+    /// Append the k rows of the (column-wise, leading dimension lda) k-by-
+    /// cols block a.
+    int
+    append(const double *a, int k, int lda) noexcept
+    { return append_rows(a, k, _cols, lda, matrix_layout::col_major); }
+
+    int
+    close() noexcept;
+
+    /// Rows written so far.
+    long
+    rows() const noexcept
+    { return _count; }
+
+private:
+    int
+    append_rows(const double *a, int k, long n, int lda, matrix_layout l)
+    noexcept;
+
+    int
+    write_at(long off, const double *p, long count) noexcept;
+
+    int                 _fd     = -1;
+    int                 _status = 0;  ///< 1 after a failed write
+    long                _rows   = 0,  ///< rows of the file (0: unknown)
+                        _cols   = 0,
+                        _ld     = 0,
+                        _count  = 0;  ///< rows appended
+    matrix_layout       _layout = matrix_layout::row_major;
+    std::vector<double> _buf;         ///< gather buffer
+};
+
+/// Write the matrix a to the file path, in the layout of a.
+template<matrix_layout L>
+int
+write_matrix_file(const char *path, matrix_view<const double, L> a) noexcept
+{
+    matrix_file_writer w;
+    if (w.open(path, a.cols(), L, a.rows())) return 1;
+    const int status = w.append(a);
+    return w.close() || status;
+}
+
+template<matrix_layout L>
+int
+write_matrix_file(const char *path, matrix_view<double, L> a) noexcept
+{ return write_matrix_file(path, matrix_view<const double, L>(a)); }
+
+#endif
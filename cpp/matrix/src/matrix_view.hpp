@@ -0,0 +1,219 @@
+#ifndef __MATRIX_VIEW_HPP__
+#define __MATRIX_VIEW_HPP__
+
+#include <cstdlib>
+#include <algorithm>
+#include <new>
+#include <type_traits>
+
+/// @brief Strided (sub)matrix views, and aligned matrix storage.
+///
+/// A matrix_view is a non-owning handle to an m-by-n matrix stored in an
+/// array with leading dimension ld, either column-wise (element (i,j) is
+/// data[j*ld+i], \f$ld \geq m\f$) or row-wise (element (i,j) is
+/// data[i*ld+j], \f$ld \geq n\f$). The layout is a template parameter, so
+/// kernels taking views are overloaded (i.e. specialised) per layout at
+/// compile time, and indexing costs the same as hand-written j*ld+i code.
+///
+/// Views are cheap to copy (a pointer and three ints) and sub-blocks are
+/// views into the same array, e.g. the trailing matrix A(k:m, k:n) is
+/// a.block(k, k, m-k, n-k); no data is copied. A row-major m-by-n view and
+/// a column-major n-by-m view of the same array are each other's transpose.
+///
+/// aligned_matrix owns its storage: the array is aligned to
+/// matrix_alignment bytes and the leading dimension is padded to a multiple
+/// of matrix_alignment bytes, so that every column (or row) starts on a
+/// cache line.
+///
+/// @example test_matrix_view.cpp
+
+/// Storage order of a matrix.
+enum class matrix_layout { col_major, row_major };
+
+/// Alignment (in bytes) of aligned_matrix storage, and of its columns/rows.
+constexpr int matrix_alignment = 64;
+
+/// @brief Non-owning view of a (strided) matrix.
+///
+/// T is the element type (const-qualified for a read-only view); L is the
+/// storage order.
+template<typename T, matrix_layout L = matrix_layout::col_major>
+class matrix_view
+{
+public:
+    static constexpr matrix_layout layout = L;
+    using value_type = T;
+
+    constexpr
+    matrix_view() noexcept = default;
+
+    /// View of the m-by-n matrix in data, with leading dimension ld.
+    constexpr
+    matrix_view(T *data, int m, int n, int ld) noexcept
+    : _data(data), _m(m), _n(n), _ld(ld)
+    {}
+
+    /// View of the m-by-n matrix in data, stored contiguously.
+    constexpr
+    matrix_view(T *data, int m, int n) noexcept
+    : _data(data), _m(m), _n(n), _ld(L == matrix_layout::col_major ? m : n)
+    {}
+
+    /// A (mutable) view converts to a read-only one.
+    template<typename U, typename = typename std::enable_if<
+        std::is_same<const U, T>::value>::type>
+    constexpr
+    matrix_view(const matrix_view<U, L> &v) noexcept
+    : _data(v.data()), _m(v.rows()), _n(v.cols()), _ld(v.ld())
+    {}
+
+    /// Offset of element (i,j) from the start of the array.
+    constexpr long
+    offset(int i, int j) const noexcept
+    {
+        return L == matrix_layout::col_major ? (long)j*_ld + i
+                                             : (long)i*_ld + j;
+    }
+
+    constexpr T&
+    operator()(int i, int j) const noexcept
+    { return _data[offset(i, j)]; }
+
+    /// View of the m-by-n block starting at (i0, j0); no copy.
+    constexpr matrix_view
+    block(int i0, int j0, int m, int n) const noexcept
+    { return matrix_view(_data + offset(i0, j0), m, n, _ld); }
+
+    /// The transpose, as a view (of the other layout) of the same array.
+    constexpr matrix_view<T, L == matrix_layout::col_major
+        ? matrix_layout::row_major : matrix_layout::col_major>
+    transpose() const noexcept
+    { return {_data, _n, _m, _ld}; }
+
+    /// True if there is no padding between columns (rows, if row-major).
+    constexpr bool
+    contiguous() const noexcept
+    { return _ld == (L == matrix_layout::col_major ? _m : _n); }
+
+    constexpr T*
+    data() const noexcept
+    { return _data; }
+
+    constexpr int
+    rows() const noexcept
+    { return _m; }
+
+    constexpr int
+    cols() const noexcept
+    { return _n; }
+
+    constexpr int
+    ld() const noexcept
+    { return _ld; }
+
+private:
+    T  *_data = nullptr; ///< element (0,0)
+    int _m  = 0,         ///< rows
+        _n  = 0,         ///< columns
+        _ld = 0;         ///< leading dimension
+};
+
+/// @brief Matrix with aligned, owned storage.
+///
+/// The storage is zero-initialized. Construction may throw std::bad_alloc;
+/// the matrix can be moved but not copied.
+template<typename T, matrix_layout L = matrix_layout::col_major>
+class aligned_matrix
+{
+    static_assert(std::is_trivial<T>::value,
+        "aligned_matrix requires a trivial element type");
+public:
+    aligned_matrix() noexcept = default;
+
+    aligned_matrix(int m, int n)
+    : _m(m), _n(n), _ld(padded_ld(L == matrix_layout::col_major ? m : n))
+    {
+        const long size = (long)_ld*(L == matrix_layout::col_major ? n : m);
+        if (size > 0) {
+            void *p = nullptr;
+            if (posix_memalign(&p, matrix_alignment, size*sizeof(T)))
+                throw std::bad_alloc();
+            _data = static_cast<T*>(p);
+            std::fill(_data, _data+size, T(0));
+        }
+    }
+
+    aligned_matrix(aligned_matrix &&o) noexcept
+    : _data(o._data), _m(o._m), _n(o._n), _ld(o._ld)
+    { o._data = nullptr; o._m = o._n = o._ld = 0; }
+
+    aligned_matrix&
+    operator=(aligned_matrix &&o) noexcept
+    {
+        std::swap(_data, o._data);
+        std::swap(_m, o._m);
+        std::swap(_n, o._n);
+        std::swap(_ld, o._ld);
+        return *this;
+    }
+
+    aligned_matrix(const aligned_matrix&) = delete;
+    aligned_matrix&
+    operator=(const aligned_matrix&) = delete;
+
+    ~aligned_matrix() noexcept
+    { std::free(_data); }
+
+    /// Leading dimension used for k rows (columns, if row-major), i.e. k
+    /// rounded up to a whole number of alignment units.
+    static constexpr int
+    padded_ld(int k) noexcept
+    {
+        constexpr int a = matrix_alignment / sizeof(T);
+        return (k + a - 1) / a * a;
+    }
+
+    matrix_view<T, L>
+    view() noexcept
+    { return {_data, _m, _n, _ld}; }
+
+    matrix_view<const T, L>
+    view() const noexcept
+    { return {_data, _m, _n, _ld}; }
+
+    T&
+    operator()(int i, int j) noexcept
+    { return view()(i, j); }
+
+    const T&
+    operator()(int i, int j) const noexcept
+    { return view()(i, j); }
+
+    T*
+    data() noexcept
+    { return _data; }
+
+    const T*
+    data() const noexcept
+    { return _data; }
+
+    int
+    rows() const noexcept
+    { return _m; }
+
+    int
+    cols() const noexcept
+    { return _n; }
+
+    int
+    ld() const noexcept
+    { return _ld; }
+
+private:
+    T  *_data = nullptr;
+    int _m  = 0,
+        _n  = 0,
+        _ld = 0;
+};
+
+#endif
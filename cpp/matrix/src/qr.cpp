@@ -1,4 +1,10 @@
 #include <cmath>
+#include <algorithm>
+#include <limits>
+#include <new>
+#include "qr.hpp"
+#include "gemm_kernels.hpp"
+#include "run_threads.hpp"
 #ifdef DEBUG
 #include <iostream>
 #include <cassert>
@@ -27,7 +33,7 @@ noexcept
     int i,j;
     for (j = n-1; j > 0; j--) {
         b[j] /= u[j*n+j];
-        for (i = 0; i < j-1; i++) b[j] -= b[j]*u[j*n+i];
+        for (i = 0; i < j; i++) b[i] -= b[j]*u[j*n+i];
     }
     b[0] /= u[0];
     return;
@@ -110,38 +116,376 @@ householder_qr(double *__restrict__ a, double *__restrict__ b, int m, int n,
     int &sign)
 noexcept
 {
-    double *u,sum;
-    int    row,col,j;
+    qr_workspace ws;
+    sign = householder_qr(a, b, m, n, ws);
+    return;
+}
+
+/// @brief Compute Householder QR decomposition, using a caller-provided
+///        workspace.
+///
+/// Same as householder_qr; the workspace is only (re)allocated if it is
+/// smaller than qr_worksize(m, n), so that repeated calls with a reused
+/// workspace do not allocate.
+///
+/// @param[in,out]  a  The matrix \f$A\in{\Re}^{m\times n}\f$ (column-wise).
+/// @param[out]     b  A vector of size n; at output, the \f$\beta\f$
+///                    coefficients.
+/// @param[in]      m  Number of rows of a matrix A.
+/// @param[in]      n  Number of columns of matrix A.
+/// @param[in,out]  ws The workspace.
+/// @return         0 on success; any other value denotes an error (allocation
+///                 failure).
+int
+householder_qr(double *__restrict__ a, double *__restrict__ b, int m, int n,
+    qr_workspace &ws)
+noexcept
+{
+    return householder_qr(matrix_view<double>(a, m, n), b, ws);
+}
+
+/// @brief Householder QR decomposition of a (strided, column-major) matrix
+///        view.
+///
+/// Same as householder_qr, for any column-major view, e.g. a block of a
+/// larger matrix (no copy is made).
+///
+/// @param[in,out]  a  The matrix \f$A\in{\Re}^{m\times n}\f$.
+/// @param[out]     b  A vector of size n; at output, the \f$\beta\f$
+///                    coefficients.
+/// @param[in,out]  ws The workspace.
+/// @return         0 on success; any other value denotes an error (allocation
+///                 failure).
+int
+householder_qr(matrix_view<double> a, double *__restrict__ b,
+    qr_workspace &ws)
+noexcept
+{
+    if (ws.reserve(qr_worksize(a.rows(), a.cols()))) return 1;
+    householder_qr_panel(a.data(), a.ld(), b, a.rows(), a.cols(), ws.data());
+    return 0;
+}
 
-    try {
-        u = new double[m];
-    } catch (std::bad_alloc&) {
-        sign = 1;
-        return;
+/// @brief Householder QR decomposition of a row-major matrix view.
+///
+/// Same as householder_qr (R in the upper triangle, the Householder vectors
+/// below it, in the same logical positions), for a matrix stored row-wise.
+/// Each reflector is formed in place in its (strided) column and applied
+/// row by row: \f$w^T = u^T A\f$ and then \f$A \leftarrow A - \beta u w^T\f$
+/// are accumulated over the rows of A, so that the inner loops run along
+/// the (contiguous) rows.
+///
+/// @param[in,out]  a  The matrix \f$A\in{\Re}^{m\times n}\f$ (row-wise).
+/// @param[out]     b  A vector of size n; at output, the \f$\beta\f$
+///                    coefficients.
+/// @param[in,out]  ws The workspace.
+/// @return         0 on success; any other value denotes an error (allocation
+///                 failure).
+int
+householder_qr(matrix_view<double, matrix_layout::row_major> a,
+    double *__restrict__ b, qr_workspace &ws)
+noexcept
+{
+    const int m = a.rows(), n = a.cols(), lda = a.ld();
+    if (ws.reserve(qr_worksize(m, n))) return 1;
+    double *__restrict__ w = ws.data();
+    double *__restrict__ p = a.data();
+    int row, col, j;
+
+    for (col = 0; col < n && col < m; col++) {
+        double *__restrict__ ac = p + (long)col*lda;
+        // Householder vector of A(col:m, col) (see householder_vec); its
+        // components col+1:m overwrite the column
+        double sigma = 0e0, v0, beta = 0e0;
+        for (row = col+1; row < m; row++) sigma += p[(long)row*lda+col]*p[(long)row*lda+col];
+        const double x0 = ac[col];
+        if (sigma == 0e0) {
+            v0 = 1e0;
+        } else {
+            const double mu = std::sqrt(x0*x0+sigma);
+            v0 = (x0 <= 0e0) ? (x0-mu) : (-sigma/(x0+mu));
+            beta = 2e0*v0*v0/(sigma+v0*v0);
+        }
+        for (row = col+1; row < m; row++) p[(long)row*lda+col] /= v0;
+        b[col] = beta;
+
+        // w^T = u^T A(col:m, col:n), then A(col:m, col:n) -= beta u w^T
+        for (j = col; j < n; j++) w[j] = ac[j];
+        for (row = col+1; row < m; row++) {
+            const double *__restrict__ ar = p + (long)row*lda;
+            const double ui = ar[col];
+            for (j = col+1; j < n; j++) w[j] += ui*ar[j];
+        }
+        // column col: u^T A(col:m, col) = x0 + sigma/v0
+        w[col] = x0 + sigma/v0;
+        for (j = col; j < n; j++) w[j] *= beta;
+        for (j = col; j < n; j++) ac[j] -= w[j];
+        for (row = col+1; row < m; row++) {
+            double *__restrict__ ar = p + (long)row*lda;
+            const double ui = ar[col];
+            for (j = col+1; j < n; j++) ar[j] -= ui*w[j];
+        }
     }
+    return 0;
+}
+
+/// @brief Householder QR decomposition of a (sub)matrix with leading
+///        dimension.
+///
+/// This is the (unblocked) kernel of householder_qr, operating on an m-by-n
+/// matrix A stored column-wise within a larger array, i.e. element A(i,j) is
+/// a[j*lda+i], with \f$lda \geq m\f$. The output is the same as for
+/// householder_qr (R in the upper triangle, Householder vectors below it and
+/// the \f$\beta\f$ coefficients in b).
+///
+/// @param[in,out]  a   The matrix \f$A\in{\Re}^{m\times n}\f$ (column-wise,
+///                     leading dimension lda).
+/// @param[in]      lda Leading dimension of a (\f$lda \geq m\f$).
+/// @param[out]     b   A vector of size n; at output the \f$\beta\f$
+///                     coefficients.
+/// @param[in]      m   Number of rows of a matrix A.
+/// @param[in]      n   Number of columns of matrix A.
+/// @param[in]      u   Workspace of size >= m.
+///
+/// Reference: Matrix Computations, G.H. Colub, CF.V. Loan, 1996, pg. 224
+void
+householder_qr_panel(double *__restrict__ a, int lda, double *__restrict__ b,
+    int m, int n, double *__restrict__ u)
+noexcept
+{
+    double sum;
+    int    row,col,j;
 
-    for (col = 0; col < n; col++) {
+    for (col = 0; col < n && col < m; col++) {
         //  compute u vector (i.e. Householder vector) based on the input
         //+ vector A(col:m, col).
-        b[col] = householder_vec(&a[col*m+col], m-col, u);
-        
+        b[col] = householder_vec(&a[col*lda+col], m-col, u);
+
         // Compute A(col:m, col:n) = (I-buu^T)A(col+1:m, col+1:n)
         for (j = col; j < n; j++) {
-            for (sum = 0e0, row = col; row < m; row++) sum += a[j*m+row]*u[row-col];
+            for (sum = 0e0, row = col; row < m; row++) sum += a[j*lda+row]*u[row-col];
             sum *= b[col];
-            for (row = col; row < m; row++) a[j*m+row] -= sum*u[row-col];
+            for (row = col; row < m; row++) a[j*lda+row] -= sum*u[row-col];
         }
 
         // if (j < m) A(j+1:m, j) = u(2:m-j+1)
-        if (col < m) {
-            for (row = col+1; row < m; row++) a[col*m+row] = u[row-col];
+        for (row = col+1; row < m; row++) a[col*lda+row] = u[row-col];
+    }
+    return;
+}
+
+/// @brief Form the triangular factor of a block reflector.
+///
+/// Given k Householder vectors \f$v_1, ..., v_k\f$ (stored as the columns of
+/// a unit lower trapezoidal matrix \f$V\in{\Re}^{m\times k}\f$) and their
+/// \f$\beta\f$ coefficients, this function computes the upper triangular
+/// matrix \f$T\in{\Re}^{k\times k}\f$ such that
+/// \f$H_1 H_2 ... H_k = I - V T V^T\f$ (compact WY representation).
+/// V is stored exactly as householder_qr leaves the Householder vectors,
+/// i.e. column j holds components j+1:m of \f$v_j\f$ below the diagonal; the
+/// unit diagonal and the upper triangle are implied (and never read).
+///
+/// @param[in]  v    The matrix V (column-wise, leading dimension ldv).
+/// @param[in]  ldv  Leading dimension of v (\f$ldv \geq m\f$).
+/// @param[in]  b    The k \f$\beta\f$ coefficients.
+/// @param[in]  m    Number of rows of V.
+/// @param[in]  k    Number of Householder vectors (columns of V).
+/// @param[out] t    At output the k-by-k upper triangular T (column-wise,
+///                  leading dimension ldt); the strictly lower triangle is
+///                  not referenced.
+/// @param[in]  ldt  Leading dimension of t (\f$ldt \geq k\f$).
+///
+/// Reference: Schreiber, R. & Van Loan, C., A storage-efficient WY
+///            representation for products of Householder transformations,
+///            SIAM J. Sci. Stat. Comput. 10 (1989), 53-57
+void
+block_reflector_t(const double *__restrict__ v, int ldv,
+    const double *__restrict__ b, int m, int k, double *__restrict__ t,
+    int ldt)
+noexcept
+{
+    int i,j,r;
+    double sum;
+
+    for (i = 0; i < k; i++) {
+        // z = V(:,0:i)^T v_i, stored (temporarily) in T(0:i, i)
+        for (j = 0; j < i; j++) {
+            for (sum = v[j*ldv+i], r = i+1; r < m; r++) sum += v[j*ldv+r]*v[i*ldv+r];
+            t[i*ldt+j] = sum;
+        }
+        // T(0:i, i) = -beta_i * T(0:i, 0:i) * z
+        for (j = 0; j < i; j++) {
+            for (sum = 0e0, r = j; r < i; r++) sum += t[r*ldt+j]*t[i*ldt+r];
+            t[i*ldt+j] = -b[i]*sum;
+        }
+        t[i*ldt+i] = b[i];
+    }
+    return;
+}
+
+/// @brief Apply a block reflector to a matrix.
+///
+/// Given the compact WY representation \f$Q = H_1 ... H_k = I - V T V^T\f$
+/// (see block_reflector_t), overwrite the m-by-nc matrix C with
+/// \f$Q^T C = (I - V T^T V^T) C\f$ (if trans is true) or with
+/// \f$Q C = (I - V T V^T) C\f$ (if trans is false).
+/// The update is performed as two matrix-matrix products,
+/// \f$W = V^T C\f$ and \f$C = C - V (T^T W)\f$. The unit lower triangle
+/// at the top of V is applied element-wise; the (dense) rows below it by
+/// gemm_tn_acc and gemm_nn_sub, in chunks of block_reflector_rows rows so
+/// that the part of V in use stays in cache while all columns of C are
+/// updated.
+///
+/// @param[in]     trans If true apply \f$Q^T\f$, else apply \f$Q\f$.
+/// @param[in]     v     The matrix V (column-wise, leading dimension ldv),
+///                      as in block_reflector_t.
+/// @param[in]     ldv   Leading dimension of v (\f$ldv \geq m\f$).
+/// @param[in]     t     The k-by-k upper triangular matrix T (leading
+///                      dimension ldt).
+/// @param[in]     ldt   Leading dimension of t.
+/// @param[in]     m     Number of rows of V and C.
+/// @param[in]     k     Number of Householder vectors (columns of V).
+/// @param[in,out] c     The matrix C (column-wise, leading dimension ldc).
+/// @param[in]     ldc   Leading dimension of c (\f$ldc \geq m\f$).
+/// @param[in]     nc    Number of columns of C.
+/// @param[in]     w     Workspace of size >= block_reflector_worksize(k, nc).
+void
+apply_block_reflector(bool trans, const double *__restrict__ v, int ldv,
+    const double *__restrict__ t, int ldt, int m, int k,
+    double *__restrict__ c, int ldc, int nc, double *__restrict__ w)
+noexcept
+{
+    constexpr int rb = block_reflector_rows;
+    const int kt = std::min(k, m); // rows of the unit lower triangle
+    double sum;
+    int i,j,r,r0;
+
+    // W = V^T C; the triangle, then the dense rows one chunk at a time
+    for (j = 0; j < nc; j++) {
+        const double *__restrict__ cj = c + (long)j*ldc;
+        double *__restrict__ wj = w + (long)j*k;
+        for (i = 0; i < kt; i++) {
+            for (sum = cj[i], r = i+1; r < kt; r++) sum += v[(long)i*ldv+r]*cj[r];
+            wj[i] = sum;
+        }
+        for (; i < k; i++) wj[i] = 0e0;
+    }
+    for (r0 = k; r0 < m; r0 += rb) {
+        gemm_tn_acc(std::min(rb, m-r0), k, nc, v + r0, ldv, c + r0, ldc, w, k);
+    }
+
+    // W = T^T W (or T W), in place
+    if (trans) {
+        trmm_tn(k, nc, t, ldt, w, k);
+    } else {
+        trmm_nn(k, nc, t, ldt, w, k);
+    }
+
+    // C = C - V W; the dense rows one chunk at a time, then the triangle
+    for (r0 = k; r0 < m; r0 += rb) {
+        gemm_nn_sub(std::min(rb, m-r0), k, nc, v + r0, ldv, w, k, c + r0, ldc);
+    }
+    for (j = 0; j < nc; j++) {
+        double *__restrict__ cj = c + (long)j*ldc;
+        const double *__restrict__ wj = w + (long)j*k;
+        for (r = 0; r < kt; r++) {
+            for (sum = wj[r], i = 0; i < r; i++) sum += v[(long)i*ldv+r]*wj[i];
+            cj[r] -= sum;
         }
     }
+    return;
+}
 
-    delete[] u;
+/// @brief Blocked (compact WY) Householder QR decomposition.
+///
+/// Computes the same factorization (and with the exact same output format)
+/// as householder_qr, i.e. the upper triangular part of A is overwritten by
+/// R, the Householder vectors are stored below the diagonal and b holds the
+/// \f$\beta\f$ coefficients; the result can thus be used with thin_q,
+/// ls_qrsolve, etc.
+/// The columns are processed in panels of nb: each panel is factored with
+/// the unblocked algorithm (householder_qr_panel), its reflectors are
+/// accumulated into the compact WY form \f$I - V T V^T\f$ and applied to the
+/// trailing matrix via apply_block_reflector (i.e. via matrix-matrix
+/// products), so that the trailing matrix is streamed through cache once per
+/// panel instead of once per column.
+///
+/// @param[in,out]  a   The matrix \f$A\in{\Re}^{m\times n}\f$ (column-wise).
+///                     At output it is overwritten by R and the Householder
+///                     vector components.
+/// @param[out]     b   A vector of size n; at output, it contains the
+///                     \f$\beta\f$ coefficients.
+/// @param[in]      m   Number of rows of a matrix A.
+/// @param[in]      n   Number of columns of matrix A.
+/// @param[out]     sign If non-zero, then the function has ended with error.
+/// @param[in]      nb  Panel width (block size).
+///
+/// Reference: Matrix Computations, G.H. Colub, CF.V. Loan, 1996, pg. 225
+void
+householder_qr_blocked(double *__restrict__ a, double *__restrict__ b, int m,
+    int n, int &sign, int nb)
+noexcept
+{
+    qr_workspace ws;
+    sign = householder_qr_blocked(a, b, m, n, ws, nb);
     return;
 }
 
+/// @brief Blocked (compact WY) Householder QR decomposition, using a
+///        caller-provided workspace.
+///
+/// Same as householder_qr_blocked; the workspace is only (re)allocated if it
+/// is smaller than qr_worksize(m, n, nb).
+///
+/// @return 0 on success; any other value denotes an error (allocation
+///         failure).
+int
+householder_qr_blocked(double *__restrict__ a, double *__restrict__ b, int m,
+    int n, qr_workspace &ws, int nb)
+noexcept
+{
+    return householder_qr_blocked(matrix_view<double>(a, m, n), b, ws, nb);
+}
+
+/// @brief Blocked (compact WY) Householder QR decomposition of a (strided,
+///        column-major) matrix view.
+///
+/// Same as householder_qr_blocked, for any column-major view; the panels
+/// and trailing matrices are blocks of the view (no copy is made).
+///
+/// @return 0 on success; any other value denotes an error (allocation
+///         failure).
+int
+householder_qr_blocked(matrix_view<double> a, double *__restrict__ b,
+    qr_workspace &ws, int nb)
+noexcept
+{
+    const int m = a.rows(), n = a.cols(), lda = a.ld();
+    double *u, *t, *w;
+    int j, jb, kmax = std::min(m, n);
+
+    if (nb < 1) nb = 1;
+    if (ws.reserve(qr_worksize(m, n, nb))) return 1;
+    u = ws.data();
+    t = u + m;
+    w = t + nb*nb;
+
+    for (j = 0; j < kmax; j += nb) {
+        jb = std::min(nb, kmax-j);
+        // factor the panel A(j:m, j:j+jb)
+        auto v = a.block(j, j, m-j, jb);
+        householder_qr_panel(v.data(), lda, &b[j], m-j, jb, u);
+        // update the trailing matrix A(j:m, j+jb:n)
+        if (j+jb < n) {
+            auto c = a.block(j, j+jb, m-j, n-j-jb);
+            block_reflector_t(v.data(), lda, &b[j], m-j, jb, t, nb);
+            apply_block_reflector(true, v.data(), lda, t, nb, m-j, jb,
+                c.data(), lda, c.cols(), w);
+        }
+    }
+    return 0;
+}
+
 /// @brief Compute the thin Q matrix of a QR factorization.
 ///
 /// This function computes the thin Q matrix of a QR factorization, given that
@@ -164,20 +508,36 @@ noexcept
 /// @param[in,out] q  At output the m*n Q matrix
 /// @param[in]     m  Number of rows of a and q matrices.
 /// @param[in]     n  Number of columns of a and q matrices.
+/// @return        0 on success; any other value denotes an error (allocation
+///                failure).
 ///
 /// Reference: Matrix Computations, G.H. Colub, CF.V. Loan, 1996, pg. 213
-void
+int
 thin_q(double *__restrict__ a, double *__restrict__ b, double *__restrict__ q,
     int m, int n)
+{
+    qr_workspace ws;
+    return thin_q(a, b, q, m, n, ws);
+}
+
+/// @brief Compute the thin Q matrix of a QR factorization, using a
+///        caller-provided workspace.
+///
+/// Same as thin_q; the workspace is only (re)allocated if it is smaller than
+/// qr_worksize(m, n).
+///
+/// @return 0 on success; any other value denotes an error (allocation
+///         failure).
+int
+thin_q(const double *__restrict__ a, const double *__restrict__ b,
+    double *__restrict__ q, int m, int n, qr_workspace &ws)
+noexcept
 {
     int i,j,col;
     double sum,*u;
 
-    try {
-        u = new double[m];
-    } catch (std::bad_alloc&) {
-        return;
-    }
+    if (ws.reserve(qr_worksize(m, n))) return 1;
+    u = ws.data();
 
     std::fill(q, q+m*n, 0e0);
     for (col = 0; col < n; col++) q[col*m+col] = 1e0;
@@ -192,8 +552,7 @@ thin_q(double *__restrict__ a, double *__restrict__ b, double *__restrict__ q,
         }
     }
 
-    delete[] u;
-    return;
+    return 0;
 }
 
 /// @brief Householder-QR LS solution.
@@ -209,40 +568,672 @@ thin_q(double *__restrict__ a, double *__restrict__ b, double *__restrict__ q,
 ///                   overwritten by the LS solution vector.
 /// @param[in]     m  Number of observations (rows of a and b).
 /// @param[in]     n  Number of parameters (columns of a).
+/// @return        0 on success; any other value denotes an error (invalid
+///                sizes, allocation failure or singular R).
 ///
 /// Reference: Matrix Computations, G.H. Colub, CF.V. Loan, 1996, pg. 240
-void
+int
 ls_qrsolve(double *__restrict__ a, double *__restrict__ b, int m, int n)
 {
+    qr_workspace ws;
+    return ls_qrsolve(a, b, m, n, ws);
+}
+
+/// @brief Householder-QR LS solution, using a caller-provided workspace.
+///
+/// Same as ls_qrsolve; the workspace is only (re)allocated if it is smaller
+/// than qr_worksize(m, n).
+///
+/// @return 0 on success; any other value denotes an error (invalid sizes,
+///         allocation failure or singular R).
+int
+ls_qrsolve(double *__restrict__ a, double *__restrict__ b, int m, int n,
+    qr_workspace &ws)
+noexcept
+{
+    return ls_qrsolve(matrix_view<double>(a, m, n), b, ws);
+}
+
+/// @brief Householder-QR LS solution, for a (strided, column-major) matrix
+///        view.
+///
+/// Same as ls_qrsolve; a is overwritten by its QR factorization.
+///
+/// @return 0 on success; any other value denotes an error (invalid sizes,
+///         allocation failure or singular R).
+int
+ls_qrsolve(matrix_view<double> av, double *__restrict__ b, qr_workspace &ws)
+noexcept
+{
+    const int m = av.rows(), n = av.cols(), lda = av.ld();
+    double *__restrict__ a = av.data();
     double *beta, *u, sum;
-    int i, j, sign;
+    int i, j;
 
-    try {
-        beta = new double[m];
-        u    = new double[m];
-    } catch (std::bad_alloc&) {
-        return;
-    }
+    if (m < n || n < 1) return 1;
+    if (ws.reserve(qr_worksize(m, n))) return 1;
+    beta = ws.data();
+    u    = beta + n;
 
     // Overwrite a with its QR factorization
-    householder_qr(a, beta, m, n, sign);
+    householder_qr_panel(a, lda, beta, m, n, u);
 
     // Compute b <- (Q^T)*b
     for (j = 0; j < n; j++) {
+        const double *__restrict__ aj = a + (long)j*lda;
+        for (sum = b[j], i = j+1; i < m; i++) sum += aj[i]*b[i];
+        sum *= beta[j];
+        b[j] -= sum;
+        for (i = j+1; i < m; i++) b[i] -= sum*aj[i];
+    }
+
+    // Solve R(1:n,1:n) * x = b(1:n)
+    return triangular_solve(true, false, a, lda, b, m, n, 1);
+}
+
+/// @brief Householder-QR LS solution, for a row-major matrix view.
+///
+/// Same as ls_qrsolve; a is overwritten by its QR factorization (see the
+/// row-major householder_qr). \f$Q^T b\f$ and the back substitution run
+/// along the rows of a.
+///
+/// @return 0 on success; any other value denotes an error (invalid sizes,
+///         allocation failure or singular R).
+int
+ls_qrsolve(matrix_view<double, matrix_layout::row_major> av,
+    double *__restrict__ b, qr_workspace &ws)
+noexcept
+{
+    const int m = av.rows(), n = av.cols(), lda = av.ld();
+    double *beta;
+    int i, j;
+
+    if (m < n || n < 1) return 1;
+    if (ws.reserve(qr_worksize(m, n) + n)) return 1;
+    beta = ws.data() + qr_worksize(m, n);
+
+    // Overwrite a with its QR factorization (this uses the first
+    // qr_worksize(m, n) doubles of the workspace)
+    householder_qr(av, beta, ws);
+    const double *__restrict__ a = av.data();
+
+    // Compute b <- (Q^T)*b, one reflector at a time
+    for (j = 0; j < n; j++) {
+        double sum = b[j];
+        for (i = j+1; i < m; i++) sum += a[(long)i*lda+j]*b[i];
+        sum *= beta[j];
+        b[j] -= sum;
+        for (i = j+1; i < m; i++) b[i] -= sum*a[(long)i*lda+j];
+    }
+
+    // Solve R(1:n,1:n) * x = b(1:n), by rows (dot product form)
+    for (i = n-1; i >= 0; i--) {
+        const double *__restrict__ ri = a + (long)i*lda;
+        if (ri[i] == 0e0) return 1;
+        double sum = b[i];
+        for (j = i+1; j < n; j++) sum -= ri[j]*b[j];
+        b[i] = sum / ri[i];
+    }
+    return 0;
+}
+
+/// @brief Householder QR decomposition with column pivoting.
+///
+/// Given \f$A\in{\Re}^{m\times n}\f$, this algorithm computes the
+/// factorization \f$AP = QR\f$, where P is a permutation matrix chosen so
+/// that, at each step, the column with the largest (remaining) norm is
+/// brought to the pivot position. Hence \f$|r_{00}| \geq |r_{11}| \geq
+/// ...\f$, and the numerical rank of A is the number of diagonal elements
+/// of R that are larger than \f$tol \cdot |r_{00}|\f$.
+/// The output format is the same as for householder_qr (of the permuted
+/// matrix AP), for \f$min(m,n)\f$ Householder vectors.
+///
+/// The norms of the (trailing parts of the) columns are downdated at each
+/// step instead of being recomputed; since this is prone to cancellation,
+/// a norm is recomputed when it has dropped (relative to its last recomputed
+/// value) below \f$\sqrt{\epsilon}\f$ (Drmac & Bujanovic, 2008; as in
+/// LAPACK's xLAQP2).
+///
+/// @param[in,out]  a    The matrix \f$A\in{\Re}^{m\times n}\f$ (column-wise).
+///                      At output it is overwritten by the upper triangular
+///                      part of R and Householder vector components.
+/// @param[out]     b    A vector of size min(m,n); at output, the
+///                      \f$\beta\f$ coefficients.
+/// @param[out]     perm A vector of size n; at output, column j of AP is
+///                      column perm[j] of A.
+/// @param[in]      m    Number of rows of a matrix A.
+/// @param[in]      n    Number of columns of matrix A.
+/// @param[out]     rank The numerical rank of A.
+/// @param[out]     sign If non-zero, then the function has ended with error.
+/// @param[in]      tol  Relative tolerance for the rank decision; if <= 0,
+///                      then \f$max(m,n)\epsilon\f$ is used.
+///
+/// Reference: Matrix Computations, G.H. Colub, CF.V. Loan, 1996, pg. 248
+///            Drmac, Z. & Bujanovic, Z., On the failure of rank-revealing QR
+///            factorization software - a case study, ACM Trans. Math. Softw.
+///            35 (2008)
+void
+householder_qr_pivot(double *__restrict__ a, double *__restrict__ b,
+    int *__restrict__ perm, int m, int n, int &rank, int &sign, double tol)
+noexcept
+{
+    qr_workspace ws;
+    sign = householder_qr_pivot(a, b, perm, m, n, rank, ws, tol);
+    return;
+}
+
+/// @brief Column-pivoted Householder QR, using a caller-provided workspace.
+///
+/// Same as householder_qr_pivot; the workspace is only (re)allocated if it
+/// is smaller than qr_worksize(m, n).
+///
+/// @return 0 on success; any other value denotes an error (allocation
+///         failure).
+int
+householder_qr_pivot(double *__restrict__ a, double *__restrict__ b,
+    int *__restrict__ perm, int m, int n, int &rank, qr_workspace &ws,
+    double tol)
+noexcept
+{
+    double *u, *vn1, *vn2;
+    double sum, temp;
+    int    row, col, j, p;
+    const int    k     = std::min(m, n);
+    const double tol3z = std::sqrt(std::numeric_limits<double>::epsilon());
+
+    rank = 0;
+    if (ws.reserve(m+2*n)) return 1;
+    u   = ws.data();
+    vn1 = u + m;
+    vn2 = vn1 + n;
+
+    // initial column norms
+    for (j = 0; j < n; j++) {
+        for (sum = 0e0, row = 0; row < m; row++) sum += a[j*m+row]*a[j*m+row];
+        vn2[j] = vn1[j] = std::sqrt(sum);
+        perm[j] = j;
+    }
+
+    for (col = 0; col < k; col++) {
+        // pivot: the column with the largest remaining norm
+        p = col;
+        for (j = col+1; j < n; j++) if (vn1[j] > vn1[p]) p = j;
+        if (p != col) {
+            std::swap_ranges(a+p*m, a+p*m+m, a+col*m);
+            std::swap(perm[p], perm[col]);
+            vn1[p] = vn1[col];
+            vn2[p] = vn2[col];
+        }
+
+        //  Householder vector of A(col:m, col)
+        b[col] = householder_vec(&a[col*m+col], m-col, u);
+
+        // Compute A(col:m, col:n) = (I-buu^T)A(col:m, col:n)
+        for (j = col; j < n; j++) {
+            for (sum = 0e0, row = col; row < m; row++) sum += a[j*m+row]*u[row-col];
+            sum *= b[col];
+            for (row = col; row < m; row++) a[j*m+row] -= sum*u[row-col];
+        }
+        for (row = col+1; row < m; row++) a[col*m+row] = u[row-col];
+
+        // downdate the norms of the trailing columns
+        for (j = col+1; j < n; j++) {
+            if (vn1[j] == 0e0) continue;
+            temp = std::abs(a[j*m+col]) / vn1[j];
+            temp = std::max(0e0, (1e0+temp)*(1e0-temp));
+            if (temp*(vn1[j]/vn2[j])*(vn1[j]/vn2[j]) <= tol3z) {
+                for (sum = 0e0, row = col+1; row < m; row++) sum += a[j*m+row]*a[j*m+row];
+                vn2[j] = vn1[j] = std::sqrt(sum);
+            } else {
+                vn1[j] *= std::sqrt(temp);
+            }
+        }
+    }
+
+    // numerical rank
+    if (tol <= 0e0) tol = std::max(m, n)*std::numeric_limits<double>::epsilon();
+    const double rmax = (k > 0) ? std::abs(a[0]) : 0e0;
+    while (rank < k && std::abs(a[rank*m+rank]) > tol*rmax) ++rank;
+
+    return 0;
+}
+
+/// @brief Rank-revealing (column-pivoted) Householder-QR LS solution.
+///
+/// Solve the Least Squares problem \f$min\|Ax-b\|\f$, for a (possibly)
+/// rank-deficient \f$A\in{\Re}^{m\times n}\f$, via householder_qr_pivot.
+/// With \f$AP = Q[R_{11}, R_{12}; 0, R_{22}]\f$, where \f$R_{11}\f$ is
+/// rank-by-rank and \f$R_{22}\f$ is neglected, and \f$c = Q^T b\f$:
+///   - the basic solution has n-rank zero components:
+///     \f$x = P[R_{11}^{-1}c_1; 0]\f$,
+///   - the minimum norm solution is computed via the complete orthogonal
+///     decomposition \f$[R_{11}, R_{12}] = [T, 0]Z\f$ (Z orthogonal, computed
+///     by Householder reflections from the right):
+///     \f$x = PZ^T[T^{-1}c_1; 0]\f$.
+/// For a full-rank A, both are the (unique) LS solution.
+///
+/// @param[in,out] a        The design matrix (m-by-n, column-wise); at
+///                         output overwritten by its factorization.
+/// @param[in,out] b        The observation vector, of size m. At output,
+///                         overwritten by \f$Q^T b\f$.
+/// @param[out]    x        Vector of size n; at output the LS solution.
+/// @param[in]     m        Number of observations (rows of a and b).
+/// @param[in]     n        Number of parameters (columns of a).
+/// @param[out]    rank     The numerical rank of A.
+/// @param[in]     min_norm If true, compute the minimum norm solution, else
+///                         the basic one.
+/// @param[in]     tol      Relative tolerance for the rank decision (see
+///                         householder_qr_pivot).
+/// @return        0 on success; any other value denotes an error (allocation
+///                failure).
+///
+/// Reference: Matrix Computations, G.H. Colub, CF.V. Loan, 1996, pg. 250
+int
+ls_qrsolve_pivot(double *__restrict__ a, double *__restrict__ b,
+    double *__restrict__ x, int m, int n, int &rank, bool min_norm, double tol)
+{
+    qr_workspace ws;
+    return ls_qrsolve_pivot(a, b, x, m, n, rank, ws, min_norm, tol);
+}
+
+/// @brief Rank-revealing Householder-QR LS solution, using a caller-provided
+///        workspace.
+///
+/// Same as ls_qrsolve_pivot; the workspace is only (re)allocated if it is
+/// smaller than qr_worksize(m, n).
+///
+/// @return 0 on success; any other value denotes an error (allocation
+///         failure).
+int
+ls_qrsolve_pivot(double *__restrict__ a, double *__restrict__ b,
+    double *__restrict__ x, int m, int n, int &rank, qr_workspace &ws,
+    bool min_norm, double tol)
+noexcept
+{
+    double *beta, *w, *z, *v, sum;
+    int    *perm, i, j, l;
+    const int k = std::min(m, n);
+
+    // householder_qr_pivot uses the first m+2n doubles; then beta, w, z, v
+    // and the permutation (ints, in the storage of (n+1)/2 doubles)
+    if (ws.reserve(m + 2*n + k + 3*n + 2 + (n+1)/2)) return 1;
+    beta = ws.data() + m + 2*n;
+    w    = beta + k;
+    z    = w + n;
+    v    = z + n + 1;
+    perm = reinterpret_cast<int*>(v + n + 1);
+
+    if (householder_qr_pivot(a, beta, perm, m, n, rank, ws, tol)) return 1;
+
+    // Compute b <- (Q^T)*b
+    for (j = 0; j < k; j++) {
         for (sum = b[j], i = j+1; i < m; i++) sum += a[j*m+i]*b[i];
         sum *= beta[j];
         b[j] -= sum;
         for (i = j+1; i < m; i++) b[i] -= sum*a[j*m+i];
     }
 
-    // Solve R(1:n,1:n) * x = n(1:n)
-    for (j = n-1; j > 0; j--) {
-        b[j] /= a[j*m+j];
-        for (i = 0; i < j-1; i++) b[i] -= b[j]*a[j*m+i];
+    const int r = rank;
+    std::fill(w, w+n, 0e0);
+    std::copy(b, b+r, w);
+
+    // [R11 R12] -> [T 0] Z, with Z = H(0) ... H(r-1); H(j) acts on rows
+    // {j, r, ..., n-1} of a vector and z(j) holds its components r:n
+    if (min_norm && r < n) {
+        for (j = r-1; j >= 0; j--) {
+            // Householder vector of [R(j,j), R(j,r:n)]
+            v[0] = a[j*m+j];
+            for (l = r; l < n; l++) v[1+l-r] = a[l*m+j];
+            beta[j] = householder_vec(v, n-r+1, z);
+            // apply from the right to rows 0:j
+            for (i = 0; i <= j; i++) {
+                for (sum = a[j*m+i], l = r; l < n; l++) sum += a[l*m+i]*z[1+l-r];
+                sum *= beta[j];
+                a[j*m+i] -= sum;
+                for (l = r; l < n; l++) a[l*m+i] -= sum*z[1+l-r];
+            }
+            // keep the vector in the (now zero) R(j,r:n)
+            for (l = r; l < n; l++) a[l*m+j] = z[1+l-r];
+        }
     }
-    b[0] /= a[0];
 
-    delete[] u;
-    delete[] beta;
-    return;
+    // Solve T * y = c(1:r) (T = R11 for the basic solution)
+    for (j = r-1; j >= 0; j--) {
+        w[j] /= a[j*m+j];
+        for (i = 0; i < j; i++) w[i] -= w[j]*a[j*m+i];
+    }
+
+    // Apply Z^T = H(r-1) ... H(0)
+    if (min_norm && r < n) {
+        for (j = 0; j < r; j++) {
+            for (sum = w[j], l = r; l < n; l++) sum += a[l*m+j]*w[l];
+            sum *= beta[j];
+            w[j] -= sum;
+            for (l = r; l < n; l++) w[l] -= sum*a[l*m+j];
+        }
+    }
+
+    // and undo the permutation
+    for (j = 0; j < n; j++) x[perm[j]] = w[j];
+
+    return 0;
+}
+
+/// @brief Apply \f$Q^T\f$ of a QR factorization to a block of vectors.
+///
+/// Given the result of householder_qr (or householder_qr_blocked), overwrite
+/// the m-by-k matrix C (e.g. k observation vectors) with \f$Q^T C\f$.
+/// The reflectors are processed in blocks of nb, each accumulated in compact
+/// WY form and applied to all (up to qr_apply_cols at a time) columns of C
+/// via apply_block_reflector (i.e. as matrix-matrix products), so that the
+/// factorization is read once per block of right-hand sides instead of once
+/// per right-hand side; for e.g. 1000-by-50 and k=64 or 5000-by-100 and
+/// k=300 this is about twice as fast as k single-vector calls. For k < 4
+/// the reflectors are applied one at a time.
+///
+/// @param[in]     a   The result of householder_qr (m-by-n, column-wise).
+/// @param[in]     b   The \f$\beta\f$ coefficients (size n).
+/// @param[in]     m   Number of rows of a and c.
+/// @param[in]     n   Number of columns of a.
+/// @param[in,out] c   The matrix C (column-wise, leading dimension ldc).
+/// @param[in]     ldc Leading dimension of c (\f$ldc \geq m\f$).
+/// @param[in]     k   Number of columns of C (right-hand sides).
+/// @param[in]     nb  Number of reflectors per block.
+/// @return        0 on success; any other value denotes an error (allocation
+///                failure).
+int
+qr_apply_qt(const double *__restrict__ a, const double *__restrict__ b, int m,
+    int n, double *__restrict__ c, int ldc, int k, int nb)
+{
+    qr_workspace ws;
+    return qr_apply_qt(a, b, m, n, c, ldc, k, ws, nb);
+}
+
+/// @brief Apply \f$Q^T\f$ of a QR factorization to a block of vectors,
+///        using a caller-provided workspace.
+///
+/// Same as qr_apply_qt; the workspace is only (re)allocated if it is smaller
+/// than qr_worksize(m, n, nb, k) (nothing is needed for k < 4).
+///
+/// @return 0 on success; any other value denotes an error (allocation
+///         failure).
+int
+qr_apply_qt(const double *__restrict__ a, const double *__restrict__ b, int m,
+    int n, double *__restrict__ c, int ldc, int k, qr_workspace &ws, int nb)
+noexcept
+{
+    return qr_apply_qt(matrix_view<const double>(a, m, n), b,
+        matrix_view<double>(c, m, k, ldc), ws, nb);
+}
+
+/// @brief Apply \f$Q^T\f$ of a QR factorization (of a column-major view) to
+///        the (column-major view) C.
+///
+/// Same as qr_apply_qt, for factorizations and right-hand sides that are
+/// blocks of larger matrices (e.g. the output of householder_qr_blocked on
+/// an aligned_matrix).
+///
+/// @return 0 on success; any other value denotes an error (C and a of
+///         different numbers of rows, or allocation failure).
+int
+qr_apply_qt(matrix_view<const double> av, const double *__restrict__ b,
+    matrix_view<double> cv, qr_workspace &ws, int nb)
+noexcept
+{
+    const int m = av.rows(), lda = av.ld(), k = cv.cols(), ldc = cv.ld();
+    const int kmax = std::min(m, av.cols());
+    const double *__restrict__ a = av.data();
+    double *__restrict__ c = cv.data();
+    double *t, *w, sum;
+    int i, j, jb, col, c0, nc;
+
+    if (cv.rows() != m) return 1;
+    if (k < 4) {
+        for (col = 0; col < k; col++) {
+            double *__restrict__ x = c + (long)col*ldc;
+            for (j = 0; j < kmax; j++) {
+                const double *__restrict__ aj = a + (long)j*lda;
+                for (sum = x[j], i = j+1; i < m; i++) sum += aj[i]*x[i];
+                sum *= b[j];
+                x[j] -= sum;
+                for (i = j+1; i < m; i++) x[i] -= sum*aj[i];
+            }
+        }
+        return 0;
+    }
+
+    if (nb < 1) nb = 1;
+    if (ws.reserve(nb*nb + block_reflector_worksize(nb,
+        std::min(k, qr_apply_cols)))) return 1;
+    t = ws.data();
+    w = t + nb*nb;
+
+    for (j = 0; j < kmax; j += nb) {
+        jb = std::min(nb, kmax-j);
+        const double *v = a + (long)j*lda + j;
+        block_reflector_t(v, lda, &b[j], m-j, jb, t, nb);
+        for (c0 = 0; c0 < k; c0 += qr_apply_cols) {
+            nc = std::min(qr_apply_cols, k-c0);
+            apply_block_reflector(true, v, lda, t, nb, m-j, jb,
+                c + (long)c0*ldc + j, ldc, nc, w);
+        }
+    }
+    return 0;
+}
+
+/// @brief Back substitution for multiple right-hand sides.
+///
+/// If \f$U\in {\Re}^{n\times n}\f$ is upper triangular (and nonsingular) and
+/// \f$B\in{\Re}^{n\times k}\f$, overwrite B with the solution X of
+/// \f$UX=B\f$; same as triangular_solve (single-threaded), for an upper
+/// triangular matrix.
+///
+/// @param[in]     u   Upper triangular matrix (column-wise, leading
+///                    dimension ldu).
+/// @param[in]     ldu Leading dimension of u (\f$ldu \geq n\f$).
+/// @param[in,out] b   The matrix B (column-wise, leading dimension ldb); at
+///                    output the solution X.
+/// @param[in]     ldb Leading dimension of b (\f$ldb \geq n\f$).
+/// @param[in]     n   Size of U.
+/// @param[in]     k   Number of right-hand sides (columns of B).
+/// @return        0 on success, 1 if U is singular (B is not modified).
+int
+back_substitution_multi(const double *__restrict__ u, int ldu,
+    double *__restrict__ b, int ldb, int n, int k)
+noexcept
+{
+    return triangular_solve(true, false, u, ldu, b, ldb, n, k);
+}
+
+/// Block size (rows/columns of the triangular matrix) of triangular_solve.
+constexpr int trsm_nb = 64;
+
+/// Right-hand sides processed at a time by (a thread of) triangular_solve.
+constexpr int trsm_nc = 64;
+
+/// @brief Unblocked triangular solve; one column of T at a time, for all
+///        nc right-hand sides (columns of B), rows/columns j0:j1 of T.
+static void
+trsm_diag(bool upper, bool unit, const double *__restrict__ t, int ldt,
+    double *__restrict__ b, int ldb, int j0, int j1, int nc)
+noexcept
+{
+    int i, j, col;
+    double xj;
+    for (col = 0; col < nc; col++) {
+        double *__restrict__ bc = b + (long)col*ldb;
+        if (upper) {
+            for (j = j1-1; j >= j0; j--) {
+                const double *__restrict__ tj = t + (long)j*ldt;
+                xj = unit ? bc[j] : (bc[j] /= tj[j]);
+                for (i = j0; i < j; i++) bc[i] -= xj*tj[i];
+            }
+        } else {
+            for (j = j0; j < j1; j++) {
+                const double *__restrict__ tj = t + (long)j*ldt;
+                xj = unit ? bc[j] : (bc[j] /= tj[j]);
+                for (i = j+1; i < j1; i++) bc[i] -= xj*tj[i];
+            }
+        }
+    }
+}
+
+/// @brief Blocked triangular solve of nc right-hand sides.
+///
+/// The diagonal blocks (trsm_nb-by-trsm_nb) of T are solved with
+/// trsm_diag; the solved block of rows of X is then eliminated from the
+/// remaining rows of B by a matrix-matrix product (gemm_nn_sub).
+static void
+trsm_blocked(bool upper, bool unit, const double *__restrict__ t, int ldt,
+    double *__restrict__ b, int ldb, int n, int nc)
+noexcept
+{
+    constexpr int nb = trsm_nb;
+    if (upper) {
+        for (int j0 = (n-1)/nb*nb; j0 >= 0; j0 -= nb) {
+            const int j1 = std::min(n, j0+nb);
+            trsm_diag(true, unit, t, ldt, b, ldb, j0, j1, nc);
+            // B(0:j0, :) -= T(0:j0, j0:j1) X(j0:j1, :)
+            if (j0 > 0) {
+                gemm_nn_sub(j0, j1-j0, nc, t + (long)j0*ldt, ldt, b + j0, ldb,
+                    b, ldb);
+            }
+        }
+    } else {
+        for (int j0 = 0; j0 < n; j0 += nb) {
+            const int j1 = std::min(n, j0+nb);
+            trsm_diag(false, unit, t, ldt, b, ldb, j0, j1, nc);
+            // B(j1:n, :) -= T(j1:n, j0:j1) X(j0:j1, :)
+            if (j1 < n) {
+                gemm_nn_sub(n-j1, j1-j0, nc, t + (long)j0*ldt + j1, ldt,
+                    b + j0, ldb, b + j1, ldb);
+            }
+        }
+    }
+}
+
+/// @brief Triangular solve with multiple right-hand sides (TRSM).
+///
+/// If \f$T\in {\Re}^{n\times n}\f$ is upper (or lower) triangular and
+/// \f$B\in{\Re}^{n\times k}\f$, overwrite B with the solution X of
+/// \f$TX=B\f$ (back, or forward, substitution).
+///
+/// For a few right-hand sides (k < 4), T is swept one column at a time.
+/// Otherwise the right-hand sides are processed trsm_nc at a time, and T in
+/// diagonal blocks of trsm_nb: once a block of rows of X is solved, it is
+/// eliminated from the rest of B with a (register-blocked) matrix-matrix
+/// product, so that most of the work runs at matrix-matrix speed and a
+/// block of T stays in cache while it is applied to all right-hand sides of
+/// a panel. The columns of B are independent, so they are split among
+/// num_threads threads (if a thread can not be created, its columns are
+/// solved by the calling thread).
+///
+/// @param[in]     upper       If true T is upper triangular, else lower
+///                            triangular; the other triangle is not
+///                            referenced.
+/// @param[in]     unit        If true T has a unit diagonal (which is not
+///                            referenced), e.g. the L factor of an LU
+///                            factorization.
+/// @param[in]     t           The matrix T (column-wise, leading dimension
+///                            ldt).
+/// @param[in]     ldt         Leading dimension of t (\f$ldt \geq n\f$).
+/// @param[in,out] b           The n-by-k matrix B (column-wise, leading
+///                            dimension ldb); at output the solution X.
+/// @param[in]     ldb         Leading dimension of b (\f$ldb \geq n\f$).
+/// @param[in]     n           Size of T.
+/// @param[in]     k           Number of right-hand sides (columns of B).
+/// @param[in]     num_threads Number of threads; if <= 0, then
+///                            std::thread::hardware_concurrency is used.
+/// @return        0 on success, 1 if T is singular (B is not modified).
+///
+/// Reference: Matrix Computations, G.H. Colub, CF.V. Loan, 1996, pg. 91-93
+int
+triangular_solve(bool upper, bool unit, const double *__restrict__ t,
+    int ldt, double *__restrict__ b, int ldb, int n, int k, int num_threads)
+noexcept
+{
+    if (!unit) {
+        for (int j = 0; j < n; j++) {
+            if (t[(long)j*ldt+j] == 0e0) return 1;
+        }
+    }
+    if (k < 4) {
+        trsm_diag(upper, unit, t, ldt, b, ldb, 0, n, k);
+        return 0;
+    }
+
+    const int npanels = (k + trsm_nc - 1) / trsm_nc;
+    const int nt = resolve_threads(num_threads, npanels);
+    auto worker = [=](int tid) {
+        // panels tid*npanels/nt ... (tid+1)*npanels/nt - 1
+        const int p0 = (long)npanels*tid/nt, p1 = (long)npanels*(tid+1)/nt;
+        for (int p = p0; p < p1; p++) {
+            const int c0 = p*trsm_nc, nc = std::min(trsm_nc, k-c0);
+            trsm_blocked(upper, unit, t, ldt, b + (long)c0*ldb, ldb, n, nc);
+        }
+    };
+
+    run_threads(nt, worker);
+    return 0;
+}
+
+/// @brief Solve a triangular system with multiple right-hand sides, given
+///        as (strided, column-major) matrix views.
+///
+/// Same as triangular_solve, with T the n-by-n view t and B the n-by-k view
+/// b (e.g. blocks of larger matrices).
+///
+/// @return 0 on success, 1 if the sizes do not match or T is singular.
+int
+triangular_solve(bool upper, bool unit, matrix_view<const double> t,
+    matrix_view<double> b, int num_threads)
+noexcept
+{
+    if (t.rows() != t.cols() || b.rows() != t.rows()) return 1;
+    return triangular_solve(upper, unit, t.data(), t.ld(), b.data(), b.ld(),
+        t.rows(), b.cols(), num_threads);
+}
+
+/// @brief Householder-QR LS solution for multiple right-hand sides.
+///
+/// Given the QR factorization of the design matrix \f$A\in{\Re}^{m\times n}\f$
+/// (of full column rank), as computed by householder_qr or
+/// householder_qr_blocked, solve the k LS problems \f$min\|Ax_i-b_i\|\f$,
+/// i.e. factorize once, solve for any number of observation vectors.
+///
+/// @param[in]     a   The result of householder_qr (m-by-n, column-wise).
+/// @param[in]     b   The \f$\beta\f$ coefficients (size n).
+/// @param[in]     m   Number of observations (rows of a).
+/// @param[in]     n   Number of parameters (columns of a).
+/// @param[in,out] y   The m-by-k matrix of observation vectors (column-wise,
+///                    leading dimension ldy). At output, the first n rows
+///                    of each column hold the LS solution.
+/// @param[in]     ldy Leading dimension of y (\f$ldy \geq m\f$).
+/// @param[in]     k   Number of right-hand sides (columns of y).
+/// @return        0 on success; any other value denotes an error (allocation
+///                failure, or R is singular, in which case the first n rows
+///                of y hold \f$Q^T y\f$).
+int
+ls_qrsolve_multi(const double *__restrict__ a, const double *__restrict__ b,
+    int m, int n, double *__restrict__ y, int ldy, int k)
+{
+    qr_workspace ws;
+    return ls_qrsolve_multi(a, b, m, n, y, ldy, k, ws);
+}
+
+/// @brief Householder-QR LS solution for multiple right-hand sides, using a
+///        caller-provided workspace.
+///
+/// Same as ls_qrsolve_multi; the workspace is only (re)allocated if it is
+/// smaller than qr_worksize(m, n, 32, k).
+///
+/// @return 0 on success; any other value denotes an error (allocation
+///         failure, or R is singular).
+int
+ls_qrsolve_multi(const double *__restrict__ a, const double *__restrict__ b,
+    int m, int n, double *__restrict__ y, int ldy, int k, qr_workspace &ws)
+noexcept
+{
+    if (qr_apply_qt(a, b, m, n, y, ldy, k, ws)) return 1;
+    return back_substitution_multi(a, m, y, ldy, n, k);
 }
@@ -1,8 +1,18 @@
+#ifndef __QR_HPP__
+#define __QR_HPP__
+
+#include <new>
+#include <vector>
+#include "matrix_view.hpp"
+
 /// @brief This file contains algorithms connected to QR factorization.
 ///
 /// @note
 ///     - All matrix/vector indexes start from 0.
 ///     - Unless otherwise stated, all matrices are stored in column-major form.
+///     - The main routines have overloads taking matrix views (see
+///       matrix_view.hpp), i.e. blocks of larger matrices and, where noted,
+///       row-major matrices.
 ///
 
 ///
@@ -37,6 +47,53 @@
 /// by the upper triangular system \f$R_1 x_{LS} = c\f$. 
 ///
 
+/// @brief Reusable workspace for the QR routines.
+///
+/// The overloads of householder_qr, householder_qr_blocked,
+/// householder_qr_pivot, thin_q, qr_apply_qt, ls_qrsolve, ls_qrsolve_pivot
+/// and ls_qrsolve_multi that take a qr_workspace draw all their temporary
+/// storage from it, growing it only when it is too small (see qr_worksize).
+/// Reusing one workspace over calls (of the same or smaller size) thus
+/// means no heap allocation after the first call. A workspace can be moved between
+/// threads, but must not be used by two threads at the same time; use one
+/// per thread.
+class qr_workspace
+{
+public:
+    qr_workspace() noexcept = default;
+
+    /// Construct with (at least) size doubles; may throw std::bad_alloc.
+    explicit
+    qr_workspace(int size)
+    : _buf(size)
+    {}
+
+    /// Make sure the workspace holds at least size doubles.
+    /// @return 0 on success, 1 on allocation failure.
+    int
+    reserve(int size) noexcept
+    {
+        if (static_cast<int>(_buf.size()) >= size) return 0;
+        try {
+            _buf.resize(size);
+        } catch (std::bad_alloc&) {
+            return 1;
+        }
+        return 0;
+    }
+
+    double*
+    data() noexcept
+    { return _buf.data(); }
+
+    int
+    size() const noexcept
+    { return static_cast<int>(_buf.size()); }
+
+private:
+    std::vector<double> _buf;
+};
+
 void
 back_substitution(const double *__restrict__ u, double *__restrict__ b, int n)
 noexcept;
@@ -49,8 +106,162 @@ void
 householder_qr(double *__restrict__ a, double *__restrict__ b, int m, int n, int &sign)
 noexcept;
 
+int
+householder_qr(double *__restrict__ a, double *__restrict__ b, int m, int n,
+    qr_workspace &ws)
+noexcept;
+
+int
+householder_qr(matrix_view<double> a, double *__restrict__ b,
+    qr_workspace &ws)
+noexcept;
+
+int
+householder_qr(matrix_view<double, matrix_layout::row_major> a,
+    double *__restrict__ b, qr_workspace &ws)
+noexcept;
+
+void
+householder_qr_panel(double *__restrict__ a, int lda, double *__restrict__ b,
+    int m, int n, double *__restrict__ u)
+noexcept;
+
+/// Rows of V processed at a time by apply_block_reflector.
+constexpr int block_reflector_rows = 512;
+
+/// Workspace size (number of doubles) needed by apply_block_reflector, for
+/// k Householder vectors and nc columns.
+constexpr int
+block_reflector_worksize(int k, int nc) noexcept
+{ return k*nc; }
+
+/// Columns of C processed at a time (per apply_block_reflector call) by
+/// qr_apply_qt.
+constexpr int qr_apply_cols = 256;
+
+/// Workspace size (number of doubles) needed by the qr_workspace overloads,
+/// for an m-by-n matrix, a block size nb (householder_qr_blocked,
+/// qr_apply_qt) and k right-hand sides (qr_apply_qt, ls_qrsolve_multi).
+constexpr int
+qr_worksize(int m, int n, int nb = 32, int k = 1) noexcept
+{
+    return m + 7*n + 4 + nb*nb
+        + block_reflector_worksize(nb, std::max(n, std::min(k, qr_apply_cols)));
+}
+
+void
+block_reflector_t(const double *__restrict__ v, int ldv,
+    const double *__restrict__ b, int m, int k, double *__restrict__ t,
+    int ldt)
+noexcept;
+
+void
+apply_block_reflector(bool trans, const double *__restrict__ v, int ldv,
+    const double *__restrict__ t, int ldt, int m, int k,
+    double *__restrict__ c, int ldc, int nc, double *__restrict__ w)
+noexcept;
+
 void
+householder_qr_blocked(double *__restrict__ a, double *__restrict__ b, int m,
+    int n, int &sign, int nb = 32)
+noexcept;
+
+int
+householder_qr_blocked(double *__restrict__ a, double *__restrict__ b, int m,
+    int n, qr_workspace &ws, int nb = 32)
+noexcept;
+
+int
+householder_qr_blocked(matrix_view<double> a, double *__restrict__ b,
+    qr_workspace &ws, int nb = 32)
+noexcept;
+
+int
 ls_qrsolve(double *__restrict__ a, double *__restrict__ b, int m, int n);
 
+int
+ls_qrsolve(double *__restrict__ a, double *__restrict__ b, int m, int n,
+    qr_workspace &ws)
+noexcept;
+
+int
+ls_qrsolve(matrix_view<double> a, double *__restrict__ b, qr_workspace &ws)
+noexcept;
+
+int
+ls_qrsolve(matrix_view<double, matrix_layout::row_major> a,
+    double *__restrict__ b, qr_workspace &ws)
+noexcept;
+
 void
+householder_qr_pivot(double *__restrict__ a, double *__restrict__ b,
+    int *__restrict__ perm, int m, int n, int &rank, int &sign,
+    double tol = 0e0)
+noexcept;
+
+int
+householder_qr_pivot(double *__restrict__ a, double *__restrict__ b,
+    int *__restrict__ perm, int m, int n, int &rank, qr_workspace &ws,
+    double tol = 0e0)
+noexcept;
+
+int
+ls_qrsolve_pivot(double *__restrict__ a, double *__restrict__ b,
+    double *__restrict__ x, int m, int n, int &rank, bool min_norm = true,
+    double tol = 0e0);
+
+int
+ls_qrsolve_pivot(double *__restrict__ a, double *__restrict__ b,
+    double *__restrict__ x, int m, int n, int &rank, qr_workspace &ws,
+    bool min_norm = true, double tol = 0e0)
+noexcept;
+
+int
+qr_apply_qt(const double *__restrict__ a, const double *__restrict__ b, int m,
+    int n, double *__restrict__ c, int ldc, int k, int nb = 32);
+
+int
+qr_apply_qt(const double *__restrict__ a, const double *__restrict__ b, int m,
+    int n, double *__restrict__ c, int ldc, int k, qr_workspace &ws,
+    int nb = 32)
+noexcept;
+
+int
+qr_apply_qt(matrix_view<const double> a, const double *__restrict__ b,
+    matrix_view<double> c, qr_workspace &ws, int nb = 32)
+noexcept;
+
+int
+back_substitution_multi(const double *__restrict__ u, int ldu,
+    double *__restrict__ b, int ldb, int n, int k)
+noexcept;
+
+int
+triangular_solve(bool upper, bool unit, const double *__restrict__ t,
+    int ldt, double *__restrict__ b, int ldb, int n, int k,
+    int num_threads = 1)
+noexcept;
+
+int
+triangular_solve(bool upper, bool unit, matrix_view<const double> t,
+    matrix_view<double> b, int num_threads = 1)
+noexcept;
+
+int
+ls_qrsolve_multi(const double *__restrict__ a, const double *__restrict__ b,
+    int m, int n, double *__restrict__ y, int ldy, int k);
+
+int
+ls_qrsolve_multi(const double *__restrict__ a, const double *__restrict__ b,
+    int m, int n, double *__restrict__ y, int ldy, int k, qr_workspace &ws)
+noexcept;
+
+int
 thin_q(double *__restrict__ a, double *__restrict__ b, double *__restrict__ q, int m, int n);
+
+int
+thin_q(const double *__restrict__ a, const double *__restrict__ b,
+    double *__restrict__ q, int m, int n, qr_workspace &ws)
+noexcept;
+
+#endif
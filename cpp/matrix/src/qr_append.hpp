@@ -0,0 +1,52 @@
+#ifndef __QR_APPEND_HPP__
+#define __QR_APPEND_HPP__
+
+#include <cmath>
+
+/// @brief Triangularise \f$[R\ z; X\ y]\f$, i.e. append k rows to the
+///        upper triangular \f$[R\ z]\f$, via Householder reflections.
+///
+/// The j-th Householder vector is \f$[e_j; v_j]\f$, so it only touches row
+/// j of \f$[R\ z]\f$ and R stays triangular throughout; this costs
+/// \f$O(kn^2)\f$. Used by updatable_qr::add_rows and srif::absorb_rows.
+///
+/// @param[in,out] r   The n-by-n upper triangular R (column-wise, leading
+///                    dimension ldr); only the upper triangle is referenced.
+/// @param[in]     ldr Leading dimension of r (\f$ldr \geq n\f$).
+/// @param[in,out] z   The n-vector z.
+/// @param[in,out] x   The k-by-(n+1) matrix \f$[X\ y]\f$ (column-wise,
+///                    leading dimension k); at output the Householder
+///                    vectors \f$v_j\f$, and in its last column what is left
+///                    of y (the residuals of the k rows).
+/// @param[in]     k   Number of rows appended.
+/// @param[in]     n   Size of R.
+inline void
+qr_append_rows(double *__restrict__ r, int ldr, double *__restrict__ z,
+    double *__restrict__ x, int k, int n)
+noexcept
+{
+    double sum, mu, v0, beta, s, x0;
+    int i, j, l;
+    for (j = 0; j < n; j++) {
+        double *__restrict__ xj = x + (long)j*k;
+        for (sum = 0e0, i = 0; i < k; i++) sum += xj[i]*xj[i];
+        if (sum == 0e0) continue;
+        x0   = r[(long)j*ldr+j];
+        mu   = std::sqrt(x0*x0+sum);
+        v0   = (x0 <= 0e0) ? (x0-mu) : (-sum/(x0+mu));
+        beta = 2e0*v0*v0/(sum+v0*v0);
+        for (i = 0; i < k; i++) xj[i] /= v0;
+        r[(long)j*ldr+j] = mu;
+        // apply to the remaining columns and to [z; y]
+        for (l = j+1; l <= n; l++) {
+            double *__restrict__ xl = x + (long)l*k;
+            double &top = (l < n) ? r[(long)l*ldr+j] : z[j];
+            for (s = top, i = 0; i < k; i++) s += xj[i]*xl[i];
+            s *= beta;
+            top -= s;
+            for (i = 0; i < k; i++) xl[i] -= s*xj[i];
+        }
+    }
+}
+
+#endif
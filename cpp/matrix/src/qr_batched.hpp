@@ -0,0 +1,202 @@
+#ifndef __QR_BATCHED_HPP__
+#define __QR_BATCHED_HPP__
+
+#include <cmath>
+#include <algorithm>
+
+/// @brief Batched QR/LS for many small, independent problems.
+///
+/// Problems of the same shape (m-by-n, \f$m \geq n\f$) are processed in
+/// groups of L, stored interleaved: element (i,j) of the design matrix of
+/// problem p of a group is at a[(j*m+i)*L+p] and element i of its
+/// observation vector at b[i*L+p]. Every scalar operation of householder_qr
+/// (and of the back substitution) thus becomes a loop of fixed length L over
+/// contiguous memory, which the compiler maps to a few vector instructions,
+/// one lane per problem. The algorithms are branch-free per lane (so that
+/// all lanes follow the same instruction stream) and need no workspace, i.e.
+/// no heap allocation.
+///
+/// Choose L as a multiple of the SIMD width (in doubles): 4 for AVX2, 8 for
+/// AVX-512, and compile with vectorization enabled (e.g. -O3 -march=native).
+/// A singular problem only yields inf/nan in its own lane.
+///
+/// @example test_qr_batched.cpp
+
+/// Interleave nprob column-wise m-by-n matrices (stored one after the other,
+/// each of size m*n) into groups of L; the output must have space for
+/// ceil(nprob/L)*L*m*n elements. Lanes of the last group that have no
+/// problem are filled with (copies of) the last problem. For vectors use
+/// n=1.
+template<int L>
+    void
+    batch_interleave(const double *__restrict__ in, int m, int n, int nprob,
+        double *__restrict__ out)
+    noexcept
+{
+    const int mn = m*n, ngroups = (nprob+L-1)/L;
+    for (int g = 0; g < ngroups; g++) {
+        double *__restrict__ og = out + (long)g*mn*L;
+        for (int p = 0; p < L; p++) {
+            const double *__restrict__ ip = in + (long)std::min(g*L+p, nprob-1)*mn;
+            for (int e = 0; e < mn; e++) og[e*L+p] = ip[e];
+        }
+    }
+}
+
+/// The inverse of batch_interleave, for the first mo rows of every
+/// (column-wise, m-by-n) matrix; the output holds nprob mo-by-n matrices,
+/// one after the other.
+template<int L>
+    void
+    batch_deinterleave(const double *__restrict__ in, int m, int n, int mo,
+        int nprob, double *__restrict__ out)
+    noexcept
+{
+    for (int q = 0; q < nprob; q++) {
+        const double *__restrict__ ig = in + (long)(q/L)*m*n*L;
+        const int p = q % L;
+        for (int j = 0; j < n; j++) {
+            for (int i = 0; i < mo; i++) out[((long)q*n+j)*mo+i] = ig[(j*m+i)*L+p];
+        }
+    }
+}
+
+/// @brief Householder QR of a group of L interleaved matrices.
+///
+/// Same algorithm and output (per lane) as householder_qr: R in the upper
+/// triangle, the Householder vectors (with implicit unit first element)
+/// below it and their \f$\beta\f$ coefficients, interleaved, in b.
+///
+/// @param[in,out] a The group of L m-by-n matrices (interleaved).
+/// @param[out]    b Array of size n*L; at output the \f$\beta\f$
+///                  coefficients (b[j*L+p] for column j of problem p).
+/// @param[in]     m Number of rows.
+/// @param[in]     n Number of columns (\f$m \geq n\f$).
+template<int L>
+    void
+    householder_qr_batch(double *__restrict__ a, double *__restrict__ b,
+        int m, int n)
+    noexcept
+{
+    double sigma[L], mu[L], scale[L], s[L];
+    int    i, j, c, p;
+
+    for (c = 0; c < n; c++) {
+        double *__restrict__ ac = a + (long)c*m*L;
+        double *__restrict__ bc = b + c*L;
+        // Householder vector of A(c:m, c), as in householder_vec
+        for (p = 0; p < L; p++) sigma[p] = 0e0;
+        for (i = c+1; i < m; i++) {
+            for (p = 0; p < L; p++) sigma[p] += ac[i*L+p]*ac[i*L+p];
+        }
+        for (p = 0; p < L; p++) {
+            const double x0 = ac[c*L+p];
+            mu[p] = std::sqrt(x0*x0+sigma[p]);
+            const double v0 = (x0 <= 0e0) ? (x0-mu[p]) : (-sigma[p]/(x0+mu[p]));
+            const bool   nul = (sigma[p] == 0e0);
+            bc[p]    = nul ? 0e0 : 2e0*v0*v0/(sigma[p]+v0*v0);
+            scale[p] = nul ? 1e0 : 1e0/v0;
+            ac[c*L+p] = nul ? x0 : mu[p];
+        }
+        for (i = c+1; i < m; i++) {
+            for (p = 0; p < L; p++) ac[i*L+p] *= scale[p];
+        }
+        // A(c:m, c+1:n) = (I-buu^T)A(c:m, c+1:n)
+        for (j = c+1; j < n; j++) {
+            double *__restrict__ aj = a + (long)j*m*L;
+            for (p = 0; p < L; p++) s[p] = aj[c*L+p];
+            for (i = c+1; i < m; i++) {
+                for (p = 0; p < L; p++) s[p] += ac[i*L+p]*aj[i*L+p];
+            }
+            for (p = 0; p < L; p++) {
+                s[p] *= bc[p];
+                aj[c*L+p] -= s[p];
+            }
+            for (i = c+1; i < m; i++) {
+                for (p = 0; p < L; p++) aj[i*L+p] -= s[p]*ac[i*L+p];
+            }
+        }
+    }
+}
+
+/// @brief Householder-QR LS solution of a group of L interleaved problems.
+///
+/// Per lane, the same as ls_qrsolve: factor A, compute \f$Q^T y\f$ and solve
+/// \f$R_1 x = c\f$.
+///
+/// @param[in,out] a The group of L m-by-n design matrices (interleaved); at
+///                  output their QR factorizations.
+/// @param[in,out] y The group of L observation vectors (interleaved, size
+///                  m*L); at output, the first n*L elements hold the
+///                  (interleaved) LS solutions.
+/// @param[out]    b Array of size n*L; at output the \f$\beta\f$
+///                  coefficients.
+/// @param[in]     m Number of observations.
+/// @param[in]     n Number of parameters (\f$m \geq n\f$).
+template<int L>
+    void
+    ls_qrsolve_batch(double *__restrict__ a, double *__restrict__ y,
+        double *__restrict__ b, int m, int n)
+    noexcept
+{
+    double s[L];
+    int    i, j, p;
+
+    householder_qr_batch<L>(a, b, m, n);
+
+    // y <- (Q^T)*y
+    for (j = 0; j < n; j++) {
+        const double *__restrict__ aj = a + (long)j*m*L;
+        for (p = 0; p < L; p++) s[p] = y[j*L+p];
+        for (i = j+1; i < m; i++) {
+            for (p = 0; p < L; p++) s[p] += aj[i*L+p]*y[i*L+p];
+        }
+        for (p = 0; p < L; p++) {
+            s[p] *= b[j*L+p];
+            y[j*L+p] -= s[p];
+        }
+        for (i = j+1; i < m; i++) {
+            for (p = 0; p < L; p++) y[i*L+p] -= s[p]*aj[i*L+p];
+        }
+    }
+
+    // Solve R(1:n,1:n) * x = y(1:n)
+    for (j = n-1; j >= 0; j--) {
+        const double *__restrict__ aj = a + (long)j*m*L;
+        for (p = 0; p < L; p++) y[j*L+p] /= aj[j*L+p];
+        for (i = 0; i < j; i++) {
+            for (p = 0; p < L; p++) y[i*L+p] -= y[j*L+p]*aj[i*L+p];
+        }
+    }
+}
+
+/// @brief Householder-QR LS solution of many small problems.
+///
+/// Run ls_qrsolve_batch<L> on ngroups consecutive groups of interleaved
+/// problems (see batch_interleave); group g starts at a+g*m*n*L and
+/// y+g*m*L. No memory is allocated.
+///
+/// @param[in,out] a       The groups of design matrices.
+/// @param[in,out] y       The groups of observation vectors; at output the
+///                        first n*L elements of every group hold the LS
+///                        solutions.
+/// @param[in]     m       Number of observations.
+/// @param[in]     n       Number of parameters (\f$m \geq n\f$, n <= 64).
+/// @param[in]     ngroups Number of groups (of L problems).
+/// @return        0 on success, 1 if n is larger than 64.
+template<int L>
+    int
+    ls_qrsolve_batched(double *__restrict__ a, double *__restrict__ y, int m,
+        int n, long ngroups)
+    noexcept
+{
+    constexpr int nmax = 64;
+    double b[nmax*L];
+    if (n > nmax) return 1;
+    for (long g = 0; g < ngroups; g++) {
+        ls_qrsolve_batch<L>(a + g*m*n*L, y + g*m*L, b, m, n);
+    }
+    return 0;
+}
+
+#endif
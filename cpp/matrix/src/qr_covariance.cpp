@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <vector>
+#include "qr_covariance.hpp"
+#include "gemm_kernels.hpp"
+#include "run_threads.hpp"
+
+namespace {
+
+/// Tile size of the product \f$L^T L\f$.
+constexpr int cov_tile = 64;
+
+/// Dot product, accumulated in 4 partial sums.
+inline double
+cov_dot(const double *__restrict__ x, const double *__restrict__ y, int len)
+noexcept
+{
+    double s0 = 0e0, s1 = 0e0, s2 = 0e0, s3 = 0e0;
+    int i;
+    for (i = 0; i + 4 <= len; i += 4) {
+        s0 += x[i]*y[i];
+        s1 += x[i+1]*y[i+1];
+        s2 += x[i+2]*y[i+2];
+        s3 += x[i+3]*y[i+3];
+    }
+    for (; i < len; i++) s0 += x[i]*y[i];
+    return (s0+s1) + (s2+s3);
+}
+
+/// Row i of \f$R^{-1}\f$: solve \f$R^T y = e_i\f$ by forward substitution;
+/// at output y[i..n) holds \f$R^{-1}(i, i:n)\f$ (y[0..i) is not touched).
+inline void
+r_inverse_row(const double *__restrict__ r, int ldr, int n, int i,
+    double *__restrict__ y)
+noexcept
+{
+    y[i] = 1e0 / r[(long)i*ldr+i];
+    for (int l = i+1; l < n; l++) {
+        const double *__restrict__ rl = r + (long)l*ldr;
+        y[l] = -cov_dot(rl+i, y+i, l-i) / rl[l];
+    }
+}
+
+/// 0 if R has a nonzero diagonal, else 1.
+inline int
+r_singular(const double *__restrict__ r, int ldr, int n) noexcept
+{
+    for (int i = 0; i < n; i++) {
+        if (r[(long)i*ldr+i] == 0e0) return 1;
+    }
+    return 0;
+}
+
+} // namespace
+
+/// @brief Inverse of an upper triangular matrix.
+///
+/// Compute \f$R^{-1}\f$ (upper triangular), column by column: column j is
+/// \f$-R^{-1}(0:j, 0:j) R(0:j, j) / r_{jj}\f$, using the columns already
+/// computed. ri may be the same as r (with ldri = ldr), in which case R is
+/// overwritten by its inverse. The strictly lower triangle is not
+/// referenced.
+///
+/// @param[in]  r    The n-by-n upper triangular R (column-wise, leading
+///                  dimension ldr).
+/// @param[in]  ldr  Leading dimension of r (\f$ldr \geq n\f$).
+/// @param[out] ri   At output, \f$R^{-1}\f$ in the upper triangle.
+/// @param[in]  ldri Leading dimension of ri (\f$ldri \geq n\f$).
+/// @param[in]  n    Size of R.
+/// @return     0 on success, 1 if R is singular (ri is not modified).
+///
+/// Reference: LAPACK, dtrti2
+int
+r_inverse(const double *r, int ldr, double *ri, int ldri, int n)
+noexcept
+{
+    if (r_singular(r, ldr, n)) return 1;
+    for (int j = 0; j < n; j++) {
+        double *x = ri + (long)j*ldri;
+        const double *rj = r + (long)j*ldr;
+        if (x != rj) std::copy(rj, rj+j, x);
+        const double ajj = -1e0 / rj[j];
+        x[j] = -ajj;
+        // x = R^{-1}(0:j, 0:j) * x
+        for (int l = 0; l < j; l++) {
+            const double *rl = ri + (long)l*ldri;
+            const double t = x[l];
+            for (int i = 0; i < l; i++) x[i] += t*rl[i];
+            x[l] = t*rl[l];
+        }
+        for (int i = 0; i < j; i++) x[i] *= ajj;
+    }
+    return 0;
+}
+
+/// @brief Covariance matrix \f$scale \cdot (R^T R)^{-1}\f$.
+///
+/// Form \f$L = R^{-T}\f$ (one forward substitution per column) and then
+/// \f$L^T L\f$ by 64-by-64 tiles of its upper triangle, each of which is a
+/// product of two (trapezoidal) panels of L; both the columns and the tiles
+/// are spread over num_threads threads. The full (symmetric) matrix is
+/// written.
+///
+/// @param[in]  r           The n-by-n upper triangular R (column-wise,
+///                         leading dimension ldr).
+/// @param[in]  ldr         Leading dimension of r (\f$ldr \geq n\f$).
+/// @param[out] cov         At output the n-by-n covariance matrix
+///                         (column-wise, leading dimension ldcov).
+/// @param[in]  ldcov       Leading dimension of cov (\f$ldcov \geq n\f$).
+/// @param[in]  n           Size of R.
+/// @param[in]  scale       Scale factor, e.g. the a-posteriori variance
+///                         factor.
+/// @param[in]  num_threads Number of threads; if <= 0, then
+///                         std::thread::hardware_concurrency is used.
+/// @return     0 on success; 1 if R is singular or on allocation failure.
+int
+r_covariance(const double *__restrict__ r, int ldr, double *__restrict__ cov,
+    int ldcov, int n, double scale, int num_threads)
+{
+    if (r_singular(r, ldr, n)) return 1;
+    const int nt = resolve_threads(num_threads);
+    const int ntiles = (n + cov_tile - 1) / cov_tile;
+    std::vector<double> lt;
+    try {
+        lt.assign((long)n*n, 0e0);
+    } catch (std::bad_alloc&) {
+        return 1;
+    }
+    double *__restrict__ l = lt.data();
+
+    // L = R^{-T}; column i of L is row i of R^{-1} (zero above the
+    // diagonal). The first columns are the most expensive.
+    std::atomic<int> next {0};
+    run_threads(std::min(nt, n), [&](int) {
+        int i;
+        while ((i = next.fetch_add(1)) < n) r_inverse_row(r, ldr, n, i, l + (long)i*n);
+    });
+
+    // cov(I,J) = L(J0:n, I)^T L(J0:n, J), for tiles I <= J
+    const int npairs = ntiles*(ntiles+1)/2;
+    std::atomic<int> nextp {0};
+    std::atomic<int> failed {0};
+    run_threads(std::min(nt, npairs), [&](int) {
+        std::vector<double> w;
+        try {
+            w.resize(cov_tile*cov_tile);
+        } catch (std::bad_alloc&) {
+            failed = 1;
+            return;
+        }
+        int p;
+        while ((p = nextp.fetch_add(1)) < npairs) {
+            // pair p -> (ti, tj), ti <= tj, column-wise over the upper
+            // triangle of tiles
+            int tj = 0;
+            while ((tj+1)*(tj+2)/2 <= p) tj++;
+            const int ti = p - tj*(tj+1)/2;
+            const int i0 = ti*cov_tile, ni = std::min(cov_tile, n-i0);
+            const int j0 = tj*cov_tile, nj = std::min(cov_tile, n-j0);
+            std::fill(w.begin(), w.begin()+ni*nj, 0e0);
+            gemm_tn_acc(n-j0, ni, nj, l + (long)i0*n + j0, n,
+                l + (long)j0*n + j0, n, w.data(), ni);
+            for (int j = 0; j < nj; j++) {
+                for (int i = 0; i < ni; i++) {
+                    const double c = scale*w[j*ni+i];
+                    cov[(long)(j0+j)*ldcov + i0+i] = c;
+                    cov[(long)(i0+i)*ldcov + j0+j] = c;
+                }
+            }
+        }
+    });
+    return failed;
+}
+
+/// @brief Diagonal of the covariance matrix \f$scale \cdot (R^T R)^{-1}\f$.
+///
+/// The variance of parameter i is \f$scale \cdot \|R^{-1}(i,:)\|^2\f$; each
+/// row of \f$R^{-1}\f$ is computed (by a forward substitution) and
+/// discarded, so that only n doubles per thread are allocated. The rows are
+/// spread over num_threads threads.
+///
+/// @param[in]  r           The n-by-n upper triangular R (column-wise,
+///                         leading dimension ldr).
+/// @param[in]  ldr         Leading dimension of r (\f$ldr \geq n\f$).
+/// @param[out] d           At output the n variances.
+/// @param[in]  n           Size of R.
+/// @param[in]  scale       Scale factor, e.g. the a-posteriori variance
+///                         factor.
+/// @param[in]  num_threads Number of threads; if <= 0, then
+///                         std::thread::hardware_concurrency is used.
+/// @return     0 on success; 1 if R is singular or on allocation failure.
+int
+r_covariance_diag(const double *__restrict__ r, int ldr,
+    double *__restrict__ d, int n, double scale, int num_threads)
+{
+    if (r_singular(r, ldr, n)) return 1;
+    const int nt = std::min(resolve_threads(num_threads), n);
+    std::atomic<int> next {0};
+    std::atomic<int> failed {0};
+    run_threads(nt, [&](int) {
+        std::vector<double> y;
+        try {
+            y.resize(n);
+        } catch (std::bad_alloc&) {
+            failed = 1;
+            return;
+        }
+        int i;
+        while ((i = next.fetch_add(1)) < n) {
+            r_inverse_row(r, ldr, n, i, y.data());
+            d[i] = scale*cov_dot(y.data()+i, y.data()+i, n-i);
+        }
+    });
+    return failed;
+}
+
+/// @brief Diagonal block of the covariance matrix
+///        \f$scale \cdot (R^T R)^{-1}\f$.
+///
+/// Compute the k-by-k block of the covariance matrix for parameters
+/// \f$i_0, ..., i_0+k-1\f$, from the rows \f$i_0, ..., i_0+k-1\f$ of
+/// \f$R^{-1}\f$ (only their parts from column \f$i_0\f$ on are nonzero).
+///
+/// @param[in]  r     The n-by-n upper triangular R (column-wise, leading
+///                   dimension ldr).
+/// @param[in]  ldr   Leading dimension of r (\f$ldr \geq n\f$).
+/// @param[in]  n     Size of R.
+/// @param[in]  i0    First parameter of the block.
+/// @param[in]  k     Size of the block (\f$i_0+k \leq n\f$).
+/// @param[out] cov   At output the k-by-k block (column-wise, leading
+///                   dimension ldcov).
+/// @param[in]  ldcov Leading dimension of cov (\f$ldcov \geq k\f$).
+/// @param[in]  scale Scale factor, e.g. the a-posteriori variance factor.
+/// @return     0 on success; 1 if R is singular, on invalid block or on
+///             allocation failure.
+int
+r_covariance_block(const double *__restrict__ r, int ldr, int n, int i0,
+    int k, double *__restrict__ cov, int ldcov, double scale)
+{
+    if (i0 < 0 || k < 1 || i0+k > n) return 1;
+    if (r_singular(r, ldr, n)) return 1;
+    const int m = n - i0;
+    std::vector<double> lt, w;
+    try {
+        lt.assign((long)m*k, 0e0);
+        w.assign(k*k, 0e0);
+    } catch (std::bad_alloc&) {
+        return 1;
+    }
+    // columns of L(i0:n, i0:i0+k), i.e. rows of R^{-1}(., i0:n)
+    for (int q = 0; q < k; q++) {
+        r_inverse_row(r + (long)i0*ldr + i0, ldr, m, q, lt.data() + (long)q*m);
+    }
+    gemm_tn_acc(m, k, k, lt.data(), m, lt.data(), m, w.data(), k);
+    for (int j = 0; j < k; j++) {
+        for (int i = 0; i < k; i++) cov[j*ldcov+i] = scale*w[j*k+i];
+    }
+    return 0;
+}
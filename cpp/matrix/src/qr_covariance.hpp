@@ -0,0 +1,46 @@
+#ifndef __QR_COVARIANCE_HPP__
+#define __QR_COVARIANCE_HPP__
+
+/// @brief Covariance matrix of a LS solution, from the R factor.
+///
+/// For a LS system solved via QR (see qr.hpp), the covariance matrix of the
+/// solution is \f$\sigma^2 (A^T A)^{-1} = \sigma^2 (R^T R)^{-1} =
+/// \sigma^2 R^{-1} R^{-T}\f$, i.e. it is formed from the n-by-n upper
+/// triangular factor R alone, without a general matrix inversion:
+///   - r_inverse computes \f$R^{-1}\f$ (in place, if wanted), in
+///     \f$n^3/3\f$ flops,
+///   - r_covariance forms \f$L = R^{-T}\f$, whose column i (the row i of
+///     \f$R^{-1}\f$) only depends on R and is found by a forward
+///     substitution, and then the (upper triangle, by tiles, of
+///     the) product \f$L^T L\f$; in all, \f$n^3/2\f$ flops, instead of
+///     the \f$n^3/3\f$ of the inverse plus \f$n^3\f$ of a general product,
+///   - r_covariance_diag computes only the variances, i.e. the squared norms
+///     of the rows of \f$R^{-1}\f$, in \f$n^3/6\f$ flops and \f$O(n)\f$
+///     memory (per thread),
+///   - r_covariance_block computes a k-by-k diagonal block (e.g. the
+///     coordinates of one point), in \f$O(k(n-i_0)^2)\f$ flops.
+/// The columns of L, the rows of \f$R^{-1}\f$ and the tiles of the product
+/// are independent of each other, so r_covariance and r_covariance_diag
+/// spread them over num_threads threads.
+///
+/// Standard errors are the square roots of the (scaled) diagonal.
+///
+/// @example test_qr_covariance.cpp
+
+int
+r_inverse(const double *r, int ldr, double *ri, int ldri, int n)
+noexcept;
+
+int
+r_covariance(const double *__restrict__ r, int ldr, double *__restrict__ cov,
+    int ldcov, int n, double scale = 1e0, int num_threads = 1);
+
+int
+r_covariance_diag(const double *__restrict__ r, int ldr,
+    double *__restrict__ d, int n, double scale = 1e0, int num_threads = 1);
+
+int
+r_covariance_block(const double *__restrict__ r, int ldr, int n, int i0,
+    int k, double *__restrict__ cov, int ldcov, double scale = 1e0);
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef __QR_FIXED_HPP__
+#define __QR_FIXED_HPP__
+
+#include <cmath>
+
+/// @brief Householder QR and LS for matrices with compile-time dimensions.
+///
+/// householder_qr<M,N> and ls_qrsolve<M,N> implement the same algorithms
+/// (and produce the same output) as householder_qr and ls_qrsolve, for an
+/// M-by-N matrix (column-wise, \f$M \geq N\f$) known at compile time.
+/// The arrays are passed by reference (so they can live on the stack), no
+/// workspace is allocated (the Householder vector is formed in place) and,
+/// since all trip counts are compile-time constants, the inner loops are
+/// fully unrolled.
+///
+/// Both are constexpr, i.e. they can be evaluated at compile time (e.g. for
+/// constant design matrices); at run time std::sqrt is used.
+///
+/// @example test_qr_fixed.cpp
+
+/// Ask the compiler to fully unroll the following loop.
+#if defined(__clang__)
+#define QR_FIXED_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+#define QR_FIXED_UNROLL _Pragma("GCC unroll 64")
+#else
+#define QR_FIXED_UNROLL
+#endif
+
+/// Square root, usable in constant expressions (Newton iterations at
+/// compile time, std::sqrt at run time).
+constexpr double
+qr_fixed_sqrt(double x) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    if (!__builtin_is_constant_evaluated()) return std::sqrt(x);
+#endif
+    if (!(x > 0e0)) return 0e0;
+    double r = (x > 1e0) ? x : 1e0, prev = 0e0;
+    while (r != prev) {
+        prev = r;
+        r = 0.5e0*(r + x/r);
+        if (r >= prev) break; // converged (the iteration is monotone)
+    }
+    return prev < r ? prev : r;
+}
+
+/// @brief Householder QR decomposition, compile-time size.
+///
+/// Same as householder_qr: at output the upper triangle of a holds R, the
+/// Householder vectors are stored below it and b holds the \f$\beta\f$
+/// coefficients.
+///
+/// @param[in,out] a The M-by-N matrix A (column-wise).
+/// @param[out]    b The N \f$\beta\f$ coefficients.
+template<int M, int N>
+    constexpr void
+    householder_qr(double (&a)[M*N], double (&b)[N]) noexcept
+{
+    static_assert(M >= N && N > 0, "householder_qr<M,N> requires M >= N > 0");
+
+    for (int c = 0; c < N; c++) {
+        // Householder vector of A(c:M, c), formed in place (see
+        // householder_vec)
+        double sigma = 0e0;
+        QR_FIXED_UNROLL
+        for (int i = c+1; i < M; i++) sigma += a[c*M+i]*a[c*M+i];
+        const double x0 = a[c*M+c];
+        if (sigma == 0e0) {
+            b[c] = 0e0;
+        } else {
+            const double mu = qr_fixed_sqrt(x0*x0+sigma);
+            const double v0 = (x0 <= 0e0) ? (x0-mu) : (-sigma/(x0+mu));
+            b[c] = 2e0*v0*v0/(sigma+v0*v0);
+            QR_FIXED_UNROLL
+            for (int i = c+1; i < M; i++) a[c*M+i] /= v0;
+            a[c*M+c] = mu;
+        }
+        // A(c:M, c+1:N) = (I-buu^T)A(c:M, c+1:N)
+        for (int j = c+1; j < N; j++) {
+            double sum = a[j*M+c];
+            QR_FIXED_UNROLL
+            for (int i = c+1; i < M; i++) sum += a[c*M+i]*a[j*M+i];
+            sum *= b[c];
+            a[j*M+c] -= sum;
+            QR_FIXED_UNROLL
+            for (int i = c+1; i < M; i++) a[j*M+i] -= sum*a[c*M+i];
+        }
+    }
+}
+
+/// @brief Householder-QR LS solution, compile-time size.
+///
+/// Same as ls_qrsolve: overwrite a with its QR factorization and the first
+/// N elements of y with the LS solution of \f$Ax=y\f$.
+///
+/// @param[in,out] a The M-by-N design matrix (column-wise).
+/// @param[in,out] y The M observations; at output the first N hold the LS
+///                  solution.
+/// @return        0 on success, 1 if R is singular.
+template<int M, int N>
+    constexpr int
+    ls_qrsolve(double (&a)[M*N], double (&y)[M]) noexcept
+{
+    double b[N] = {};
+    householder_qr<M,N>(a, b);
+
+    // y <- (Q^T)*y
+    for (int j = 0; j < N; j++) {
+        double sum = y[j];
+        QR_FIXED_UNROLL
+        for (int i = j+1; i < M; i++) sum += a[j*M+i]*y[i];
+        sum *= b[j];
+        y[j] -= sum;
+        QR_FIXED_UNROLL
+        for (int i = j+1; i < M; i++) y[i] -= sum*a[j*M+i];
+    }
+
+    // Solve R(1:N,1:N) * x = y(1:N)
+    for (int j = N-1; j >= 0; j--) {
+        if (a[j*M+j] == 0e0) return 1;
+        y[j] /= a[j*M+j];
+        QR_FIXED_UNROLL
+        for (int i = 0; i < j; i++) y[i] -= y[j]*a[j*M+i];
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,227 @@
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <new>
+#include <vector>
+#include "qr.hpp"
+#include "qr_mixed.hpp"
+
+/// Dot product of two float vectors, accumulated in vl-wide partial sums
+/// (so that it vectorizes without reassociation by the compiler).
+static inline float
+dot_float(const float *__restrict__ x, const float *__restrict__ y, int len)
+noexcept
+{
+    constexpr int vl = 16;
+    float acc[vl] = {0e0f};
+    int i, k;
+    for (i = 0; i + vl <= len; i += vl) {
+        for (k = 0; k < vl; k++) acc[k] += x[i+k]*y[i+k];
+    }
+    float sum = 0e0f;
+    for (k = 0; k < vl; k++) sum += acc[k];
+    for (; i < len; i++) sum += x[i]*y[i];
+    return sum;
+}
+
+/// @brief Householder QR decomposition in single precision.
+///
+/// Same algorithm and output format as householder_qr, for a float matrix.
+///
+/// @return 0 on success, 1 if R has a zero (or non-finite) diagonal element.
+static int
+householder_qr_float(float *__restrict__ a, float *__restrict__ b, int m,
+    int n)
+noexcept
+{
+    int i, j, c;
+    float sigma, sum, x0, mu, v0;
+
+    for (c = 0; c < n; c++) {
+        float *__restrict__ ac = a + (long)c*m;
+        // Householder vector of A(c:m, c), formed in place (as in
+        // householder_vec)
+        sigma = dot_float(ac+c+1, ac+c+1, m-c-1);
+        x0 = ac[c];
+        if (sigma == 0e0f) {
+            b[c] = 0e0f;
+        } else {
+            mu = std::sqrt(x0*x0+sigma);
+            v0 = (x0 <= 0e0f) ? (x0-mu) : (-sigma/(x0+mu));
+            b[c] = 2e0f*v0*v0/(sigma+v0*v0);
+            const float s = 1e0f/v0;
+            for (i = c+1; i < m; i++) ac[i] *= s;
+            ac[c] = mu;
+        }
+        if (!(std::abs(ac[c]) > 0e0f) || !std::isfinite(ac[c])) return 1;
+        // A(c:m, c+1:n) = (I-buu^T)A(c:m, c+1:n)
+        for (j = c+1; j < n; j++) {
+            float *__restrict__ aj = a + (long)j*m;
+            sum  = aj[c] + dot_float(ac+c+1, aj+c+1, m-c-1);
+            sum *= b[c];
+            aj[c] -= sum;
+            for (i = c+1; i < m; i++) aj[i] -= sum*ac[i];
+        }
+    }
+    return 0;
+}
+
+/// @brief Solve the refinement (correction) system with the float factors.
+///
+/// Given \f$A = Q(R;0)\f$ (in single precision), f (size m) and g (size n),
+/// solve \f$\delta r + A\delta x = f\f$, \f$A^T \delta r = g\f$:
+/// \f$h = R^{-T} g\f$, \f$d = Q^T f\f$, \f$\delta x = R^{-1}(d_1 - h)\f$ and
+/// \f$\delta r = Q (h; d_2)\f$. The vectors are kept in double precision.
+/// At output, f holds \f$\delta r\f$ and g holds \f$\delta x\f$.
+static void
+augmented_solve(const float *__restrict__ a, const float *__restrict__ b,
+    int m, int n, double *__restrict__ f, double *__restrict__ g,
+    double *__restrict__ h)
+noexcept
+{
+    double sum;
+    int i, j;
+
+    // h = R^{-T} g (forward substitution)
+    for (j = 0; j < n; j++) {
+        const float *__restrict__ aj = a + (long)j*m;
+        for (sum = g[j], i = 0; i < j; i++) sum -= aj[i]*h[i];
+        h[j] = sum / aj[j];
+    }
+    // f <- Q^T f
+    for (j = 0; j < n; j++) {
+        const float *__restrict__ aj = a + (long)j*m;
+        for (sum = f[j], i = j+1; i < m; i++) sum += aj[i]*f[i];
+        sum *= b[j];
+        f[j] -= sum;
+        for (i = j+1; i < m; i++) f[i] -= sum*aj[i];
+    }
+    // dx = R^{-1} (d1 - h), into g
+    for (j = 0; j < n; j++) g[j] = f[j] - h[j];
+    for (j = n-1; j >= 0; j--) {
+        const float *__restrict__ aj = a + (long)j*m;
+        g[j] /= aj[j];
+        for (i = 0; i < j; i++) g[i] -= g[j]*aj[i];
+    }
+    // dr = Q (h; d2), into f
+    for (j = 0; j < n; j++) f[j] = h[j];
+    for (j = n-1; j >= 0; j--) {
+        const float *__restrict__ aj = a + (long)j*m;
+        for (sum = f[j], i = j+1; i < m; i++) sum += aj[i]*f[i];
+        sum *= b[j];
+        f[j] -= sum;
+        for (i = j+1; i < m; i++) f[i] -= sum*aj[i];
+    }
+}
+
+/// @brief Mixed-precision Householder-QR LS solution.
+///
+/// Solve the LS problem \f$min\|Ax-b\|\f$ (A of full column rank) with a
+/// single precision QR factorization of A and iterative refinement in
+/// double precision (see qr_mixed.hpp). Refinement stops when the
+/// correction of x is below tol (relative to x, in the max norm), or when
+/// it is below sqrt(tol) but no longer halves at each step (i.e. it has
+/// reached the rounding level of the residuals, as happens for large
+/// residual problems). It is abandoned, and the problem is solved with
+/// householder_qr_blocked in double precision, if A can not be factored in
+/// single precision (e.g. it is out of the float range or numerically rank
+/// deficient in single precision), if a (larger than sqrt(tol)) correction
+/// is more than half the previous one, or if the tolerance is not reached
+/// in max_iter steps.
+///
+/// @param[in]  a        The m-by-n design matrix (column-wise); not modified.
+/// @param[in]  b        The m observations; not modified.
+/// @param[out] x        At output, the n-element LS solution.
+/// @param[in]  m        Number of observations.
+/// @param[in]  n        Number of parameters (\f$m \geq n\f$).
+/// @param[out] iters    If not null, at output the number of refinement
+///                      steps, or -1 if the double precision fallback was
+///                      used.
+/// @param[in]  tol      Convergence tolerance.
+/// @param[in]  max_iter Maximum number of refinement steps.
+/// @return     0 on success; any other value denotes an error (invalid
+///             sizes, allocation failure, or A singular in double
+///             precision).
+int
+ls_qrsolve_mixed(const double *__restrict__ a, const double *__restrict__ b,
+    double *__restrict__ x, int m, int n, int *iters, double tol,
+    int max_iter)
+{
+    if (m < n || n < 1) return 1;
+    if (iters) *iters = -1;
+
+    std::vector<float>  af, bf;
+    std::vector<double> r, f, g, h;
+    try {
+        af.resize((long)m*n);
+        bf.resize(n);
+        r.assign(m, 0e0);
+        f.resize(m);
+        g.resize(n);
+        h.resize(n);
+    } catch (std::bad_alloc&) {
+        return 1;
+    }
+
+    const float fmax = std::numeric_limits<float>::max();
+    bool ok = true;
+    for (long e = 0; e < (long)m*n; e++) {
+        if (!(std::abs(a[e]) <= fmax)) ok = false;
+        af[e] = static_cast<float>(a[e]);
+    }
+    if (ok) ok = !householder_qr_float(af.data(), bf.data(), m, n);
+
+    // Refine from x = 0, r = 0; the first step is the single precision LS
+    // solution.
+    std::fill(x, x+n, 0e0);
+    double dxprev = 0e0;
+    int i, j, it;
+    for (it = 0; ok && it < max_iter; it++) {
+        // f = b - r - Ax, g = -A^T r
+        for (i = 0; i < m; i++) f[i] = b[i] - r[i];
+        for (j = 0; j < n; j++) {
+            const double *__restrict__ aj = a + (long)j*m;
+            double sum = 0e0;
+            for (i = 0; i < m; i++) {
+                f[i] -= aj[i]*x[j];
+                sum  += aj[i]*r[i];
+            }
+            g[j] = -sum;
+        }
+        augmented_solve(af.data(), bf.data(), m, n, f.data(), g.data(), h.data());
+        double dx = 0e0, xn = 0e0;
+        for (j = 0; j < n; j++) {
+            x[j] += g[j];
+            dx = std::max(dx, std::abs(g[j]));
+            xn = std::max(xn, std::abs(x[j]));
+        }
+        for (i = 0; i < m; i++) r[i] += f[i];
+        if (!std::isfinite(dx)) break;
+        if (dx <= tol*xn) {
+            if (iters) *iters = it+1;
+            return 0;
+        }
+        if (it > 0 && dx > 0.5e0*dxprev) {
+            // stalled at the rounding level of the residuals
+            if (dx <= std::sqrt(tol)*xn) {
+                if (iters) *iters = it+1;
+                return 0;
+            }
+            break;
+        }
+        dxprev = dx;
+    }
+
+    // Fallback: factor (a copy of) A in double precision
+    try {
+        std::vector<double> ad(a, a+(long)m*n);
+        qr_workspace ws;
+        if (householder_qr_blocked(ad.data(), g.data(), m, n, ws)) return 1;
+        std::copy(b, b+m, f.data());
+        if (ls_qrsolve_multi(ad.data(), g.data(), m, n, f.data(), m, 1)) return 1;
+        std::copy(f.data(), f.data()+n, x);
+    } catch (std::bad_alloc&) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,39 @@
+#ifndef __QR_MIXED_HPP__
+#define __QR_MIXED_HPP__
+
+/// @brief Mixed-precision Householder-QR Least Squares.
+///
+/// The design matrix is factored in single precision (half the memory
+/// traffic, and twice the number of elements per SIMD register, of the
+/// double precision kernels); the double precision LS solution is then
+/// recovered by iterative refinement, with the residuals computed in double
+/// precision from the original A.
+///
+/// Refinement is performed on the augmented system
+/// \f[ \left( \begin{array}{cc} I & A \\ A^T & 0 \end{array} \right)
+///     \left( \begin{array}{c} r \\ x \end{array} \right) =
+///     \left( \begin{array}{c} b \\ 0 \end{array} \right) \f]
+/// (i.e. on both the solution x and the residual r), so that it converges
+/// to the double precision solution also for problems with large residuals.
+/// Each step costs \f$O(mn)\f$: a product with A and one with \f$A^T\f$ (in
+/// double), plus \f$Q^T\f$, \f$Q\f$ and two triangular solves with the
+/// single precision factors. The error is reduced by a factor of about
+/// \f$\kappa(A) \epsilon_{float}\f$ per step; if it does not decrease
+/// fast enough (i.e. A is too ill-conditioned for a single precision
+/// factorization), the LS problem is solved with a double precision
+/// factorization instead.
+///
+/// Reference: Björck, Å., Iterative refinement of linear least squares
+///            solutions I, BIT 7 (1967), 257-278
+///            Carson, E. & Higham, N.J., Accelerating the solution of linear
+///            systems by iterative refinement in three precisions, SIAM J.
+///            Sci. Comput. 40 (2018), A817-A847
+///
+/// @example test_qr_mixed.cpp
+
+int
+ls_qrsolve_mixed(const double *__restrict__ a, const double *__restrict__ b,
+    double *__restrict__ x, int m, int n, int *iters = nullptr,
+    double tol = 1e-12, int max_iter = 30);
+
+#endif
@@ -0,0 +1,150 @@
+#include <cerrno>
+#include <cmath>
+#include <algorithm>
+#include <new>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "qr.hpp"
+#include "qr_ooc.hpp"
+#include "run_threads.hpp"
+
+/// Read exactly size bytes at byte offset off of fd into buf (pread,
+/// retried on short reads and EINTR).
+/// @return 0 on success, 1 on I/O error or end of file.
+static int
+read_fully(int fd, long off, char *buf, long size) noexcept
+{
+    while (size > 0) {
+        const ssize_t got = pread(fd, buf, size, off);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return 1;
+        buf  += got;
+        off  += got;
+        size -= got;
+    }
+    return 0;
+}
+
+/// @brief Out-of-core LS solution, reading from a file descriptor.
+///
+/// Solve \f$\min\|Ax-b\|\f$ for the m-by-n A and b stored in the file fd
+/// (see qr_ooc.hpp for the layout), reading block_rows rows at a time.
+///
+/// @param[in]  fd         File descriptor, open for reading (it is only
+///                        accessed via pread, so its offset is unchanged).
+/// @param[in]  offset     Byte offset of the first record.
+/// @param[in]  m          Number of observations (records), \f$m \geq n\f$.
+/// @param[in]  n          Number of parameters.
+/// @param[out] x          At output, the LS solution (size n).
+/// @param[out] r          If not null, at output the n-by-n upper triangular
+///                        R (column-wise, zeros below the diagonal), e.g.
+///                        for r_covariance.
+/// @param[out] rss        If not null, at output the residual sum of squares
+///                        \f$\|Ax_{LS}-b\|^2\f$.
+/// @param[in]  block_rows Rows per block; if <= 0, max(4n, 256).
+/// @param[in]  nb         Block size of the QR factorization (see
+///                        householder_qr_blocked).
+/// @return     0 on success; any other value denotes an error (invalid
+///             sizes, I/O error or short file, allocation failure or
+///             singular R).
+int
+ls_qrsolve_ooc(int fd, long offset, long m, int n, double *__restrict__ x,
+    double *__restrict__ r, double *rss, int block_rows, int nb)
+{
+    if (fd < 0 || n < 1 || m < n || offset < 0) return 1;
+    const int  rec = n + 1;
+    const long k   = std::min<long>(m, block_rows > 0 ? block_rows
+                                                      : std::max(4*n, 256));
+    const long ld  = n + k;
+
+    std::vector<double> s, buf[2], beta;
+    qr_workspace ws;
+    try {
+        s.assign(ld*rec, 0e0);
+        buf[0].resize(k*rec);
+        buf[1].resize(k*rec);
+        beta.resize(rec);
+    } catch (std::bad_alloc&) {
+        return 1;
+    }
+    if (ws.reserve(qr_worksize(ld, rec, nb))) return 1;
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, offset, m*rec*(long)sizeof(double), POSIX_FADV_SEQUENTIAL);
+#endif
+    auto read_block = [=](long row0, long rows, double *dst) {
+        return read_fully(fd, offset + row0*rec*(long)sizeof(double),
+            reinterpret_cast<char*>(dst), rows*rec*(long)sizeof(double));
+    };
+
+    double sum_sq = 0e0;
+    int cur = 0;
+    if (read_block(0, k, buf[cur].data())) return 1;
+
+    for (long row0 = 0; row0 < m; row0 += k) {
+        const long kb = std::min(k, m-row0), next0 = row0 + k;
+        const long kn = std::min(k, m-next0);
+
+        // read the next block while this one is folded (after it, if no
+        // thread can be started)
+        int read_status = 0;
+        auto read_next = [&, next0, kn](int) {
+            read_status = read_block(next0, kn, buf[1-cur].data());
+        };
+        std::vector<std::thread> reader;
+        const bool async = kn > 0 && start_threads(reader, 2, read_next) == 2;
+
+        // [R c] are the top n rows of s; the block goes below them
+        const double *__restrict__ src = buf[cur].data();
+        for (int j = 0; j < rec; j++) {
+            double *__restrict__ sj = s.data() + (long)j*ld + n;
+            for (long i = 0; i < kb; i++) sj[i] = src[i*rec+j];
+        }
+        const int qr_status = householder_qr_blocked(
+            matrix_view<double>(s.data(), n+kb, rec, ld), beta.data(), ws, nb);
+        // the n+1-th reflector collects the unabsorbed part of the b block
+        sum_sq += s[(long)n*ld+n]*s[(long)n*ld+n];
+        // clear the Householder vectors below R
+        for (int j = 0; j < n; j++) std::fill(&s[(long)j*ld+j+1], &s[(long)j*ld+n], 0e0);
+
+#ifdef POSIX_FADV_DONTNEED
+        // the block is not needed again; do not let it fill the page cache
+        posix_fadvise(fd, offset + row0*rec*(long)sizeof(double),
+            kb*rec*(long)sizeof(double), POSIX_FADV_DONTNEED);
+#endif
+
+        // the reader must be joined before any return
+        join_threads(reader);
+        if (qr_status) return 1;
+        if (!async && kn > 0) read_next(1);
+        if (read_status) return 1;
+        cur = 1 - cur;
+    }
+
+    if (r) {
+        for (int j = 0; j < n; j++) {
+            std::copy(&s[(long)j*ld], &s[(long)j*ld+j+1], r+(long)j*n);
+            std::fill(r+(long)j*n+j+1, r+(long)(j+1)*n, 0e0);
+        }
+    }
+    if (rss) *rss = sum_sq;
+    std::copy(&s[(long)n*ld], &s[(long)n*ld+n], x);
+    return triangular_solve(true, false, s.data(), ld, x, n, n, 1);
+}
+
+/// @brief Out-of-core LS solution, reading from a file.
+///
+/// Same as ls_qrsolve_ooc, for the file path (opened read-only).
+int
+ls_qrsolve_ooc(const char *path, long offset, long m, int n,
+    double *__restrict__ x, double *__restrict__ r, double *rss,
+    int block_rows, int nb)
+{
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) return 1;
+    const int status = ls_qrsolve_ooc(fd, offset, m, n, x, r, rss,
+        block_rows, nb);
+    close(fd);
+    return status;
+}
@@ -0,0 +1,38 @@
+#ifndef __QR_OOC_HPP__
+#define __QR_OOC_HPP__
+
+/// @brief Out-of-core Householder-QR Least Squares.
+///
+/// Solve the LS problem \f$\min\|Ax-b\|\f$ for a design matrix that does
+/// not fit in memory: A and b are read from a file, block_rows rows at a
+/// time, and each block \f$[A_k\ b_k]\f$ is folded into the running
+/// triangular factor R and vector \f$c = Q^T b\f$ (its first n elements),
+/// by the (blocked) Householder QR factorization of the stacked array
+/// \f[ \left( \begin{array}{cc} R & c \\ A_k & b_k \end{array} \right) \f]
+/// (householder_qr_blocked, on a view of the stacking buffer). The part of
+/// \f$b_k\f$ that is not absorbed in c adds to the residual sum of squares.
+/// While a block is folded, the next one is read (pread) by a second
+/// thread, so I/O and computation overlap.
+///
+/// Memory use is \f$O(n^2 + block\_rows \cdot n)\f$: the stacking buffer,
+/// two read buffers and the QR workspace, independent of m.
+///
+/// File layout: row i of the system is the record
+/// \f$[a_{i0}, ..., a_{i,n-1}, b_i]\f$ of n+1 doubles (native byte order),
+/// and the m records are stored one after the other, starting at byte
+/// offset (e.g. after a header); i.e. \f$[A\ b]\f$ row-major, so that a
+/// block of rows is one contiguous read.
+///
+/// @example test_qr_ooc.cpp
+
+int
+ls_qrsolve_ooc(int fd, long offset, long m, int n, double *__restrict__ x,
+    double *__restrict__ r = nullptr, double *rss = nullptr,
+    int block_rows = 0, int nb = 32);
+
+int
+ls_qrsolve_ooc(const char *path, long offset, long m, int n,
+    double *__restrict__ x, double *__restrict__ r = nullptr,
+    double *rss = nullptr, int block_rows = 0, int nb = 32);
+
+#endif
@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <vector>
+#include "qr.hpp"
+#include "qr_operator.hpp"
+#include "gemm_kernels.hpp"
+#include "run_threads.hpp"
+
+namespace {
+
+/// Columns of the operand processed at a time.
+constexpr int op_cols = 256;
+
+/// Minimum number of rows per thread (fewer threads are used for small m).
+constexpr int op_min_rows = 256;
+
+/// A reusable barrier for a fixed number of threads; it can be aborted, in
+/// which case all waiting (and subsequent) calls to wait return false.
+class op_barrier
+{
+public:
+    explicit
+    op_barrier(int count) noexcept
+    : _count(count), _waiting(0), _gen(0), _aborted(false)
+    {}
+
+    bool
+    wait()
+    {
+        std::unique_lock<std::mutex> lock(_mtx);
+        if (_aborted) return false;
+        const long gen = _gen;
+        if (++_waiting == _count) {
+            _waiting = 0;
+            ++_gen;
+            _cv.notify_all();
+            return true;
+        }
+        _cv.wait(lock, [&]{ return _gen != gen || _aborted; });
+        return !_aborted;
+    }
+
+    void
+    abort()
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _aborted = true;
+        _cv.notify_all();
+    }
+
+private:
+    std::mutex              _mtx;
+    std::condition_variable _cv;
+    int                     _count, _waiting;
+    long                    _gen;
+    bool                    _aborted;
+};
+
+} // namespace
+
+/// @brief Construct the operator.
+///
+/// Compute the triangular factors of the blocks of nb reflectors; may throw
+/// std::bad_alloc.
+///
+/// @param[in] a           The result of householder_qr (m-by-n, column-wise).
+/// @param[in] b           The \f$\beta\f$ coefficients (size n).
+/// @param[in] m           Number of rows of a.
+/// @param[in] n           Number of columns of a (\f$m \geq n\f$).
+/// @param[in] nb          Number of reflectors per block.
+/// @param[in] num_threads Number of threads used by the apply methods; if
+///                        <= 0, then std::thread::hardware_concurrency is
+///                        used.
+qr_operator::qr_operator(const double *__restrict__ a,
+    const double *__restrict__ b, int m, int n, int nb, int num_threads)
+: _a(a), _m(m), _n(std::min(m, n)), _nb(std::max(nb, 1)), _nt(num_threads)
+{
+    _nt = resolve_threads(_nt);
+    const int nblk = (_n + _nb - 1) / _nb;
+    _t.resize((long)nblk*_nb*_nb);
+    for (int blk = 0; blk < nblk; blk++) {
+        const int j = blk*_nb, jb = std::min(_nb, _n-j);
+        block_reflector_t(&a[(long)j*m+j], m, &b[j], m-j, jb,
+            &_t[(long)blk*_nb*_nb], _nb);
+    }
+}
+
+/// @brief Apply \f$Q^T\f$ (if trans) or \f$Q\f$ to the m-by-k matrix C.
+int
+qr_operator::apply(bool trans, double *__restrict__ c, int ldc, int k) const
+{
+    const int nt = std::min(_nt, std::max(1, _m/op_min_rows));
+    if (nt > 1) return apply_threaded(trans, c, ldc, k, nt);
+    return apply_serial(trans, c, ldc, k);
+}
+
+/// @brief Single-threaded apply; one apply_block_reflector call per block
+///        (and per op_cols columns of C).
+int
+qr_operator::apply_serial(bool trans, double *__restrict__ c, int ldc, int k)
+const
+{
+    const int nblk = (_n + _nb - 1) / _nb, m = _m;
+    double *w;
+    try {
+        w = new double[block_reflector_worksize(_nb, std::min(k, op_cols))];
+    } catch (std::bad_alloc&) {
+        return 1;
+    }
+    for (int c0 = 0; c0 < k; c0 += op_cols) {
+        const int nc = std::min(op_cols, k-c0);
+        for (int q = 0; q < nblk; q++) {
+            // Q^T = B_nblk^T ... B_1^T, Q = B_1 ... B_nblk
+            const int blk = trans ? q : nblk-1-q;
+            const int j = blk*_nb, jb = std::min(_nb, _n-j);
+            apply_block_reflector(trans, &_a[(long)j*m+j], m,
+                &_t[(long)blk*_nb*_nb], _nb, m-j, jb,
+                &c[(long)c0*ldc+j], ldc, nc, w);
+        }
+    }
+    delete[] w;
+    return 0;
+}
+
+/// @brief Multithreaded apply; the rows of C are split among num_threads
+///        threads.
+///
+/// For every block \f$I - VTV^T\f$, thread p computes
+/// \f$W_p = V(rows_p)^T C(rows_p)\f$; then thread 0 forms
+/// \f$W = T^T \sum W_p\f$ (or \f$T \sum W_p\f$) and each thread updates
+/// \f$C(rows_p) \leftarrow C(rows_p) - V(rows_p) W\f$. If the threads can
+/// not be created, C is processed by the calling thread alone.
+int
+qr_operator::apply_threaded(bool trans, double *__restrict__ c, int ldc,
+    int k, int num_threads) const
+{
+    const int nblk = (_n + _nb - 1) / _nb, m = _m, nb = _nb;
+    const int kc = std::min(k, op_cols);
+    std::vector<double> work;
+    try {
+        work.resize((long)(num_threads+1)*nb*kc);
+    } catch (std::bad_alloc&) {
+        return 1;
+    }
+    double *wsum = work.data() + (long)num_threads*nb*kc;
+    op_barrier bar(num_threads);
+
+    auto worker = [&](int tid) {
+        const int r0 = (long)m*tid/num_threads, r1 = (long)m*(tid+1)/num_threads;
+        double *__restrict__ wp = work.data() + (long)tid*nb*kc;
+        // start gate; false if not all threads could be created
+        if (!bar.wait()) return;
+        for (int c0 = 0; c0 < k; c0 += op_cols) {
+            const int nc = std::min(op_cols, k-c0);
+            double *__restrict__ cc = c + (long)c0*ldc;
+            for (int q = 0; q < nblk; q++) {
+                const int blk = trans ? q : nblk-1-q;
+                const int j = blk*nb, jb = std::min(nb, _n-j);
+                const double *__restrict__ v = _a + (long)j*m;
+                // rows of this thread within the triangle (t0:t1) and the
+                // dense part (d0:r1) of V
+                const int t0 = std::max(r0, j), t1 = std::min(r1, j+jb);
+                const int d0 = std::max(r0, j+jb);
+
+                // W_p = V(rows)^T C(rows)
+                std::fill(wp, wp+jb*nc, 0e0);
+                for (int col = 0; col < nc; col++) {
+                    const double *__restrict__ cj = cc + (long)col*ldc;
+                    for (int r = t0; r < t1; r++) {
+                        wp[col*jb+r-j] += cj[r];
+                        for (int i = 0; i < r-j; i++) wp[col*jb+i] += v[i*m+r]*cj[r];
+                    }
+                }
+                if (d0 < r1) {
+                    gemm_tn_acc(r1-d0, jb, nc, v+d0, m, cc+d0, ldc, wp, jb);
+                }
+                bar.wait();
+
+                if (tid == 0) {
+                    std::copy(wp, wp+jb*nc, wsum);
+                    for (int p = 1; p < num_threads; p++) {
+                        const double *__restrict__ w = work.data() + (long)p*nb*kc;
+                        for (int i = 0; i < jb*nc; i++) wsum[i] += w[i];
+                    }
+                    const double *__restrict__ t = _t.data() + (long)blk*nb*nb;
+                    if (trans) {
+                        trmm_tn(jb, nc, t, nb, wsum, jb);
+                    } else {
+                        trmm_nn(jb, nc, t, nb, wsum, jb);
+                    }
+                }
+                bar.wait();
+
+                // C(rows) -= V(rows) W
+                for (int col = 0; col < nc; col++) {
+                    double *__restrict__ cj = cc + (long)col*ldc;
+                    const double *__restrict__ w = wsum + col*jb;
+                    for (int r = t0; r < t1; r++) {
+                        double sum = w[r-j];
+                        for (int i = 0; i < r-j; i++) sum += v[i*m+r]*w[i];
+                        cj[r] -= sum;
+                    }
+                }
+                if (d0 < r1) {
+                    gemm_nn_sub(r1-d0, jb, nc, v+d0, m, wsum, jb, cc+d0, ldc);
+                }
+            }
+        }
+    };
+
+    // the workers meet at barriers, so they cannot be run one after the
+    // other; if any thread cannot be started, C is processed by this one
+    std::vector<std::thread> pool;
+    if (start_threads(pool, num_threads, worker) < num_threads) {
+        bar.abort();
+        join_threads(pool);
+        return apply_serial(trans, c, ldc, k);
+    }
+    worker(0);
+    join_threads(pool);
+    return 0;
+}
+
+/// @brief Compute \f$C \leftarrow Q^T C\f$.
+///
+/// @param[in,out] c   The m-by-k matrix C (column-wise, leading dimension
+///                    ldc).
+/// @param[in]     ldc Leading dimension of c (\f$ldc \geq m\f$).
+/// @param[in]     k   Number of columns of C.
+/// @return        0 on success, 1 on allocation failure.
+int
+qr_operator::apply_qt(double *__restrict__ c, int ldc, int k) const
+{ return apply(true, c, ldc, k); }
+
+/// @brief Compute \f$C \leftarrow Q C\f$.
+///
+/// @param[in,out] c   The m-by-k matrix C (column-wise, leading dimension
+///                    ldc).
+/// @param[in]     ldc Leading dimension of c (\f$ldc \geq m\f$).
+/// @param[in]     k   Number of columns of C.
+/// @return        0 on success, 1 on allocation failure.
+int
+qr_operator::apply_q(double *__restrict__ c, int ldc, int k) const
+{ return apply(false, c, ldc, k); }
+
+/// @brief Compute \f$Y = Q_1 X\f$.
+///
+/// @param[in]  x   The n-by-k matrix X (column-wise, leading dimension ldx).
+/// @param[in]  ldx Leading dimension of x (\f$ldx \geq n\f$).
+/// @param[out] y   The m-by-k matrix Y (column-wise, leading dimension ldy).
+/// @param[in]  ldy Leading dimension of y (\f$ldy \geq m\f$).
+/// @param[in]  k   Number of columns of X and Y.
+/// @return     0 on success, 1 on allocation failure.
+int
+qr_operator::apply_q1(const double *__restrict__ x, int ldx,
+    double *__restrict__ y, int ldy, int k) const
+{
+    for (int col = 0; col < k; col++) {
+        std::copy(x + (long)col*ldx, x + (long)col*ldx + _n, y + (long)col*ldy);
+        std::fill(y + (long)col*ldy + _n, y + (long)col*ldy + _m, 0e0);
+    }
+    return apply(false, y, ldy, k);
+}
+
+/// @brief Compute \f$Y = Q_1^T X\f$.
+///
+/// @param[in]  x   The m-by-k matrix X (column-wise, leading dimension ldx);
+///                 not modified.
+/// @param[in]  ldx Leading dimension of x (\f$ldx \geq m\f$).
+/// @param[out] y   The n-by-k matrix Y (column-wise, leading dimension ldy).
+/// @param[in]  ldy Leading dimension of y (\f$ldy \geq n\f$).
+/// @param[in]  k   Number of columns of X and Y.
+/// @return     0 on success, 1 on allocation failure.
+int
+qr_operator::apply_q1t(const double *__restrict__ x, int ldx,
+    double *__restrict__ y, int ldy, int k) const
+{
+    std::vector<double> tmp;
+    try {
+        tmp.resize((long)_m*std::min(k, op_cols));
+    } catch (std::bad_alloc&) {
+        return 1;
+    }
+    for (int c0 = 0; c0 < k; c0 += op_cols) {
+        const int nc = std::min(op_cols, k-c0);
+        for (int col = 0; col < nc; col++) {
+            const double *__restrict__ xc = x + (long)(c0+col)*ldx;
+            std::copy(xc, xc+_m, tmp.data() + (long)col*_m);
+        }
+        if (apply(true, tmp.data(), _m, nc)) return 1;
+        for (int col = 0; col < nc; col++) {
+            std::copy(tmp.data() + (long)col*_m, tmp.data() + (long)col*_m + _n,
+                y + (long)(c0+col)*ldy);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+#ifndef __QR_OPERATOR_HPP__
+#define __QR_OPERATOR_HPP__
+
+#include <vector>
+
+/// @brief The orthogonal factor of a QR factorization, as an operator.
+///
+/// Wraps the output of householder_qr (or householder_qr_blocked), i.e. the
+/// Householder vectors stored below the diagonal of the m-by-n matrix a and
+/// their \f$\beta\f$ coefficients b, and applies \f$Q\f$, \f$Q^T\f$,
+/// \f$Q_1\f$ or \f$Q_1^T\f$ (see qr.hpp) to vectors and blocks of vectors,
+/// without ever forming Q. The reflectors are applied nb at a time, in
+/// compact WY form (see block_reflector_t); the triangular factors of all
+/// blocks are computed once, at construction.
+///
+/// With num_threads > 1, the rows of the operand are split among threads:
+/// each thread computes its part of \f$V^T C\f$ and updates its own rows,
+/// so that only the small nb-by-k products are exchanged between threads
+/// (two barriers per block of reflectors).
+///
+/// E.g., the LS residual \f$b - Ax_{LS} = Q_2 Q_2^T b\f$ is computed as
+/// apply_qt(b), zero the first n elements, apply_q(b); the projection
+/// \f$Q_1 Q_1^T b\f$ by zeroing the last m-n elements instead.
+///
+/// The operator keeps pointers to a and b (they are not copied); they must
+/// outlive it and not be modified. All apply methods are const, i.e. one
+/// operator can be used by several threads at the same time.
+///
+/// @example test_qr_operator.cpp
+class qr_operator
+{
+public:
+    qr_operator(const double *__restrict__ a, const double *__restrict__ b,
+        int m, int n, int nb = 32, int num_threads = 1);
+
+    int
+    apply_qt(double *__restrict__ c, int ldc, int k) const;
+
+    int
+    apply_q(double *__restrict__ c, int ldc, int k) const;
+
+    int
+    apply_q1(const double *__restrict__ x, int ldx, double *__restrict__ y,
+        int ldy, int k) const;
+
+    int
+    apply_q1t(const double *__restrict__ x, int ldx, double *__restrict__ y,
+        int ldy, int k) const;
+
+    /// Number of rows m (Q is m-by-m).
+    int
+    rows() const noexcept
+    { return _m; }
+
+    /// Number of columns n (\f$Q_1\f$ is m-by-n).
+    int
+    cols() const noexcept
+    { return _n; }
+
+private:
+    int
+    apply(bool trans, double *__restrict__ c, int ldc, int k) const;
+
+    int
+    apply_serial(bool trans, double *__restrict__ c, int ldc, int k) const;
+
+    int
+    apply_threaded(bool trans, double *__restrict__ c, int ldc, int k,
+        int num_threads) const;
+
+    const double*       _a;   ///< the factored matrix (not owned)
+    int                 _m,   ///< rows of A
+                        _n,   ///< columns of A
+                        _nb,  ///< reflectors per block
+                        _nt;  ///< number of threads
+    std::vector<double> _t;   ///< T factor of each block, nb-by-nb
+};
+
+#endif
@@ -0,0 +1,185 @@
+#include <cmath>
+#include <algorithm>
+#include "qr_robust.hpp"
+
+/// @brief Huber weight function.
+///
+/// @param[in] u Standardized residual.
+/// @param[in] c Tuning constant (> 0).
+/// @return    1 for \f$|u| \leq c\f$, else \f$c/|u|\f$.
+double
+huber_weight(double u, double c) noexcept
+{
+    const double au = std::abs(u);
+    return (au <= c) ? 1e0 : c/au;
+}
+
+/// @brief Tukey (bisquare) weight function.
+///
+/// @param[in] u Standardized residual.
+/// @param[in] c Tuning constant (> 0).
+/// @return    \f$(1-(u/c)^2)^2\f$ for \f$|u| < c\f$, else 0.
+double
+tukey_weight(double u, double c) noexcept
+{
+    const double t = u/c;
+    if (std::abs(t) >= 1e0) return 0e0;
+    const double s = 1e0 - t*t;
+    return s*s;
+}
+
+/// @brief Danish weight function.
+///
+/// @param[in] u Standardized residual.
+/// @param[in] c Tuning constant (> 0).
+/// @return    1 for \f$|u| \leq c\f$, else \f$e^{1-(u/c)^2}\f$ (i.e. the
+///            weight is continuous, and decays exponentially).
+double
+danish_weight(double u, double c) noexcept
+{
+    const double t = u/c;
+    return (std::abs(t) <= 1e0) ? 1e0 : std::exp(1e0 - t*t);
+}
+
+/// @brief Constructor; copy the design matrix and allocate all workspaces.
+///
+/// @param[in] a      The design matrix \f$A\in{\Re}^{m\times n}\f$
+///                   (column-wise), \f$m \geq n\f$; it is copied.
+/// @param[in] m      Number of observations (rows of A).
+/// @param[in] n      Number of parameters (columns of A).
+/// @param[in] weight The weight function.
+/// @param[in] c      Its tuning constant.
+/// @param[in] nb     Block size of the QR factorization (see
+///                   householder_qr_blocked).
+/// @throw     std::bad_alloc if memory allocation fails.
+robust_ls::robust_ls(const double *__restrict__ a, int m, int n,
+    robust_weight_fn weight, double c, int nb)
+: _a(m, n), _wa(m, n), _wb(m), _beta(n), _w(m, 1e0), _r(m, 0e0), _absr(m),
+  _sw(m), _ws(qr_worksize(m, n, nb)), _weight(weight), _c(c), _sigma(0e0),
+  _nb(nb), _iters(0)
+{
+    for (int j = 0; j < n; j++) std::copy(a+(long)j*m, a+(long)(j+1)*m, &_a(0, j));
+}
+
+/// @brief Residuals \f$r = b - Ax\f$, with the pristine A.
+void
+robust_ls::compute_residuals(const double *__restrict__ b,
+    const double *__restrict__ x)
+noexcept
+{
+    const int m = rows(), n = cols();
+    double *__restrict__ r = _r.data();
+    std::copy(b, b+m, r);
+    for (int j = 0; j < n; j++) {
+        const double *__restrict__ aj = &_a(0, j);
+        const double xj = x[j];
+        for (int i = 0; i < m; i++) r[i] -= aj[i]*xj;
+    }
+}
+
+/// @brief Solve the LS problem weighted by the current weights.
+///
+/// The rows of A and b are scaled by \f$\sqrt{w_i}\f$ as they are copied to
+/// the work matrix, which is then factored in place. The solution is left
+/// in wb(0:n).
+/// @return 0 on success, 1 if the weighted R is singular.
+int
+robust_ls::weighted_solve(const double *__restrict__ b)
+noexcept
+{
+    const int m = rows(), n = cols();
+    const double *__restrict__ w = _w.data();
+    double *__restrict__ sw = _sw.data();
+    double *__restrict__ wb = _wb.data();
+    int i, j;
+
+    for (i = 0; i < m; i++) sw[i] = std::sqrt(w[i]);
+    for (j = 0; j < n; j++) {
+        const double *__restrict__ aj = &_a(0, j);
+        double *__restrict__ waj = &_wa(0, j);
+        for (i = 0; i < m; i++) waj[i] = sw[i]*aj[i];
+    }
+    for (i = 0; i < m; i++) wb[i] = sw[i]*b[i];
+
+    // the workspace was sized at construction, so this does not allocate
+    if (householder_qr_blocked(_wa.view(), _beta.data(), _ws, _nb)) return 1;
+
+    // wb <- Q^T wb
+    if (qr_apply_qt(_wa.view(), _beta.data(), matrix_view<double>(wb, m, 1),
+        _ws, _nb)) return 1;
+
+    // R x = (Q^T wb)(0:n)
+    const int lda = _wa.ld();
+    const double *__restrict__ qa = _wa.data();
+    return triangular_solve(true, false, qa, lda, wb, m, n, 1);
+}
+
+/// @brief Robust LS solution.
+///
+/// Solve \f$Ax \approx b\f$ by IRLS (see qr_robust.hpp), starting from the
+/// ordinary LS solution. At output, weights() and residuals() hold the
+/// final weights and residuals, iterations() the number of reweighting
+/// iterations and sigma() the scale used in the last one.
+///
+/// If \f$\sigma\f$ is re-estimated and turns out zero (i.e. the solution
+/// fits at least half of the observations exactly), the iterations stop.
+///
+/// @param[in]  b        The observation vector (size m).
+/// @param[out] x        At output, the robust LS solution (size n).
+/// @param[in]  sigma    Standard deviation of the observations; if <= 0,
+///                      it is estimated from the median absolute residual
+///                      at each iteration.
+/// @param[in]  tol      Stop when the (2-norm of the) change of x is at
+///                      most tol times the norm of x.
+/// @param[in]  max_iter Maximum number of reweighting iterations.
+/// @return     0 on convergence; 1 if a weighted LS problem is singular
+///             (e.g. too many observations were rejected, or m < n), in
+///             which case x holds the last successful solution (if any);
+///             2 if max_iter iterations did not converge (x holds the last
+///             iterate).
+int
+robust_ls::solve(const double *__restrict__ b, double *__restrict__ x,
+    double sigma, double tol, int max_iter)
+noexcept
+{
+    const int m = rows(), n = cols();
+    double *w = _w.data();
+    const double *r = _r.data();
+    const double *xn = _wb.data(); // solution of weighted_solve
+    _iters = 0;
+    _sigma = sigma;
+    if (m < n || n < 1) return 1;
+
+    // ordinary LS
+    std::fill(_w.begin(), _w.end(), 1e0);
+    if (weighted_solve(b)) return 1;
+    std::copy(xn, xn+n, x);
+    compute_residuals(b, x);
+
+    while (_iters < max_iter) {
+        // scale and weights
+        if (sigma <= 0e0) {
+            for (int i = 0; i < m; i++) _absr[i] = std::abs(r[i]);
+            auto mid = _absr.begin() + m/2;
+            std::nth_element(_absr.begin(), mid, _absr.end());
+            _sigma = 1.4826e0 * (*mid);
+            if (_sigma == 0e0) return 0;
+        }
+        const double s = 1e0 / _sigma;
+        for (int i = 0; i < m; i++) w[i] = _weight(r[i]*s, _c);
+
+        if (weighted_solve(b)) return 1;
+        ++_iters;
+
+        // convergence test
+        double dx = 0e0, nx = 0e0;
+        for (int j = 0; j < n; j++) {
+            dx += (xn[j]-x[j])*(xn[j]-x[j]);
+            nx += xn[j]*xn[j];
+        }
+        std::copy(xn, xn+n, x);
+        compute_residuals(b, x);
+        if (dx <= tol*tol*nx) return 0;
+    }
+    return 2;
+}
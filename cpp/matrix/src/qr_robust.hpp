@@ -0,0 +1,139 @@
+#ifndef __QR_ROBUST_HPP__
+#define __QR_ROBUST_HPP__
+
+#include <vector>
+#include "qr.hpp"
+#include "matrix_view.hpp"
+
+/// @brief Robust Least Squares, via iteratively reweighted QR (IRLS).
+///
+/// Observations with gross errors (outliers) are down-weighted: starting
+/// from the ordinary LS solution, every iteration computes the residuals
+/// \f$r = b - Ax\f$, their standardized values \f$u_i = r_i / \sigma\f$ and
+/// the weights \f$w_i = \psi(u_i)\f$, and solves the weighted LS problem
+/// \f$\min \|W^{1/2}(Ax-b)\|\f$ (via Householder QR). It stops when the
+/// solution does not change (relative to its norm) by more than tol, or
+/// after max_iter iterations.
+///
+/// \f$\sigma\f$ is either given (e.g. the a-priori standard deviation of the
+/// observations) or re-estimated at each iteration, robustly, from the
+/// median absolute residual (\f$\sigma = 1.4826\,median|r_i|\f$).
+///
+/// The weight function is pluggable (any robust_weight_fn); provided are:
+///   - huber_weight: \f$w = 1\f$ for \f$|u| \leq c\f$, else \f$c/|u|\f$
+///     (convex; c = 1.345 for 95% efficiency at the normal distribution),
+///   - tukey_weight: \f$w = (1-(u/c)^2)^2\f$ for \f$|u| < c\f$, else 0
+///     (redescending, i.e. outliers are rejected; c = 4.685),
+///   - danish_weight: \f$w = 1\f$ for \f$|u| \leq c\f$, else
+///     \f$e^{1-(u/c)^2}\f$ (the Danish method; c = 2 to 3).
+/// Redescending weights may not converge from a poor start; they are best
+/// used with a given \f$\sigma\f$, or after a Huber solution.
+///
+/// The robust_ls object keeps a pristine copy of A (householder_qr destroys
+/// its input), plus the weighted copy and the workspaces of the QR
+/// factorization, all allocated at construction; the rows of the weighted
+/// copy are scaled by \f$\sqrt{w_i}\f$ while they are copied from the
+/// pristine one. So solve does not allocate, and the same object can solve
+/// for any number of observation vectors.
+///
+/// Reference: Huber, P.J., Robust Statistics, Wiley, 1981
+///            Holland, P.W. & Welsch, R.E., Robust regression using
+///            iteratively reweighted least-squares, Commun. Stat. Theory
+///            Methods 6 (1977), 813-827
+///            Krarup, T., Juhl, J. & Kubik, K., Götterdämmerung over least
+///            squares adjustment, 14th ISP Congress, Hamburg, 1980
+///
+/// @example test_qr_robust.cpp
+
+/// A weight function: the weight of an observation with standardized
+/// residual u, for the tuning constant c.
+using robust_weight_fn = double (*)(double u, double c);
+
+double
+huber_weight(double u, double c) noexcept;
+
+double
+tukey_weight(double u, double c) noexcept;
+
+double
+danish_weight(double u, double c) noexcept;
+
+/// Default tuning constants.
+constexpr double huber_c  = 1.345e0;
+constexpr double tukey_c  = 4.685e0;
+constexpr double danish_c = 2.5e0;
+
+class robust_ls
+{
+public:
+    robust_ls(const double *__restrict__ a, int m, int n,
+        robust_weight_fn weight = huber_weight, double c = huber_c,
+        int nb = 32);
+
+    /// Use the weight function weight, with tuning constant c.
+    void
+    set_weight(robust_weight_fn weight, double c) noexcept
+    {
+        _weight = weight;
+        _c = c;
+    }
+
+    int
+    solve(const double *__restrict__ b, double *__restrict__ x,
+        double sigma = 0e0, double tol = 1e-8, int max_iter = 50) noexcept;
+
+    /// Number of observations m.
+    int
+    rows() const noexcept
+    { return _a.rows(); }
+
+    /// Number of parameters n.
+    int
+    cols() const noexcept
+    { return _a.cols(); }
+
+    /// Iterations performed by the last solve (0: ordinary LS).
+    int
+    iterations() const noexcept
+    { return _iters; }
+
+    /// The weights of the last iteration (size m).
+    const double*
+    weights() const noexcept
+    { return _w.data(); }
+
+    /// The residuals \f$b - Ax\f$ of the last solution (size m).
+    const double*
+    residuals() const noexcept
+    { return _r.data(); }
+
+    /// The \f$\sigma\f$ used in the last iteration.
+    double
+    sigma() const noexcept
+    { return _sigma; }
+
+private:
+    int
+    weighted_solve(const double *__restrict__ b) noexcept;
+
+    void
+    compute_residuals(const double *__restrict__ b,
+        const double *__restrict__ x) noexcept;
+
+    aligned_matrix<double> _a;      ///< the pristine A
+    aligned_matrix<double> _wa;     ///< W^{1/2} A, factored in place
+    std::vector<double>    _wb;     ///< W^{1/2} b, then the solution (0:n)
+    std::vector<double>    _beta;   ///< Householder coefficients
+    std::vector<double>    _w;      ///< weights
+    std::vector<double>    _r;      ///< residuals
+    std::vector<double>    _absr;   ///< |r|, for the median
+    std::vector<double>    _sw;     ///< square roots of the weights
+    qr_workspace           _ws;     ///< QR workspace
+    robust_weight_fn       _weight; ///< weight function
+    double                 _c;      ///< tuning constant
+    double                 _sigma;  ///< scale of the last iteration
+    int                    _nb;     ///< QR block size
+    int                    _iters;  ///< iterations of the last solve
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef __RUN_THREADS_HPP__
+#define __RUN_THREADS_HPP__
+
+#include <algorithm>
+#include <climits>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+/// @brief Internal helpers to spread work over a few threads, the calling
+///        one included.
+///
+/// Thread creation can fail (std::system_error, or std::bad_alloc for the
+/// thread vector or the thread state); the routines using these helpers
+/// then go on with fewer threads, never fail because of it.
+
+/// Resolve the number of threads to use; if num_threads <= 0, then
+/// std::thread::hardware_concurrency is used. Never more than max_threads,
+/// never less than one.
+inline int
+resolve_threads(int num_threads, int max_threads = INT_MAX) noexcept
+{
+    if (num_threads <= 0) num_threads = std::thread::hardware_concurrency();
+    return std::max(1, std::min(num_threads, max_threads));
+}
+
+/// Start worker(tid) for tid = 1, ..., num_threads-1, each on a new thread
+/// appended to pool, until one cannot be created.
+/// @return The first tid left without a thread (num_threads if all were
+///         started).
+template<typename F>
+    int
+    start_threads(std::vector<std::thread>& pool, int num_threads, F&& worker)
+{
+    int tid = 1;
+    try {
+        pool.reserve(pool.size() + std::max(0, num_threads-1));
+        for (; tid < num_threads; tid++) pool.emplace_back(worker, tid);
+    } catch (std::system_error&) {
+    } catch (std::bad_alloc&) {
+    }
+    return tid;
+}
+
+/// Join all threads of pool.
+inline void
+join_threads(std::vector<std::thread>& pool)
+{
+    for (auto& th : pool) th.join();
+}
+
+/// Run worker(tid) for tid = 0, ..., num_threads-1, each on its own thread
+/// (the calling one included). The tids left without a thread are run by
+/// the calling thread, after worker(0); workers must thus never wait for
+/// each other. Workers that share the work dynamically find nothing left
+/// to do in these calls.
+/// @return The number of threads used, the calling one included.
+template<typename F>
+    int
+    run_threads(int num_threads, F&& worker)
+{
+    std::vector<std::thread> pool;
+    const int started = start_threads(pool, num_threads, worker);
+    worker(0);
+    for (int i = started; i < num_threads; i++) worker(i);
+    join_threads(pool);
+    return started;
+}
+
+#endif
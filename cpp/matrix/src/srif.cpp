@@ -0,0 +1,339 @@
+#include <cmath>
+#include <algorithm>
+#include "srif.hpp"
+#include "qr_covariance.hpp"
+#include "gemm_kernels.hpp"
+#include "qr_append.hpp"
+
+/// Columns of R per product in time_update.
+constexpr int srif_kb = 32;
+
+/// @brief Constructor; allocate all storage. The filter starts with no
+///        states (see reset).
+///
+/// @param[in] max_states Maximum number of states.
+/// @param[in] max_noise  Maximum number of process noise terms (p in
+///                       time_update).
+/// @param[in] max_meas   Number of observations triangularised at a time
+///                       by measurement_update.
+/// @param[in] nb         Block size of the QR factorizations (see
+///                       householder_qr_blocked).
+/// @throw     std::bad_alloc if memory allocation fails.
+srif::srif(int max_states, int max_noise, int max_meas, int nb)
+: _nmax{std::max(1, max_states)}, _pmax{std::max(0, max_noise)},
+  _kmax{std::max(1, max_meas)}, _nb{nb}, _n{0}, _rss{0e0},
+  _r((long)_nmax*_nmax, 0e0), _z(_nmax, 0e0),
+  _work(std::max((long)(_nmax+_pmax)*(_nmax+_pmax+1),
+    (long)_kmax*(_nmax+1))),
+  _beta(_nmax+_pmax), _cols(2*_nmax),
+  _ws(qr_worksize(_nmax+_pmax, _nmax+_pmax+1, nb))
+{}
+
+/// @brief Reset to n states, without any information (R = 0, z = 0).
+void
+srif::reset(int n) noexcept
+{
+    _n = std::max(0, std::min(n, _nmax));
+    std::fill(_r.begin(), _r.end(), 0e0);
+    std::fill(_z.begin(), _z.end(), 0e0);
+    _rss = 0e0;
+}
+
+/// @brief Set the a-priori state \f$x_0\f$ with (independent) standard
+///        deviations \f$\sigma\f$, i.e. \f$R = diag(1/\sigma_i)\f$,
+///        \f$z_i = x_{0,i}/\sigma_i\f$.
+///
+/// An infinite \f$\sigma_i\f$ means no information on state i.
+/// @return 0 on success, 1 if some \f$\sigma_i \leq 0\f$.
+int
+srif::set_prior(const double *__restrict__ x0, const double *__restrict__ sigma)
+noexcept
+{
+    const int n = _n;
+    for (int i = 0; i < n; i++) if (!(sigma[i] > 0e0)) return 1;
+    reset(n);
+    for (int i = 0; i < n; i++) {
+        _r[(long)i*_nmax+i] = 1e0/sigma[i];
+        _z[i] = x0[i]/sigma[i];
+    }
+    return 0;
+}
+
+/// @brief Set R (the upper triangle of the n-by-n r, column-wise with
+///        leading dimension ldr) and z.
+/// @return 0 on success, 1 if ldr < n.
+int
+srif::set_information(const double *__restrict__ r, int ldr,
+    const double *__restrict__ z)
+noexcept
+{
+    const int n = _n;
+    if (ldr < n) return 1;
+    for (int j = 0; j < n; j++) {
+        double *__restrict__ rj = _r.data() + (long)j*_nmax;
+        std::copy(r+(long)j*ldr, r+(long)j*ldr+j+1, rj);
+        std::fill(rj+j+1, rj+n, 0e0);
+    }
+    std::copy(z, z+n, _z.data());
+    return 0;
+}
+
+/// @brief Triangularise \f$[R\ z; H\ y]\f$, for at most max_meas rows.
+///
+/// Same algorithm as updatable_qr::add_rows (see qr_append_rows).
+void
+srif::absorb_rows(const double *__restrict__ h, int ldh,
+    const double *__restrict__ y, int k, const double *__restrict__ sigma)
+noexcept
+{
+    const int n = _n, ldr = _nmax;
+    // copy [H y] (scaled by 1/sigma) to the workspace, leading dimension k
+    double *__restrict__ x = _work.data();
+    int i, j;
+    for (j = 0; j < n; j++) {
+        const double *__restrict__ hj = h + (long)j*ldh;
+        double *__restrict__ xj = x + (long)j*k;
+        if (sigma) {
+            for (i = 0; i < k; i++) xj[i] = hj[i]/sigma[i];
+        } else {
+            std::copy(hj, hj+k, xj);
+        }
+    }
+    double *__restrict__ xy = x + (long)n*k;
+    for (i = 0; i < k; i++) xy[i] = sigma ? y[i]/sigma[i] : y[i];
+
+    qr_append_rows(_r.data(), ldr, _z.data(), x, k, n);
+    for (i = 0; i < k; i++) _rss += xy[i]*xy[i];
+}
+
+/// @brief Measurement update.
+///
+/// Absorb the k observations \f$y = Hx + e\f$, with independent errors of
+/// standard deviations \f$\sigma\f$ (or already whitened, i.e. of unit
+/// variance, if sigma is null), max_meas at a time.
+///
+/// @param[in] h     The k-by-n matrix H (column-wise, leading dimension
+///                  ldh).
+/// @param[in] ldh   Leading dimension of h (\f$ldh \geq k\f$).
+/// @param[in] y     The k observations.
+/// @param[in] k     Number of observations.
+/// @param[in] sigma The k standard deviations of the observations, or null.
+/// @return    0 on success, 1 on invalid arguments.
+int
+srif::measurement_update(const double *__restrict__ h, int ldh,
+    const double *__restrict__ y, int k, const double *__restrict__ sigma)
+noexcept
+{
+    if (k < 0 || ldh < k) return 1;
+    for (int i0 = 0; i0 < k; i0 += _kmax) {
+        absorb_rows(h+i0, ldh, y+i0, std::min(_kmax, k-i0),
+            sigma ? sigma+i0 : nullptr);
+    }
+    return 0;
+}
+
+/// @brief Time update (propagation with process noise).
+///
+/// For \f$x_{k+1} = \Phi x_k + G w_k\f$, \f$w_k \sim N(0, Q)\f$ and
+/// \f$Q^{-1} = R_w^T R_w\f$, triangularise the array given in srif.hpp and
+/// keep its trailing n-by-(n+1) block as the new \f$[R\ z]\f$ (the leading
+/// p rows, the information on \f$w_k\f$, are only needed by a smoother).
+///
+/// @param[in] phi_inv \f$\Phi^{-1}\f$, n-by-n (column-wise, leading
+///                    dimension ldphi).
+/// @param[in] ldphi   Leading dimension of phi_inv.
+/// @param[in] g       The n-by-p matrix G (column-wise, leading dimension
+///                    ldg); if null, G = I (and p must be n).
+/// @param[in] ldg     Leading dimension of g.
+/// @param[in] rw      The p-by-p upper triangular \f$R_w\f$ (column-wise,
+///                    leading dimension ldrw; the strictly lower triangle
+///                    is not referenced). For independent noise terms,
+///                    \f$R_w = diag(1/\sigma_{w,i})\f$.
+/// @param[in] ldrw    Leading dimension of rw.
+/// @param[in] p       Number of process noise terms (\f$\leq\f$ max_noise);
+///                    0 for a deterministic propagation.
+/// @return    0 on success, 1 on invalid arguments.
+int
+srif::time_update(const double *__restrict__ phi_inv, int ldphi,
+    const double *__restrict__ g, int ldg, const double *__restrict__ rw,
+    int ldrw, int p)
+noexcept
+{
+    const int n = _n, m = n + p, ld = m;
+    if (p < 0 || p > _pmax || ldphi < n) return 1;
+    if (p && ldrw < p) return 1;
+    if (p && (g ? ldg < n : p != n)) return 1;
+    if (!n) return 0;
+
+    double *__restrict__ a = _work.data();
+    std::fill(a, a+(long)m*(m+1), 0e0);
+    int i, j;
+
+    // [R_w; -R_d G]
+    for (j = 0; j < p; j++) {
+        for (i = 0; i <= j; i++) a[(long)j*ld+i] = rw[(long)j*ldrw+i];
+    }
+    // R_d = R Phi^{-1}; columns k0:k0+kb of R are zero below row k0+kb
+    double *__restrict__ rd = a + (long)p*ld + p;
+    for (int k0 = 0; k0 < n; k0 += srif_kb) {
+        const int kb = std::min(srif_kb, n-k0);
+        gemm_nn_sub(k0+kb, kb, n, _r.data()+(long)k0*_nmax, _nmax,
+            phi_inv+k0, ldphi, rd, ld);
+    }
+    for (j = 0; j < n; j++) {
+        for (i = 0; i < n; i++) rd[(long)j*ld+i] = -rd[(long)j*ld+i];
+    }
+    if (p) {
+        if (g) {
+            gemm_nn_sub(n, n, p, rd, ld, g, ldg, a+p, ld);
+        } else {
+            for (j = 0; j < n; j++) {
+                for (i = 0; i < n; i++) a[(long)j*ld+p+i] = -rd[(long)j*ld+i];
+            }
+        }
+    }
+    // [0; z]
+    std::copy(_z.data(), _z.data()+n, a+(long)m*ld+p);
+
+    if (householder_qr_blocked(matrix_view<double>(a, m, m+1, ld),
+        _beta.data(), _ws, _nb)) return 1;
+
+    // the trailing block is the new [R z]
+    for (j = 0; j < n; j++) {
+        double *__restrict__ rj = _r.data() + (long)j*_nmax;
+        const double *__restrict__ aj = a + (long)(p+j)*ld + p;
+        std::copy(aj, aj+j+1, rj);
+        std::fill(rj+j+1, rj+n, 0e0);
+    }
+    std::copy(a+(long)m*ld+p, a+(long)m*ld+m, _z.data());
+    return 0;
+}
+
+/// @brief Eliminate (marginalise) q parameters.
+///
+/// The columns of R of the parameters idx[0..q-1] are moved in front of
+/// the others (which keep their order), \f$[R\ z]\f$ is re-triangularised
+/// and its first q rows are dropped; the remaining n-q parameters keep
+/// their (marginal) information.
+///
+/// @param[in] idx The indexes of the parameters to eliminate (distinct,
+///                in [0, n)).
+/// @param[in] q   Number of parameters to eliminate.
+/// @return    0 on success, 1 on invalid indexes.
+int
+srif::eliminate(const int *__restrict__ idx, int q)
+noexcept
+{
+    const int n = _n, ld = n;
+    int i, j, c;
+    if (q < 0 || q > n) return 1;
+    if (!q) return 0;
+
+    // column order: idx, then the rest
+    int *__restrict__ cols = _cols.data();
+    int *__restrict__ mark = cols + _nmax;
+    std::fill(mark, mark+n, 0);
+    for (i = 0; i < q; i++) {
+        if (idx[i] < 0 || idx[i] >= n || mark[idx[i]]) return 1;
+        mark[idx[i]] = 1;
+        cols[i] = idx[i];
+    }
+    for (c = q, j = 0; j < n; j++) if (!mark[j]) cols[c++] = j;
+
+    double *__restrict__ a = _work.data();
+    for (j = 0; j < n; j++) {
+        const double *__restrict__ rj = _r.data() + (long)cols[j]*_nmax;
+        std::copy(rj, rj+n, a+(long)j*ld);
+    }
+    std::copy(_z.data(), _z.data()+n, a+(long)n*ld);
+
+    if (householder_qr_blocked(matrix_view<double>(a, n, n+1, ld),
+        _beta.data(), _ws, _nb)) return 1;
+
+    const int nn = n - q;
+    std::fill(_r.begin(), _r.end(), 0e0);
+    for (j = 0; j < nn; j++) {
+        const double *__restrict__ aj = a + (long)(q+j)*ld + q;
+        std::copy(aj, aj+j+1, _r.data()+(long)j*_nmax);
+    }
+    std::copy(a+(long)n*ld+q, a+(long)n*ld+n, _z.data());
+    std::fill(_z.begin()+nn, _z.end(), 0e0);
+    _n = nn;
+    return 0;
+}
+
+/// @brief Insert q new parameters, before parameter pos.
+///
+/// The new parameters get indexes pos..pos+q-1, with a-priori information
+/// \f$R_0 x_{new} = z_0\f$ (independent of the other parameters), or none
+/// if r0 is null. Existing rows get zeros in the new columns, so R stays
+/// upper triangular.
+///
+/// @param[in] pos  Index of the first new parameter (\f$0 \leq pos \leq n\f$).
+/// @param[in] q    Number of new parameters (\f$n+q \leq\f$ max_states).
+/// @param[in] r0   The q-by-q upper triangular \f$R_0\f$ (column-wise,
+///                 leading dimension ldr0), or null.
+/// @param[in] ldr0 Leading dimension of r0.
+/// @param[in] z0   The vector \f$z_0\f$ (size q); zero if null.
+/// @return    0 on success, 1 on invalid arguments.
+int
+srif::insert(int pos, int q, const double *__restrict__ r0, int ldr0,
+    const double *__restrict__ z0)
+noexcept
+{
+    const int n = _n, nn = n + q, ld = _nmax;
+    if (pos < 0 || pos > n || q < 0 || nn > _nmax) return 1;
+    if (r0 && ldr0 < q) return 1;
+    if (!q) return 0;
+
+    // new [R z] in the workspace, leading dimension nmax
+    double *__restrict__ a  = _work.data();
+    double *__restrict__ az = a + (long)ld*ld;
+    std::fill(a, a+(long)ld*ld+ld, 0e0);
+    auto map = [=](int k) { return k < pos ? k : k+q; };
+    for (int j = 0; j < n; j++) {
+        const double *__restrict__ rj = _r.data() + (long)j*ld;
+        double *__restrict__ aj = a + (long)map(j)*ld;
+        for (int i = 0; i <= j; i++) aj[map(i)] = rj[i];
+    }
+    for (int i = 0; i < n; i++) az[map(i)] = _z[i];
+    for (int j = 0; j < q; j++) {
+        if (r0) {
+            for (int i = 0; i <= j; i++) a[(long)(pos+j)*ld+pos+i] = r0[(long)j*ldr0+i];
+        }
+        if (z0) az[pos+j] = z0[j];
+    }
+    std::copy(a, a+(long)ld*ld, _r.data());
+    std::copy(az, az+ld, _z.data());
+    _n = nn;
+    return 0;
+}
+
+/// @brief The state estimate \f$\hat{x} = R^{-1} z\f$.
+///
+/// @param[out] x At output, the n states.
+/// @return     0 on success, 1 if R is singular (some combination of the
+///             states has no information).
+int
+srif::estimate(double *__restrict__ x) const
+noexcept
+{
+    const int n = _n;
+    if (!n) return 0;
+    std::copy(_z.data(), _z.data()+n, x);
+    return triangular_solve(true, false, _r.data(), _nmax, x, n, n, 1);
+}
+
+/// @brief The covariance matrix of the estimate, \f$(R^T R)^{-1}\f$ (see
+///        r_covariance; this allocates).
+///
+/// @param[out] cov   At output the n-by-n covariance matrix (column-wise,
+///                   leading dimension ldcov).
+/// @param[in]  ldcov Leading dimension of cov (\f$ldcov \geq n\f$).
+/// @return     0 on success; 1 if R is singular or on allocation failure.
+int
+srif::covariance(double *__restrict__ cov, int ldcov) const
+{
+    if (!_n) return 0;
+    return r_covariance(_r.data(), _nmax, cov, ldcov, _n);
+}
@@ -0,0 +1,134 @@
+#ifndef __SRIF_HPP__
+#define __SRIF_HPP__
+
+#include <vector>
+#include "qr.hpp"
+
+/// @brief Square-root information filter (SRIF).
+///
+/// The state estimate \f$\hat{x}\in{\Re}^n\f$ and its information matrix
+/// \f$\Lambda = P^{-1} = R^T R\f$ are carried as the data equation
+/// \f$z = R x + v\f$ (v of unit covariance), i.e. as the upper triangular
+/// \f$R\f$ and the vector z, with \f$\hat{x} = R^{-1} z\f$. All updates are
+/// orthogonal transformations of \f$[R\ z]\f$ (Householder, see qr.hpp), so
+/// the filter works with the square root of the information, whose
+/// condition number is that of the square root of P; it is as accurate as a
+/// covariance filter in twice the precision, and it handles states without
+/// a-priori information (zero rows of R).
+///
+///   - measurement_update: k (whitened) observations \f$y = Hx + e\f$ are
+///     absorbed by triangularising \f$[R\ z; H\ y]\f$; the Householder
+///     vectors are \f$[e_j; v_j]\f$, so R stays triangular and the cost is
+///     \f$O(kn^2)\f$. What is left of y is added to the residual sum of
+///     squares.
+///   - time_update: for \f$x_{k+1} = \Phi x_k + G w_k\f$, with p process
+///     noise terms \f$w_k\f$ of covariance \f$Q = (R_w^T R_w)^{-1}\f$,
+///     the \f$(n+p)\times(n+p+1)\f$ array
+///     \f[ \left( \begin{array}{ccc} R_w & 0 & 0
+///         \\ -R_d G & R_d & z \end{array} \right),\quad R_d = R\Phi^{-1} \f]
+///     is triangularised (blocked Householder QR); its trailing n-by-(n+1)
+///     block is the new \f$[R\ z]\f$ (Bierman, ch. VI). p = 0 is a
+///     deterministic propagation.
+///   - eliminate: parameters are removed (their information is
+///     marginalised) by moving their columns in front and
+///     re-triangularising; the trailing block is the information of the
+///     remaining parameters.
+///   - insert: new parameters (e.g. ambiguities or biases) are added with
+///     a given a-priori (upper triangular) information, or with none; R
+///     stays triangular, so nothing is recomputed.
+///
+/// All storage (for at most max_states states, max_noise process noise
+/// terms and max_meas observations per triangularisation; larger batches
+/// of observations are absorbed in chunks) is allocated at construction, so
+/// the updates do not allocate.
+///
+/// Reference: Bierman, G.J., Factorization Methods for Discrete Sequential
+///            Estimation, Academic Press, 1977, ch. V, VI
+///
+/// @example test_srif.cpp
+class srif
+{
+public:
+    srif(int max_states, int max_noise, int max_meas = 32, int nb = 32);
+
+    void
+    reset(int n) noexcept;
+
+    int
+    set_prior(const double *__restrict__ x0, const double *__restrict__ sigma)
+    noexcept;
+
+    int
+    set_information(const double *__restrict__ r, int ldr,
+        const double *__restrict__ z) noexcept;
+
+    int
+    measurement_update(const double *__restrict__ h, int ldh,
+        const double *__restrict__ y, int k,
+        const double *__restrict__ sigma = nullptr) noexcept;
+
+    int
+    time_update(const double *__restrict__ phi_inv, int ldphi,
+        const double *__restrict__ g, int ldg, const double *__restrict__ rw,
+        int ldrw, int p) noexcept;
+
+    int
+    eliminate(const int *__restrict__ idx, int q) noexcept;
+
+    int
+    insert(int pos, int q, const double *__restrict__ r0 = nullptr,
+        int ldr0 = 0, const double *__restrict__ z0 = nullptr) noexcept;
+
+    int
+    estimate(double *__restrict__ x) const noexcept;
+
+    int
+    covariance(double *__restrict__ cov, int ldcov) const;
+
+    /// Number of states n.
+    int
+    num_states() const noexcept
+    { return _n; }
+
+    /// The (n-by-n, column-wise, leading dimension ld()) upper triangular
+    /// square root information matrix R.
+    const double*
+    r() const noexcept
+    { return _r.data(); }
+
+    /// Leading dimension of r(), i.e. max_states.
+    int
+    ld() const noexcept
+    { return _nmax; }
+
+    /// The vector z (of size n).
+    const double*
+    z() const noexcept
+    { return _z.data(); }
+
+    /// Residual sum of squares of the (whitened) observations so far.
+    double
+    rss() const noexcept
+    { return _rss; }
+
+private:
+    void
+    absorb_rows(const double *__restrict__ h, int ldh,
+        const double *__restrict__ y, int k,
+        const double *__restrict__ sigma) noexcept;
+
+    int                 _nmax;  ///< max number of states
+    int                 _pmax;  ///< max number of process noise terms
+    int                 _kmax;  ///< max observations per triangularisation
+    int                 _nb;    ///< QR block size
+    int                 _n;     ///< number of states
+    double              _rss;   ///< residual sum of squares
+    std::vector<double> _r;     ///< R, nmax-by-nmax (n-by-n used)
+    std::vector<double> _z;     ///< z
+    std::vector<double> _work;  ///< arrays to triangularise
+    std::vector<double> _beta;  ///< Householder coefficients
+    std::vector<int>    _cols;  ///< column order and marks (eliminate)
+    qr_workspace        _ws;    ///< QR workspace
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "lu.hpp"
+#include "eigen3/Eigen/Core"
+#include "eigen3/Eigen/LU"
+
+// Check lu_factor (unblocked, blocked, multithreaded) against Eigen's
+// PartialPivLU (same pivots and factors), lu_solve against Eigen's
+// solution for many right-hand sides, and square_lu on a diagonally
+// dominant matrix (where no pivoting is needed).
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+    std::uniform_real_distribution<double> distr(-125e0, 125e0);
+
+    int sizes[]   = {1, 2, 5, 63, 64, 65, 200, 700};
+    int blocks[]  = {0, 8, 64};
+    int threads[] = {1, 3};
+    int rc;
+
+    for (int n : sizes) {
+        Eigen::MatrixXd Ae(n, n);
+        for (int j = 0; j < n; j++)
+            for (int i = 0; i < n; i++) Ae(i, j) = distr(eng);
+        std::vector<double> A(Ae.data(), Ae.data()+n*n);
+        Eigen::PartialPivLU<Eigen::MatrixXd> elu(Ae);
+        const Eigen::MatrixXd& LUe = elu.matrixLU();
+        // Eigen's row permutation, as the final position of each row
+        Eigen::VectorXi perm = elu.permutationP().indices();
+
+        const int k = 17;
+        Eigen::MatrixXd Be(n, k);
+        for (int j = 0; j < k; j++)
+            for (int i = 0; i < n; i++) Be(i, j) = distr(eng);
+        Eigen::MatrixXd Xe = elu.solve(Be);
+        const double xmax = Xe.cwiseAbs().maxCoeff();
+
+        for (int nb : blocks) {
+            for (int nt : threads) {
+                std::vector<double> a = A;
+                std::vector<int> ipiv(n);
+                rc = lu_factor(a.data(), n, ipiv.data(), nb, nt);
+                assert( !rc );
+
+                // same factors and pivots
+                double dlu = 0e0;
+                for (int j = 0; j < n; j++)
+                    for (int i = 0; i < n; i++)
+                        dlu = std::max(dlu, std::abs(a[j*n+i]-LUe(i, j)));
+                // same permutation: apply the interchanges to 0..n-1
+                std::vector<int> rows(n);
+                for (int i = 0; i < n; i++) rows[i] = i;
+                for (int i = 0; i < n; i++) std::swap(rows[i], rows[ipiv[i]]);
+                for (int i = 0; i < n; i++) assert( perm(rows[i]) == i );
+
+                std::vector<double> b(n*k);
+                for (int j = 0; j < k; j++)
+                    for (int i = 0; i < n; i++) b[j*n+i] = Be(i, j);
+                rc = lu_solve(a.data(), n, ipiv.data(), b.data(), n, k, nt);
+                assert( !rc );
+                double dx = 0e0;
+                for (int j = 0; j < k; j++)
+                    for (int i = 0; i < n; i++) dx = std::max(dx, std::abs(b[j*n+i]-Xe(i, j)));
+
+                printf("\nn=%4d nb=%2d threads=%d max diff LU: %.3e, rel. diff X: %.3e",
+                    n, nb, nt, dlu, dx/xmax);
+                assert( dlu < 1e-10*(1e0+LUe.cwiseAbs().maxCoeff()) && dx < 1e-9*xmax );
+            }
+        }
+
+        // threaded blocked factorization gives the same bits as serial
+        std::vector<double> a1 = A, a3 = A;
+        std::vector<int> p1(n), p3(n);
+        lu_factor(a1.data(), n, p1.data(), 16, 1);
+        lu_factor(a3.data(), n, p3.data(), 16, 3);
+        assert( a1 == a3 && p1 == p3 );
+
+        // no pivoting needed for a (column) diagonally dominant matrix
+        for (int i = 0; i < n; i++) Ae(i, i) = 150e0*n;
+        std::vector<double> d(Ae.data(), Ae.data()+n*n), d2 = d;
+        std::vector<int> ipiv(n);
+        square_lu(d.data(), n);
+        rc = lu_factor(d2.data(), n, ipiv.data(), 64, 1);
+        assert( !rc );
+        for (int i = 0; i < n; i++) assert( ipiv[i] == i );
+        double dsq = 0e0;
+        for (int i = 0; i < n*n; i++) dsq = std::max(dsq, std::abs(d[i]-d2[i]));
+        assert( dsq < 1e-9*150e0*n );
+    }
+
+    // singular matrix
+    double S[] = {1e0, 2e0, 2e0, 4e0};
+    int ip[2];
+    rc = lu_factor(S, 2, ip);
+    assert( rc == 1 );
+
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,268 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <unistd.h>
+
+#include "qr.hpp"
+#include "qr_ooc.hpp"
+#include "matrix_file.hpp"
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using row_major_view = matrix_view<double, matrix_layout::row_major>;
+
+// Write matrices to matrix files (whole, and by blocks of rows of either
+// layout), map them and factorize/solve on the mapped views; the results
+// must be those of the in-memory matrices, and the files unchanged.
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+    std::uniform_real_distribution<double> distr(-125e0, 125e0);
+
+    char path[] = "/tmp/test_matrix_file_XXXXXX";
+    int rc;
+    const int fd = mkstemp(path);
+    assert( fd >= 0 );
+    close(fd);
+
+    // column-major: QR of the mapped view, without copying
+    {
+        const int m = 301, n = 45;
+        aligned_matrix<double> A(m, n);
+        for (int j = 0; j < n; j++) for (int i = 0; i < m; i++) A(i, j) = distr(eng);
+        rc = write_matrix_file(path, A.view());
+        assert( !rc );
+
+        mapped_matrix f;
+        rc = f.open(path);
+        assert( !rc );
+        assert( f.rows() == m && f.cols() == n && f.ld() == A.ld() );
+        assert( f.layout() == matrix_layout::col_major );
+        matrix_view<double> v;
+        row_major_view rv;
+        rc = f.view(rv);
+        assert( rc == 1 ); // wrong layout
+        rc = f.view(v);
+        assert( !rc );
+        assert( reinterpret_cast<std::uintptr_t>(v.data()) % matrix_alignment == 0 );
+        for (int j = 0; j < n; j++) for (int i = 0; i < m; i++) assert( v(i, j) == A(i, j) );
+
+        std::vector<double> a(A.data(), A.data()+A.ld()*n), beta(n), beta_f(n);
+        qr_workspace ws;
+        rc = householder_qr(matrix_view<double>(a.data(), m, n, A.ld()), beta.data(), ws);
+        assert( !rc );
+        rc = householder_qr(v, beta_f.data(), ws);
+        assert( !rc );
+        for (int j = 0; j < n; j++) {
+            assert( beta[j] == beta_f[j] );
+            for (int i = 0; i < m; i++) assert( v(i, j) == a[j*A.ld()+i] );
+        }
+        // the mapping is private: the file still holds A
+        mapped_matrix g;
+        rc = g.open(path);
+        assert( !rc );
+        matrix_view<const double> cv;
+        rc = static_cast<const mapped_matrix&>(g).view(cv);
+        assert( !rc );
+        for (int j = 0; j < n; j++) for (int i = 0; i < m; i++) assert( cv(i, j) == A(i, j) );
+        mapped_matrix moved = std::move(g);
+        rc = g.view(v);
+        assert( moved.rows() == m && rc == 1 );
+        printf("\ncolumn-major %d x %d (ld %ld): mapped QR == in-memory QR", m, n, f.ld());
+    }
+
+    // row-major [A b], written by blocks of rows of both layouts, with the
+    // number of rows unknown in advance
+    {
+        const int m = 2000, n = 30;
+        std::vector<double> A(m*(n+1)); // column-wise [A b]
+        for (auto& v : A) v = distr(eng);
+        matrix_file_writer w;
+        rc = w.open(path, n+1);
+        assert( !rc );
+        int row = 0;
+        for (int k : {1, 7, 100, 0, 333, 1000}) {
+            if (k % 2) {
+                // a column-major block of the column-wise array
+                rc = w.append(A.data()+row, k, m);
+                assert( !rc );
+            } else {
+                // a row-major block
+                std::vector<double> r(k*(n+1));
+                for (int i = 0; i < k; i++) for (int j = 0; j <= n; j++) r[i*(n+1)+j] = A[j*m+row+i];
+                rc = w.append(row_major_view(r.data(), k, n+1));
+                assert( !rc );
+            }
+            row += k;
+        }
+        rc = w.append(matrix_view<const double>(A.data()+row, m-row, n+1, m));
+        assert( !rc );
+        assert( w.rows() == m );
+        rc = w.close();
+        assert( !rc );
+
+        mapped_matrix f;
+        rc = f.open(path);
+        assert( !rc );
+        assert( f.rows() == m && f.cols() == n+1 && f.ld() == n+1 );
+        row_major_view v;
+        rc = f.view(v);
+        assert( !rc );
+        for (int j = 0; j <= n; j++) for (int i = 0; i < m; i++) assert( v(i, j) == A[j*m+i] );
+
+        // in memory, from the mapped (row-major) array, and out of core
+        std::vector<double> a(A.begin(), A.begin()+m*n), y(A.begin()+m*n, A.end());
+        rc = ls_qrsolve(a.data(), y.data(), m, n);
+        assert( !rc );
+        std::vector<double> x_ooc(n), b(m);
+        rc = ls_qrsolve_ooc(path, f.payload_offset(), f.rows(), n, x_ooc.data(), nullptr, nullptr, 128);
+        assert( !rc );
+        for (int i = 0; i < m; i++) b[i] = v(i, n);
+        qr_workspace ws;
+        rc = ls_qrsolve(v.block(0, 0, m, n), b.data(), ws);
+        assert( !rc );
+        double dx = 0e0, dx_ooc = 0e0, xmax = 0e0;
+        for (int j = 0; j < n; j++) {
+            xmax   = std::max(xmax, std::abs(y[j]));
+            dx     = std::max(dx, std::abs(b[j]-y[j]));
+            dx_ooc = std::max(dx_ooc, std::abs(x_ooc[j]-y[j]));
+        }
+        printf("\nrow-major %d x %d: rel. diff x mapped: %.3e, out-of-core: %.3e",
+            m, n+1, dx/xmax, dx_ooc/xmax);
+        assert( dx < 1e-12*xmax && dx_ooc < 1e-10*xmax );
+    }
+
+    // column-major file from row blocks
+    {
+        const int m = 50, n = 3;
+        std::vector<double> r(m*n);
+        for (auto& v : r) v = distr(eng);
+        matrix_file_writer w;
+        rc = w.open(path, n, matrix_layout::col_major);
+        assert( rc == 1 ); // rows needed
+        rc = w.open(path, n, matrix_layout::col_major, m);
+        assert( !rc );
+        rc = w.append(row_major_view(r.data(), 20, n));
+        assert( !rc );
+        rc = w.append(row_major_view(r.data(), 20, n+1));
+        assert( rc == 1 ); // wrong cols
+        rc = w.append(row_major_view(r.data()+20*n, 30, n));
+        assert( !rc );
+        rc = w.append(row_major_view(r.data(), 1, n));
+        assert( rc == 1 ); // too many rows
+        rc = w.close();
+        assert( !rc );
+        mapped_matrix f;
+        matrix_view<const double> v;
+        rc = f.open(path);
+        assert( !rc );
+        rc = f.view(v);
+        assert( !rc );
+        for (int i = 0; i < m; i++) for (int j = 0; j < n; j++) assert( v(i, j) == r[i*n+j] );
+
+        // fewer rows than declared
+        rc = w.open(path, n, matrix_layout::col_major, m);
+        assert( !rc );
+        rc = w.append(row_major_view(r.data(), 20, n));
+        assert( !rc );
+        rc = w.close();
+        assert( rc == 1 );
+    }
+
+    // invalid files
+    {
+        mapped_matrix f;
+        rc = f.open("/nonexistent/file");
+        assert( rc == 1 );
+        std::vector<double> a(64*8, 1e0);
+        rc = write_matrix_file(path, matrix_view<const double>(a.data(), 64, 8));
+        assert( !rc );
+        // truncated payload
+        rc = truncate(path, 64+64*8*8-8);
+        assert( !rc );
+        rc = f.open(path);
+        assert( rc == 1 );
+        // bad magic
+        rc = write_matrix_file(path, matrix_view<const double>(a.data(), 64, 8));
+        assert( !rc );
+        FILE *fp = std::fopen(path, "r+b");
+        std::fputc('X', fp);
+        std::fclose(fp);
+        rc = f.open(path);
+        assert( rc == 1 );
+
+        // a (valid, empty) file whose leading dimension does not fit in the
+        // int of a matrix_view: it opens, but gives no view
+        matrix_file_header h {};
+        std::copy(matrix_file_magic, matrix_file_magic+8, h.magic);
+        h.byte_order = matrix_file_byte_order;
+        h.version    = matrix_file_version;
+        h.dtype      = static_cast<std::uint8_t>(matrix_dtype::float64);
+        h.ld         = 1L << 32;
+        h.payload    = sizeof(h);
+        fp = std::fopen(path, "wb");
+        std::fwrite(&h, sizeof(h), 1, fp);
+        std::fclose(fp);
+        matrix_view<double> v;
+        rc = f.open(path);
+        assert( !rc && f.ld() == 1L << 32 );
+        rc = f.view(v);
+        assert( rc == 1 );
+
+        // sizes a matrix_view cannot hold are not written
+        matrix_file_writer w;
+        rc = w.open(path, 1L << 31);
+        assert( rc == 1 );
+        rc = w.open(path, 4, matrix_layout::row_major, 1L << 31);
+        assert( rc == 1 );
+        rc = w.open(path, 4, matrix_layout::col_major, INT32_MAX);
+        assert( rc == 1 );
+    }
+
+    // timing: text vs binary round trip
+    {
+        const int m = 100000, n = 20;
+        std::vector<double> A(m*n);
+        for (auto& v : A) v = distr(eng);
+        auto t0 = Clock::now();
+        FILE *fp = std::fopen(path, "w");
+        for (int i = 0; i < m; i++) {
+            for (int j = 0; j < n; j++) std::fprintf(fp, "%.17g ", A[j*m+i]);
+            std::fputc('\n', fp);
+        }
+        std::fclose(fp);
+        std::vector<double> B(m*n);
+        fp = std::fopen(path, "r");
+        int nread = 0;
+        for (int i = 0; i < m; i++) for (int j = 0; j < n; j++) nread += std::fscanf(fp, "%lf", &B[j*m+i]);
+        std::fclose(fp);
+        assert( nread == m*n );
+        auto t1 = Clock::now();
+        rc = write_matrix_file(path, matrix_view<const double>(A.data(), m, n));
+        assert( !rc );
+        mapped_matrix f;
+        matrix_view<const double> v;
+        rc = f.open(path);
+        assert( !rc );
+        rc = f.view(v);
+        assert( !rc );
+        double sum = 0e0;
+        for (int j = 0; j < n; j++) for (int i = 0; i < m; i++) sum += v(i, j) - B[j*m+i];
+        auto t2 = Clock::now();
+        assert( sum == 0e0 );
+        printf("\n%d x %d write + read: text %ld ms, binary (mapped) %ld ms", m, n,
+            (long)duration_cast<milliseconds>(t1-t0).count(),
+            (long)duration_cast<milliseconds>(t2-t1).count());
+    }
+
+    std::remove(path);
+    printf("\n");
+    return 0;
+}
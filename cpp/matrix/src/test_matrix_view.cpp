@@ -0,0 +1,157 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "qr.hpp"
+#include "matrix_view.hpp"
+#include "eigen3/Eigen/Core"
+#include "eigen3/Eigen/QR"
+
+using row_major_view = matrix_view<double, matrix_layout::row_major>;
+using EigenRowMajor =
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+// Check matrix_view/aligned_matrix indexing, and that the view overloads
+// of the QR routines work on blocks of larger matrices (same bits as on a
+// contiguous copy) and on row-major (Eigen) matrices without transposing.
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+    std::uniform_real_distribution<double> distr(-125e0, 125e0);
+
+    // indexing, blocks and transposes
+    {
+        aligned_matrix<double> M(13, 5);
+        assert( M.ld() == 16 && M.rows() == 13 && M.cols() == 5 );
+        assert( reinterpret_cast<std::uintptr_t>(M.data()) % matrix_alignment == 0 );
+        for (int j = 0; j < 5; j++) for (int i = 0; i < 13; i++) M(i, j) = 100*i+j;
+        auto blk = M.view().block(2, 1, 4, 3);
+        assert( blk(0, 0) == 201 && blk(3, 2) == 503 && blk.ld() == 16 );
+        assert( !blk.contiguous() );
+        auto t = blk.transpose();
+        static_assert(decltype(t)::layout == matrix_layout::row_major, "");
+        assert( t.rows() == 3 && t.cols() == 4 && t(2, 3) == blk(3, 2) );
+        matrix_view<const double> cblk = blk;
+        assert( &cblk(1, 1) == &M(3, 2) );
+
+        aligned_matrix<double, matrix_layout::row_major> R(3, 9);
+        assert( R.ld() == 16 );
+        R(2, 8) = 1e0;
+        assert( R.data()[2*16+8] == 1e0 );
+        aligned_matrix<double> moved = std::move(M);
+        assert( moved(12, 4) == 1204 && M.data() == nullptr );
+    }
+
+    int shapes[][2] = {{1,1}, {5,3}, {40,40}, {100,37}, {700,90}};
+    qr_workspace ws;
+    int sign, rc;
+
+    for (auto& s : shapes) {
+        const int m = s[0], n = s[1];
+        // A is the block at (3, 2) of a larger (aligned) matrix
+        aligned_matrix<double> big(m+7, n+4);
+        for (int j = 0; j < big.cols(); j++)
+            for (int i = 0; i < big.rows(); i++) big(i, j) = distr(eng);
+        auto av = big.view().block(3, 2, m, n);
+        std::vector<double> A(m*n), y(m);
+        for (int j = 0; j < n; j++) for (int i = 0; i < m; i++) A[j*m+i] = av(i, j);
+        for (auto& x : y) x = distr(eng);
+
+        // unblocked and blocked QR of the block, in place: same bits as the
+        // contiguous versions, rest of the matrix untouched
+        for (int blocked = 0; blocked < 2; blocked++) {
+            aligned_matrix<double> big2(big.rows(), big.cols());
+            std::copy(big.data(), big.data()+(long)big.ld()*big.cols(), big2.data());
+            auto av2 = big2.view().block(3, 2, m, n);
+            std::vector<double> a = A, b1(n), b2(n);
+            if (blocked) {
+                householder_qr_blocked(a.data(), b1.data(), m, n, sign, 8);
+                rc = householder_qr_blocked(av2, b2.data(), ws, 8);
+                assert( !rc );
+            } else {
+                householder_qr(a.data(), b1.data(), m, n, sign);
+                rc = householder_qr(av2, b2.data(), ws);
+                assert( !rc );
+            }
+            assert( b1 == b2 );
+            for (int j = 0; j < big.cols(); j++) {
+                for (int i = 0; i < big.rows(); i++) {
+                    const bool in = i >= 3 && i < 3+m && j >= 2 && j < 2+n;
+                    assert( big2(i, j) == (in ? a[(j-2)*m+i-3] : big(i, j)) );
+                }
+            }
+        }
+
+        // row-major QR of an Eigen row-major matrix, in place
+        EigenRowMajor Ar(m, n);
+        for (int j = 0; j < n; j++) for (int i = 0; i < m; i++) Ar(i, j) = A[j*m+i];
+        std::vector<double> a = A, b1(n), b2(n);
+        householder_qr(a.data(), b1.data(), m, n, sign);
+        rc = householder_qr(row_major_view(Ar.data(), m, n), b2.data(), ws);
+        assert( !rc );
+        double amax = 0e0, dqr = 0e0, dbeta = 0e0;
+        for (int j = 0; j < n; j++) {
+            dbeta = std::max(dbeta, std::abs(b1[j]-b2[j]));
+            for (int i = 0; i < m; i++) {
+                amax = std::max(amax, std::abs(a[j*m+i]));
+                dqr  = std::max(dqr, std::abs(a[j*m+i]-Ar(i, j)));
+            }
+        }
+
+        // LS solution, on a block (column-major) and on a row-major matrix
+        double dls = 0e0, dlsr = 0e0, xmax = 0e0;
+        if (m > n) {
+            Eigen::MatrixXd Ae(m, n);
+            Eigen::VectorXd ye(m);
+            for (int j = 0; j < n; j++) for (int i = 0; i < m; i++) Ae(i, j) = A[j*m+i];
+            for (int i = 0; i < m; i++) ye(i) = y[i];
+            Eigen::VectorXd xe = Ae.householderQr().solve(ye);
+            xmax = xe.cwiseAbs().maxCoeff();
+
+            aligned_matrix<double> big2(big.rows(), big.cols());
+            std::copy(big.data(), big.data()+(long)big.ld()*big.cols(), big2.data());
+            std::vector<double> x1 = y, x2 = y;
+            rc = ls_qrsolve(big2.view().block(3, 2, m, n), x1.data(), ws);
+            assert( !rc );
+            for (int j = 0; j < n; j++) for (int i = 0; i < m; i++) Ar(i, j) = A[j*m+i];
+            rc = ls_qrsolve(row_major_view(Ar.data(), m, n), x2.data(), ws);
+            assert( !rc );
+            for (int i = 0; i < n; i++) {
+                dls  = std::max(dls, std::abs(x1[i]-xe(i)));
+                dlsr = std::max(dlsr, std::abs(x2[i]-xe(i)));
+            }
+        }
+
+        printf("\n%4d x %3d max diff row-major QR: %.3e, beta: %.3e; rel. diff LS: %.3e (row-major: %.3e)",
+            m, n, dqr/amax, dbeta, xmax > 0e0 ? dls/xmax : 0e0, xmax > 0e0 ? dlsr/xmax : 0e0);
+        assert( dqr < 1e-12*amax && dbeta < 1e-12 );
+        assert( dls <= 1e-9*xmax && dlsr <= 1e-9*xmax );
+    }
+
+    // triangular solve on blocks of larger matrices
+    {
+        const int n = 50, k = 7;
+        aligned_matrix<double> T(n+3, n+3), B(n+5, k+2);
+        for (int j = 0; j < n+3; j++) for (int i = 0; i < n+3; i++) T(i, j) = distr(eng);
+        for (int j = 0; j < n; j++) T(1+j, 2+j) = 1e3;
+        for (int j = 0; j < k+2; j++) for (int i = 0; i < n+5; i++) B(i, j) = distr(eng);
+        auto tv = T.view().block(1, 2, n, n);
+        auto bv = B.view().block(4, 1, n, k);
+        std::vector<double> t(n*n), b(n*k);
+        for (int j = 0; j < n; j++) for (int i = 0; i < n; i++) t[j*n+i] = tv(i, j);
+        for (int j = 0; j < k; j++) for (int i = 0; i < n; i++) b[j*n+i] = bv(i, j);
+        triangular_solve(true, false, t.data(), n, b.data(), n, n, k);
+        rc = triangular_solve(true, false, tv, bv);
+        assert( !rc );
+        for (int j = 0; j < k; j++) for (int i = 0; i < n; i++) assert( b[j*n+i] == bv(i, j) );
+        rc = triangular_solve(true, false, tv, B.view().block(0, 0, n-1, k));
+        assert( rc == 1 );
+    }
+
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "qr.hpp"
+#include "qr_batched.hpp"
+#include "eigen3/Eigen/Core"
+#include "eigen3/Eigen/QR"
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+// Solve many small LS problems with ls_qrsolve_batched<L>, check the
+// solutions against Eigen and time against one ls_qrsolve call per problem.
+template<int L>
+    void
+    run(int m, int n, int nprob, std::mt19937& eng)
+{
+    std::uniform_real_distribution<double> distr(-125e0, 125e0);
+    std::vector<double> A(m*n*nprob), Y(m*nprob), X(n*nprob), A1, Y1;
+    for (auto& x : A) x = distr(eng);
+    for (auto& x : Y) x = distr(eng);
+
+    const int ngroups = (nprob+L-1)/L;
+    std::vector<double> Ab(ngroups*L*m*n), Yb(ngroups*L*m);
+    auto start = Clock::now();
+    batch_interleave<L>(A.data(), m, n, nprob, Ab.data());
+    batch_interleave<L>(Y.data(), m, 1, nprob, Yb.data());
+    const int rc = ls_qrsolve_batched<L>(Ab.data(), Yb.data(), m, n, ngroups);
+    batch_deinterleave<L>(Yb.data(), m, 1, n, nprob, X.data());
+    auto t1 = duration_cast<microseconds>(Clock::now() - start).count();
+    assert( !rc );
+
+    A1 = A; Y1 = Y;
+    start = Clock::now();
+    for (int q = 0; q < nprob; q++) ls_qrsolve(A1.data()+q*m*n, Y1.data()+q*m, m, n);
+    auto t2 = duration_cast<microseconds>(Clock::now() - start).count();
+
+    double maxdiff = 0e0;
+    for (int q = 0; q < nprob; q++) {
+        Eigen::MatrixXd Ae(m, n);
+        Eigen::VectorXd ye(m);
+        for (int i = 0; i < m; i++) {
+            ye(i) = Y[q*m+i];
+            for (int j = 0; j < n; j++) Ae(i,j) = A[(q*n+j)*m+i];
+        }
+        Eigen::VectorXd xe = Eigen::HouseholderQR<Eigen::MatrixXd>(Ae).solve(ye);
+        for (int j = 0; j < n; j++) {
+            maxdiff = std::max(maxdiff, std::abs(X[q*n+j]-xe(j))/(1e0+std::abs(xe(j))));
+        }
+    }
+    printf("\nL=%d %3d x %3d problems=%6d max rel. diff vs Eigen: %.3e  batched: %ld us, ls_qrsolve: %ld us",
+        L, m, n, nprob, maxdiff, (long)t1, (long)t2);
+    assert( maxdiff < 1e-9 );
+}
+
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+
+    run<4>(10, 4, 10007, eng);
+    run<8>(10, 4, 10007, eng);
+    run<4>(30, 6, 5001, eng);
+    run<8>(30, 6, 5001, eng);
+    run<4>(5, 5, 3, eng);
+
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,44 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "qr.hpp"
+
+// Check that householder_qr_blocked gives the same factorization as
+// householder_qr, for a number of shapes and block sizes.
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+    std::uniform_real_distribution<double> distr(-125e0, 125e0);
+
+    int shapes[][2] = {{10,4}, {50,50}, {300,77}, {1000,20}, {129,128}};
+    int blocks[]    = {1, 3, 8, 32};
+    int sign;
+
+    for (auto& s : shapes) {
+        int m = s[0], n = s[1];
+        std::vector<double> A(m*n), A1, A2, b1(n), b2(n);
+        for (auto& x : A) x = distr(eng);
+        A1 = A;
+        householder_qr(A1.data(), b1.data(), m, n, sign);
+        assert( !sign );
+        for (int nb : blocks) {
+            A2 = A;
+            householder_qr_blocked(A2.data(), b2.data(), m, n, sign, nb);
+            assert( !sign );
+            double maxdiff = 0e0;
+            for (int i = 0; i < m*n; i++) {
+                maxdiff = std::max(maxdiff, std::abs(A1[i]-A2[i])/(1e0+std::abs(A1[i])));
+            }
+            for (int i = 0; i < n; i++) assert( std::abs(b1[i]-b2[i]) < 1e-10 );
+            printf("\n%5d x %5d nb=%2d max rel. diff: %.3e", m, n, nb, maxdiff);
+            assert( maxdiff < 1e-9 );
+        }
+    }
+
+    printf("\n");
+    return 0;
+}
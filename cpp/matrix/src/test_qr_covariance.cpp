@@ -0,0 +1,107 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "qr.hpp"
+#include "qr_covariance.hpp"
+#include "eigen3/Eigen/Core"
+#include "eigen3/Eigen/LU"
+
+// Check r_inverse, r_covariance (serial and multithreaded),
+// r_covariance_diag and r_covariance_block against Eigen's inverse of
+// R^T R, for R the triangular factor of random LS systems.
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+    std::uniform_real_distribution<double> distr(-125e0, 125e0);
+
+    int shapes[][2] = {{5,1}, {10,4}, {80,63}, {300,65}, {1000,200}};
+    int threads[]   = {1, 3, 8};
+    int sign, rc;
+    const double scale = 2.5e0;
+
+    for (auto& s : shapes) {
+        const int m = s[0], n = s[1], ld = n+2;
+        std::vector<double> A(m*n), b(n), R(ld*n, 0e0);
+        for (auto& x : A) x = distr(eng);
+        householder_qr(A.data(), b.data(), m, n, sign);
+        assert( !sign );
+        Eigen::MatrixXd Re = Eigen::MatrixXd::Zero(n, n);
+        for (int j = 0; j < n; j++) {
+            for (int i = 0; i <= j; i++) R[j*ld+i] = Re(i, j) = A[j*m+i];
+        }
+        Eigen::MatrixXd C = scale*(Re.transpose()*Re).inverse();
+        const double cmax = C.cwiseAbs().maxCoeff();
+
+        // R^{-1}, out of place and in place
+        std::vector<double> Ri(n*n, 0e0), R2 = R;
+        rc = r_inverse(R.data(), ld, Ri.data(), n, n);
+        assert( !rc );
+        rc = r_inverse(R2.data(), ld, R2.data(), ld, n);
+        assert( !rc );
+        Eigen::MatrixXd Rie = Re.inverse();
+        double dinv = 0e0, rimax = Rie.cwiseAbs().maxCoeff();
+        for (int j = 0; j < n; j++) {
+            for (int i = 0; i <= j; i++) {
+                dinv = std::max(dinv, std::abs(Ri[j*n+i]-Rie(i, j)));
+                assert( Ri[j*n+i] == R2[j*ld+i] );
+            }
+        }
+
+        // full covariance matrix
+        double dcov = 0e0;
+        for (int nt : threads) {
+            std::vector<double> cov(ld*n, 0e0);
+            rc = r_covariance(R.data(), ld, cov.data(), ld, n, scale, nt);
+            assert( !rc );
+            for (int j = 0; j < n; j++) {
+                for (int i = 0; i < n; i++) {
+                    dcov = std::max(dcov, std::abs(cov[j*ld+i]-C(i, j)));
+                }
+            }
+        }
+
+        // diagonal
+        double ddiag = 0e0;
+        for (int nt : threads) {
+            std::vector<double> d(n);
+            rc = r_covariance_diag(R.data(), ld, d.data(), n, scale, nt);
+            assert( !rc );
+            for (int i = 0; i < n; i++) ddiag = std::max(ddiag, std::abs(d[i]-C(i, i)));
+        }
+
+        // diagonal blocks of 3 (and the trailing one)
+        double dblk = 0e0;
+        for (int i0 = 0; i0 < n; i0 += 3) {
+            const int k = std::min(3, n-i0);
+            double blk[3*3];
+            rc = r_covariance_block(R.data(), ld, n, i0, k, blk, 3, scale);
+            assert( !rc );
+            for (int j = 0; j < k; j++) {
+                for (int i = 0; i < k; i++) {
+                    dblk = std::max(dblk, std::abs(blk[j*3+i]-C(i0+i, i0+j)));
+                }
+            }
+        }
+
+        printf("\n%5d x %4d max rel. diff R^-1: %.3e cov: %.3e diag: %.3e blocks: %.3e",
+            m, n, dinv/rimax, dcov/cmax, ddiag/cmax, dblk/cmax);
+        assert( dinv < 1e-12*rimax && dcov < 1e-11*cmax );
+        assert( ddiag < 1e-11*cmax && dblk < 1e-11*cmax );
+    }
+
+    // singular R
+    double R[] = {1e0, 0e0, 2e0, 0e0}, cov[4];
+    rc = r_covariance(R, 2, cov, 2, 2);
+    assert( rc == 1 );
+    rc = r_covariance_diag(R, 2, cov, 2);
+    assert( rc == 1 );
+    rc = r_inverse(R, 2, cov, 2, 2);
+    assert( rc == 1 );
+
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include "qr.hpp"
+#include "qr_fixed.hpp"
+#include "eigen3/Eigen/Core"
+#include "eigen3/Eigen/QR"
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+// Fit y = 1 + 2t - 0.5t^2 (exact data), at compile time.
+constexpr double
+fit_at_compile_time(int k)
+{
+    double a[5*3] = {1e0, 1e0, 1e0, 1e0, 1e0,
+                     0e0, 1e0, 2e0, 3e0, 4e0,
+                     0e0, 1e0, 4e0, 9e0, 16e0};
+    double y[5] = {};
+    for (int i = 0; i < 5; i++) y[i] = 1e0 + 2e0*a[5+i] - 0.5e0*a[10+i];
+    ls_qrsolve<5,3>(a, y);
+    return y[k];
+}
+
+constexpr bool
+near(double x, double y)
+{ return (x-y < 1e-12) && (y-x < 1e-12); }
+
+static_assert( near(fit_at_compile_time(0), 1e0), "constexpr ls_qrsolve" );
+static_assert( near(fit_at_compile_time(1), 2e0), "constexpr ls_qrsolve" );
+static_assert( near(fit_at_compile_time(2), -0.5e0), "constexpr ls_qrsolve" );
+
+// Check householder_qr<M,N>/ls_qrsolve<M,N> against householder_qr and
+// Eigen, and time them against householder_qr.
+template<int M, int N>
+    void
+    run(std::mt19937& eng)
+{
+    std::uniform_real_distribution<double> distr(-125e0, 125e0);
+    double A[M*N], A1[M*N], A2[M*N], y[M], b1[N], b2[N];
+    int sign;
+    for (auto& x : A) x = distr(eng);
+    for (auto& x : y) x = distr(eng);
+
+    for (int i = 0; i < M*N; i++) A1[i] = A2[i] = A[i];
+    householder_qr(A1, b1, M, N, sign);
+    householder_qr<M,N>(A2, b2);
+    double maxdiff = 0e0;
+    for (int i = 0; i < M*N; i++) {
+        maxdiff = std::max(maxdiff, std::abs(A1[i]-A2[i])/(1e0+std::abs(A1[i])));
+    }
+    for (int i = 0; i < N; i++) assert( std::abs(b1[i]-b2[i]) < 1e-12 );
+
+    Eigen::Matrix<double, M, N> Ae;
+    Eigen::Matrix<double, M, 1> ye;
+    for (int i = 0; i < M; i++) {
+        ye(i) = y[i];
+        for (int j = 0; j < N; j++) Ae(i,j) = A[j*M+i];
+    }
+    Eigen::Matrix<double, N, 1> xe = Ae.householderQr().solve(ye);
+    for (int i = 0; i < M*N; i++) A2[i] = A[i];
+    const int rc = ls_qrsolve<M,N>(A2, y);
+    assert( !rc );
+    for (int i = 0; i < N; i++) {
+        maxdiff = std::max(maxdiff, std::abs(y[i]-xe(i))/(1e0+std::abs(xe(i))));
+    }
+
+    // timing, over many factorizations
+    constexpr int reps = 100000;
+    double sum = 0e0;
+    auto start = Clock::now();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < M*N; i++) A1[i] = A[i] + r;
+        householder_qr(A1, b1, M, N, sign);
+        sum += A1[0];
+    }
+    auto t1 = duration_cast<microseconds>(Clock::now() - start).count();
+    start = Clock::now();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < M*N; i++) A2[i] = A[i] + r;
+        householder_qr<M,N>(A2, b2);
+        sum -= A2[0];
+    }
+    auto t2 = duration_cast<microseconds>(Clock::now() - start).count();
+
+    printf("\n%3d x %3d max rel. diff: %.3e  %d factorizations, householder_qr: %ld us, householder_qr<M,N>: %ld us (%.1e)",
+        M, N, maxdiff, reps, (long)t1, (long)t2, sum);
+    assert( maxdiff < 1e-10 );
+}
+
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+
+    run<4,3>(eng);
+    run<10,4>(eng);
+    run<20,4>(eng);
+    run<8,8>(eng);
+
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "qr_mixed.hpp"
+#include "eigen3/Eigen/Core"
+#include "eigen3/Eigen/QR"
+
+// Check ls_qrsolve_mixed on problems with a known LS solution (the residual
+// is made orthogonal to ran(A)): its error must be within a small factor of
+// the one of Eigen's (double precision) Householder QR, or of the condition
+// number times 1e-14. Well-conditioned problems (small and large residuals)
+// must be solved by refinement; ill-conditioned ones and matrices out of the
+// float range must fall back to the double precision factorization.
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+    std::uniform_real_distribution<double> distr(-125e0, 125e0);
+
+    // rows, cols, log10 of condition number, residual scale, element scale
+    struct { int m, n; double lcond, rscale, ascale; bool fallback; } cases[] = {
+        {10, 4, 0, 0e0, 1e0, false},
+        {500, 30, 1, 1e0, 1e0, false},
+        {2000, 60, 2, 1e3, 1e0, false},
+        {3000, 5, 3, 1e-2, 1e0, false},
+        {800, 40, 10, 1e0, 1e0, true},
+        {300, 10, 0, 1e0, 1e39, true},
+    };
+
+    for (auto& c : cases) {
+        const int m = c.m, n = c.n;
+        // A = U diag(s) V^T-like: random columns, scaled to spread the
+        // singular values, mixed by a random upper triangular matrix
+        Eigen::MatrixXd G(m, n), T = Eigen::MatrixXd::Identity(n, n);
+        for (int j = 0; j < n; j++)
+            for (int i = 0; i < m; i++) G(i, j) = distr(eng);
+        Eigen::HouseholderQR<Eigen::MatrixXd> gq(G);
+        Eigen::MatrixXd U = gq.householderQ() * Eigen::MatrixXd::Identity(m, n);
+        for (int j = 0; j < n; j++) {
+            T(j, j) = std::pow(10e0, -c.lcond*j/std::max(1, n-1));
+            for (int i = 0; i < j; i++) T(i, j) = 1e-2*distr(eng)/125e0*T(j, j);
+        }
+        Eigen::MatrixXd A = c.ascale*U*T;
+        Eigen::VectorXd xt(n), y(m);
+        for (int j = 0; j < n; j++) xt(j) = distr(eng);
+        for (int i = 0; i < m; i++) y(i) = c.rscale*distr(eng);
+        y = A*xt + (y - U*(U.transpose()*y));
+
+        Eigen::VectorXd xe = A.householderQr().solve(y);
+        std::vector<double> x(n);
+        int iters;
+        const int rc = ls_qrsolve_mixed(A.data(), y.data(), x.data(), m, n, &iters);
+        assert( !rc );
+        double err = 0e0, erre = 0e0, xn = 0e0;
+        for (int j = 0; j < n; j++) {
+            err  = std::max(err, std::abs(x[j]-xt(j)));
+            erre = std::max(erre, std::abs(xe(j)-xt(j)));
+            xn   = std::max(xn, std::abs(xt(j)));
+        }
+        err /= xn; erre /= xn;
+        printf("\n%5d x %3d cond=1e%-2.0f rscale=%.0e iters=%2d rel. error: %.3e (Eigen: %.3e)",
+            m, n, c.lcond, c.rscale, iters, err, erre);
+        if (c.fallback) {
+            assert( iters == -1 );
+        } else {
+            assert( iters > 0 );
+        }
+        assert( err <= 10e0*erre + 1e-14*std::pow(10e0, c.lcond) );
+    }
+
+    printf("\n");
+    return 0;
+}
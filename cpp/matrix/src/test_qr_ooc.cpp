@@ -0,0 +1,134 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <unistd.h>
+
+#include "qr.hpp"
+#include "qr_ooc.hpp"
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+
+// Write [A b] (row-major records, after a header of hdr bytes) to path.
+static void
+write_system(const char *path, const std::vector<double>& A,
+    const std::vector<double>& b, long m, int n, int hdr)
+{
+    FILE *fp = std::fopen(path, "wb");
+    assert( fp );
+    std::vector<char> header(hdr, 'h');
+    std::fwrite(header.data(), 1, hdr, fp);
+    std::vector<double> row(n+1);
+    for (long i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) row[j] = A[j*m+i];
+        row[n] = b[i];
+        std::fwrite(row.data(), sizeof(double), n+1, fp);
+    }
+    std::fclose(fp);
+}
+
+// Solve LS systems stored in a file, for several block sizes, and compare
+// the solution, R and the residual sum of squares with the in-memory QR.
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+    std::uniform_real_distribution<double> distr(-125e0, 125e0);
+
+    char path[] = "/tmp/test_qr_ooc_XXXXXX";
+    const int fd = mkstemp(path);
+    assert( fd >= 0 );
+    close(fd);
+
+    int shapes[][2] = {{1,1}, {10,4}, {500,37}, {3000,64}};
+    int blocks[]    = {0, 1, 7, 64, 5000};
+    const int hdr = 24;
+    int sign, rc;
+
+    for (auto& s : shapes) {
+        const int m = s[0], n = s[1];
+        std::vector<double> A(m*n), b(m);
+        for (auto& v : A) v = distr(eng);
+        for (auto& v : b) v = distr(eng);
+        write_system(path, A, b, m, n, hdr);
+
+        // in memory: x, R and the residual sum of squares
+        std::vector<double> a = A, y = b, beta(n);
+        householder_qr(a.data(), beta.data(), m, n, sign);
+        assert( !sign );
+        a = A;
+        rc = ls_qrsolve(a.data(), y.data(), m, n);
+        assert( !rc );
+        double rss0 = 0e0, rmax = 0e0, xmax = 0e0;
+        for (int i = 0; i < m; i++) {
+            double e = b[i];
+            for (int j = 0; j < n; j++) e -= A[j*m+i]*y[j];
+            rss0 += e*e;
+        }
+        for (int j = 0; j < n; j++) {
+            xmax = std::max(xmax, std::abs(y[j]));
+            for (int i = 0; i <= j; i++) rmax = std::max(rmax, std::abs(a[j*m+i]));
+        }
+
+        for (int k : blocks) {
+            std::vector<double> x(n), r(n*n);
+            double rss;
+            rc = ls_qrsolve_ooc(path, hdr, m, n, x.data(), r.data(), &rss, k);
+            assert( !rc );
+            double dx = 0e0, dr = 0e0;
+            for (int j = 0; j < n; j++) {
+                dx = std::max(dx, std::abs(x[j]-y[j]));
+                // R is unique up to the signs of its rows
+                for (int i = 0; i <= j; i++) {
+                    dr = std::max(dr, std::abs(std::abs(r[j*n+i])-std::abs(a[j*m+i])));
+                }
+                for (int i = j+1; i < n; i++) assert( r[j*n+i] == 0e0 );
+            }
+            const double drss = std::abs(rss-rss0)/std::max(rss0, 1e-300);
+            printf("\n%5d x %3d block %4d: rel. diff x: %.3e, R: %.3e, rss: %.3e",
+                m, n, k, dx/xmax, dr/rmax, m > n ? drss : 0e0);
+            assert( dx <= 1e-9*xmax && dr <= 1e-11*rmax );
+            if (m > n) assert( drss < 1e-8 );
+        }
+    }
+
+    // errors: short file, missing file, m < n
+    {
+        std::vector<double> x(4);
+        rc = ls_qrsolve_ooc(path, hdr, 4000, 64, x.data());
+        assert( rc == 1 );
+        rc = ls_qrsolve_ooc("/nonexistent/file", 0, 10, 4, x.data());
+        assert( rc == 1 );
+        rc = ls_qrsolve_ooc(path, hdr, 3, 4, x.data());
+        assert( rc == 1 );
+    }
+
+    // timing, against the in-memory solution
+    {
+        const long m = 200000;
+        const int n = 50;
+        std::vector<double> A(m*n), b(m), x(n);
+        for (auto& v : A) v = distr(eng);
+        for (auto& v : b) v = distr(eng);
+        write_system(path, A, b, m, n, 0);
+        auto t0 = Clock::now();
+        rc = ls_qrsolve_ooc(path, 0, m, n, x.data(), nullptr, nullptr, 4096);
+        assert( !rc );
+        auto t1 = Clock::now();
+        rc = ls_qrsolve(A.data(), b.data(), m, n);
+        assert( !rc );
+        auto t2 = Clock::now();
+        printf("\n%ld x %d (%.0f MB): out-of-core %ld ms, in memory %ld ms", m, n,
+            m*(n+1)*8e0/1e6, (long)duration_cast<milliseconds>(t1-t0).count(),
+            (long)duration_cast<milliseconds>(t2-t1).count());
+    }
+
+    std::remove(path);
+    printf("\n");
+    return 0;
+}
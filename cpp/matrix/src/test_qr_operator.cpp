@@ -0,0 +1,129 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "qr.hpp"
+#include "qr_operator.hpp"
+
+// Check qr_operator against the explicit thin Q (thin_q): Q1^T X and Q1 X
+// must match, Q^T Q X must give back X, the serial and multithreaded
+// results must agree, and the residual Q2 Q2^T y must be orthogonal to the
+// columns of A and add up with the projection Q1 Q1^T y to y.
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+    std::uniform_real_distribution<double> distr(-125e0, 125e0);
+
+    int shapes[][2] = {{7,3}, {50,50}, {300,41}, {2000,70}, {3001,33}};
+    int ks[]        = {1, 3, 17, 300};
+    int sign, rc;
+
+    for (auto& s : shapes) {
+        int m = s[0], n = s[1];
+        std::vector<double> A(m*n), a, b(n), Q(m*n);
+        for (auto& x : A) x = distr(eng);
+        a = A;
+        householder_qr(a.data(), b.data(), m, n, sign);
+        assert( !sign );
+        rc = thin_q(a.data(), b.data(), Q.data(), m, n);
+        assert( !rc );
+
+        qr_operator op1(a.data(), b.data(), m, n, 8, 1);
+        qr_operator op4(a.data(), b.data(), m, n, 32, 4);
+        assert( op1.rows() == m && op1.cols() == n );
+
+        for (int k : ks) {
+            const int ld = m + 3;
+            std::vector<double> X(ld*k), Y1(ld*k), Y4(ld*k), Z(n*k), Z4(n*k);
+            for (auto& x : X) x = distr(eng);
+            double xnorm = 0e0;
+            for (double x : X) xnorm = std::max(xnorm, std::abs(x));
+
+            // Q1^T X, against the explicit Q
+            rc = op1.apply_q1t(X.data(), ld, Z.data(), n, k);
+            assert( !rc );
+            rc = op4.apply_q1t(X.data(), ld, Z4.data(), n, k);
+            assert( !rc );
+            double d1t = 0e0;
+            for (int c = 0; c < k; c++) {
+                for (int j = 0; j < n; j++) {
+                    double sum = 0e0;
+                    for (int i = 0; i < m; i++) sum += Q[j*m+i]*X[c*ld+i];
+                    d1t = std::max(d1t, std::abs(sum-Z[c*n+j]));
+                    d1t = std::max(d1t, std::abs(sum-Z4[c*n+j]));
+                }
+            }
+
+            // Q1 Z, against the explicit Q
+            rc = op1.apply_q1(Z.data(), n, Y1.data(), ld, k);
+            assert( !rc );
+            rc = op4.apply_q1(Z.data(), n, Y4.data(), ld, k);
+            assert( !rc );
+            double d1 = 0e0;
+            for (int c = 0; c < k; c++) {
+                for (int i = 0; i < m; i++) {
+                    double sum = 0e0;
+                    for (int j = 0; j < n; j++) sum += Q[j*m+i]*Z[c*n+j];
+                    d1 = std::max(d1, std::abs(sum-Y1[c*ld+i]));
+                    d1 = std::max(d1, std::abs(sum-Y4[c*ld+i]));
+                }
+            }
+
+            // Q Q^T X = X, serial vs threaded
+            Y1 = X; Y4 = X;
+            rc = op1.apply_qt(Y1.data(), ld, k);
+            assert( !rc );
+            rc = op4.apply_qt(Y4.data(), ld, k);
+            assert( !rc );
+            double dst = 0e0;
+            for (int c = 0; c < k; c++)
+                for (int i = 0; i < m; i++)
+                    dst = std::max(dst, std::abs(Y1[c*ld+i]-Y4[c*ld+i]));
+            rc = op4.apply_q(Y4.data(), ld, k);
+            assert( !rc );
+            double dinv = 0e0;
+            for (int c = 0; c < k; c++)
+                for (int i = 0; i < m; i++)
+                    dinv = std::max(dinv, std::abs(Y4[c*ld+i]-X[c*ld+i]));
+
+            printf("\n%5d x %4d k=%3d |Q1^T X|: %.2e |Q1 Z|: %.2e serial/threaded: %.2e |QQ^T X - X|: %.2e",
+                m, n, k, d1t/xnorm, d1/xnorm, dst/xnorm, dinv/xnorm);
+            assert( d1t < 1e-12*xnorm*m && d1 < 1e-12*xnorm*m );
+            assert( dst < 1e-12*xnorm*m && dinv < 1e-12*xnorm*m );
+        }
+
+        // residual (Q2 Q2^T y) and projection (Q1 Q1^T y)
+        std::vector<double> y(m), r, p;
+        for (auto& x : y) x = distr(eng);
+        r = y;
+        rc = op4.apply_qt(r.data(), m, 1);
+        assert( !rc );
+        p = r;
+        for (int i = 0; i < n; i++) r[i] = 0e0;
+        for (int i = n; i < m; i++) p[i] = 0e0;
+        rc = op4.apply_q(r.data(), m, 1);
+        assert( !rc );
+        rc = op4.apply_q(p.data(), m, 1);
+        assert( !rc );
+        double maxdot = 0e0, maxsum = 0e0, ynorm = 0e0;
+        for (double yi : y) ynorm += yi*yi;
+        for (int j = 0; j < n; j++) {
+            double dot = 0e0, anorm = 0e0;
+            for (int i = 0; i < m; i++) {
+                dot   += A[j*m+i]*r[i];
+                anorm += A[j*m+i]*A[j*m+i];
+            }
+            maxdot = std::max(maxdot, std::abs(dot)/std::sqrt(anorm*ynorm));
+        }
+        for (int i = 0; i < m; i++)
+            maxsum = std::max(maxsum, std::abs(r[i]+p[i]-y[i]));
+        printf("\n%5d x %4d A^T*r: %.2e |r+p-y|: %.2e", m, n, maxdot, maxsum);
+        assert( maxdot < 1e-10 && maxsum < 1e-10*std::sqrt(ynorm) );
+    }
+
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "qr.hpp"
+#include "eigen3/Eigen/Core"
+#include "eigen3/Eigen/QR"
+
+// Check householder_qr_pivot/ls_qrsolve_pivot against Eigen's
+// CompleteOrthogonalDecomposition, for full rank and rank-deficient matrices
+// (zero and linearly dependent columns), tall and wide.
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+    std::uniform_real_distribution<double> distr(-125e0, 125e0);
+
+    // rows, cols, number of columns made dependent on others
+    int cases[][3] = {{10,4,0}, {10,4,1}, {300,20,5}, {50,50,3}, {8,20,0}, {20,40,10}};
+
+    for (auto& c : cases) {
+        int m = c[0], n = c[1], ndep = c[2], rank, sign, rc;
+        std::vector<double> A(m*n), y(m), A1, b1, x(n), xb(n), beta(std::min(m,n));
+        std::vector<int> perm(n);
+        for (auto& a : A) a = distr(eng);
+        for (auto& a : y) a = distr(eng);
+        // the last ndep columns: a zero one and combinations of the first two
+        for (int j = n-ndep; j < n; j++) {
+            for (int i = 0; i < m; i++) {
+                A[j*m+i] = (j == n-1) ? 0e0 : (j-n)*A[i] + 0.5e0*A[m+i];
+            }
+        }
+        const int true_rank = std::min(m, n-ndep);
+
+        Eigen::MatrixXd Ae(m, n);
+        Eigen::VectorXd ye(m);
+        for (int i = 0; i < m; i++) {
+            ye(i) = y[i];
+            for (int j = 0; j < n; j++) Ae(i,j) = A[j*m+i];
+        }
+        Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXd> cod(Ae);
+        Eigen::VectorXd xe = cod.solve(ye);
+
+        A1 = A;
+        householder_qr_pivot(A1.data(), beta.data(), perm.data(), m, n, rank, sign);
+        assert( !sign && rank == true_rank && (int)cod.rank() == rank );
+        // |R| diagonal is non-increasing
+        for (int j = 1; j < std::min(m,n); j++) {
+            assert( std::abs(A1[j*m+j]) <= std::abs(A1[(j-1)*m+j-1])*(1e0+1e-12) );
+        }
+
+        A1 = A; b1 = y;
+        rc = ls_qrsolve_pivot(A1.data(), b1.data(), x.data(), m, n, rank);
+        assert( !rc );
+        double maxdiff = 0e0;
+        for (int j = 0; j < n; j++) {
+            maxdiff = std::max(maxdiff, std::abs(x[j]-xe(j))/(1e0+std::abs(xe(j))));
+        }
+
+        // the basic solution: same residual, n-rank zero components
+        A1 = A; b1 = y;
+        rc = ls_qrsolve_pivot(A1.data(), b1.data(), xb.data(), m, n, rank, false);
+        assert( !rc );
+        int nzero = 0;
+        for (int j = 0; j < n; j++) nzero += (xb[j] == 0e0);
+        assert( nzero >= n-rank );
+        double r1 = 0e0, r2 = 0e0;
+        for (int i = 0; i < m; i++) {
+            double v1 = y[i], v2 = y[i];
+            for (int j = 0; j < n; j++) {
+                v1 -= A[j*m+i]*x[j];
+                v2 -= A[j*m+i]*xb[j];
+            }
+            r1 += v1*v1;
+            r2 += v2*v2;
+        }
+        printf("\n%5d x %5d rank=%3d max rel. diff vs Eigen: %.3e residuals: %.6e %.6e",
+            m, n, rank, maxdiff, std::sqrt(r1), std::sqrt(r2));
+        assert( maxdiff < 1e-8 );
+        assert( std::abs(std::sqrt(r1)-std::sqrt(r2)) <= 1e-8*(1e0+std::sqrt(r1)) );
+    }
+
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+#include "qr.hpp"
+#include "qr_robust.hpp"
+
+// Count heap allocations, to check that robust_ls::solve does not allocate.
+static long num_allocs = 0;
+
+void*
+operator new(std::size_t size)
+{
+    ++num_allocs;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept
+{ std::free(p); }
+
+void
+operator delete(void* p, std::size_t) noexcept
+{ std::free(p); }
+
+static double
+max_error(const std::vector<double>& x, const std::vector<double>& xt)
+{
+    double e = 0e0;
+    for (std::size_t i = 0; i < x.size(); i++) e = std::max(e, std::abs(x[i]-xt[i]));
+    return e;
+}
+
+// Fit a LS problem with 10% gross errors: the robust solutions (Huber,
+// Tukey, Danish) must be close to the true parameters, while the ordinary
+// LS solution is not; the outliers must be down-weighted, repeated solves
+// must give the same bits and must not allocate.
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+    std::uniform_real_distribution<double> distr(-1e0, 1e0);
+    std::normal_distribution<double> noise(0e0, 1e0);
+
+    const int m = 400, n = 6;
+    int rc;
+    std::vector<double> A(m*n), b(m), xt(n), x(n), x2(n);
+    std::vector<bool> outlier(m, false);
+    for (auto& v : A) v = distr(eng);
+    for (auto& v : xt) v = 10e0*distr(eng);
+    for (int i = 0; i < m; i++) {
+        b[i] = noise(eng);
+        for (int j = 0; j < n; j++) b[i] += A[j*m+i]*xt[j];
+        if (i % 10 == 3) {
+            outlier[i] = true;
+            b[i] += (distr(eng) > 0e0 ? 1e0 : -1e0) * (50e0 + 150e0*std::abs(distr(eng)));
+        }
+    }
+
+    // ordinary LS
+    std::vector<double> a = A, y = b;
+    rc = ls_qrsolve(a.data(), y.data(), m, n);
+    assert( !rc );
+    const double eols = max_error(std::vector<double>(y.begin(), y.begin()+n), xt);
+
+    robust_ls rls(A.data(), m, n);
+    struct { const char *name; robust_weight_fn fn; double c, sigma; } cases[] = {
+        {"huber ", huber_weight, huber_c, 0e0},
+        {"huber ", huber_weight, huber_c, 1e0},
+        {"tukey ", tukey_weight, tukey_c, 1e0},
+        {"danish", danish_weight, danish_c, 1e0},
+        {"danish", danish_weight, danish_c, 0e0}};
+    for (auto& c : cases) {
+        rls.set_weight(c.fn, c.c);
+        rc = rls.solve(b.data(), x.data(), c.sigma);
+        assert( !rc );
+        const double e = max_error(x, xt);
+        double wout = 0e0, win = 1e0;
+        for (int i = 0; i < m; i++) {
+            if (outlier[i]) wout = std::max(wout, rls.weights()[i]);
+            else            win  = std::min(win, rls.weights()[i]);
+        }
+        printf("\n%s sigma=%.1f iters=%2d (sigma: %.3f) max error: %.3e (LS: %.3e), max outlier weight: %.2e, min weight: %.2e",
+            c.name, c.sigma, rls.iterations(), rls.sigma(), e, eols, wout, win);
+        assert( rls.iterations() > 0 );
+        assert( e < 0.5e0 && e < 0.2e0*eols );
+        if (c.fn != huber_weight) assert( wout < 1e-3 );
+        else                      assert( wout < 0.1e0 );
+
+        // residuals are b - Ax, for the pristine A
+        for (int i = 0; i < m; i++) {
+            double r = b[i];
+            for (int j = 0; j < n; j++) r -= A[j*m+i]*x[j];
+            assert( std::abs(r-rls.residuals()[i]) < 1e-10*(1e0+std::abs(b[i])) );
+        }
+
+        // again: same bits, no allocation
+        const long na = num_allocs;
+        rc = rls.solve(b.data(), x2.data(), c.sigma);
+        assert( !rc );
+        assert( num_allocs == na );
+        assert( x == x2 );
+    }
+
+    // no outliers: Huber with the given sigma stays (close to) the LS solution
+    std::vector<double> bc(m);
+    for (int i = 0; i < m; i++) {
+        bc[i] = 1e-3*noise(eng);
+        for (int j = 0; j < n; j++) bc[i] += A[j*m+i]*xt[j];
+    }
+    a = A; y = bc;
+    rc = ls_qrsolve(a.data(), y.data(), m, n);
+    assert( !rc );
+    rls.set_weight(huber_weight, huber_c);
+    rc = rls.solve(bc.data(), x.data(), 1e0);
+    assert( !rc );
+    for (int j = 0; j < n; j++) assert( std::abs(x[j]-y[j]) < 1e-10*(1e0+std::abs(y[j])) );
+
+    // not converged in max_iter, and too few observations
+    rls.set_weight(huber_weight, huber_c);
+    rc = rls.solve(b.data(), x.data(), 0e0, 1e-300, 2);
+    assert( rc == 2 );
+    robust_ls bad(A.data(), n-1, n);
+    rc = bad.solve(b.data(), x.data());
+    assert( rc == 1 );
+
+    printf("\n");
+    return 0;
+}
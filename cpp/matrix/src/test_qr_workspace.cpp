@@ -0,0 +1,150 @@
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+#include "qr.hpp"
+
+// Count heap allocations, to check that the qr_workspace overloads do not
+// allocate once the workspace is large enough.
+static long num_allocs = 0;
+
+void*
+operator new(std::size_t size)
+{
+    ++num_allocs;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept
+{ std::free(p); }
+
+void
+operator delete(void* p, std::size_t) noexcept
+{ std::free(p); }
+
+// The qr_workspace overloads must give the same results as the allocating
+// versions, and allocate nothing in steady state.
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+    std::uniform_real_distribution<double> distr(-125e0, 125e0);
+
+    const int m = 500, n = 40, k = 8;
+    std::vector<double> A(m*n), y(m), A1(m*n), A2(m*n), b1(n), b2(n), y1(m),
+                        y2(m), q1(m*n), q2(m*n), x1(n), x2(n), Y(m*k), Y1(m*k),
+                        Y2(m*k);
+    int p1[n], p2[n];
+    for (auto& x : A) x = distr(eng);
+    for (auto& x : y) x = distr(eng);
+    for (auto& x : Y) x = distr(eng);
+    int sign, rank1, rank2, rc;
+
+    qr_workspace ws;
+    assert( ws.size() == 0 );
+    for (int rep = 0; rep < 3; rep++) {
+        A1 = A; A2 = A;
+        householder_qr(A1.data(), b1.data(), m, n, sign);
+        assert( !sign );
+        long before = num_allocs;
+        rc = householder_qr(A2.data(), b2.data(), m, n, ws);
+        assert( !rc );
+        rc = thin_q(A2.data(), b2.data(), q2.data(), m, n, ws);
+        assert( !rc );
+        // smaller problems reuse the same workspace
+        std::copy(A.begin(), A.end(), A2.begin());
+        rc = householder_qr_blocked(A2.data(), b2.data(), m/2, n/2, ws);
+        assert( !rc );
+        std::copy(A.begin(), A.end(), A2.begin());
+        rc = householder_qr_blocked(A2.data(), b2.data(), m, n, ws);
+        assert( !rc );
+        y2 = y;
+        std::copy(A.begin(), A.end(), A2.begin());
+        rc = ls_qrsolve(A2.data(), y2.data(), m, n, ws);
+        assert( !rc );
+        std::copy(A.begin(), A.end(), A2.begin());
+        rc = householder_qr_pivot(A2.data(), b2.data(), p2, m, n, rank2, ws);
+        assert( !rc );
+        y2 = y;
+        std::copy(A.begin(), A.end(), A2.begin());
+        rc = ls_qrsolve_pivot(A2.data(), y2.data(), x2.data(), m, n, rank2, ws);
+        assert( !rc );
+        std::copy(A.begin(), A.end(), A2.begin());
+        rc = householder_qr_blocked(A2.data(), b2.data(), m, n, ws);
+        assert( !rc );
+        std::copy(Y.begin(), Y.end(), Y2.begin());
+        rc = qr_apply_qt(A2.data(), b2.data(), m, n, Y2.data(), m, k, ws);
+        assert( !rc );
+        std::copy(Y.begin(), Y.end(), Y2.begin());
+        rc = ls_qrsolve_multi(A2.data(), b2.data(), m, n, Y2.data(), m, k, ws);
+        assert( !rc );
+        long allocs = num_allocs - before;
+        printf("\nrep %d: workspace size %d (qr_worksize: %d), allocations: %ld",
+            rep, ws.size(), qr_worksize(m, n, 32, k), allocs);
+        assert( ws.size() <= qr_worksize(m, n, 32, k) );
+        // only the first use of the workspace may allocate
+        assert( rep == 0 || allocs == 0 );
+
+        // same results as the allocating versions
+        A2 = A;
+        rc = householder_qr(A2.data(), b2.data(), m, n, ws);
+        assert( !rc );
+        for (int i = 0; i < m*n; i++) assert( A1[i] == A2[i] );
+        rc = thin_q(A1.data(), b1.data(), q1.data(), m, n);
+        assert( !rc );
+        rc = thin_q(A2.data(), b2.data(), q2.data(), m, n, ws);
+        assert( !rc );
+        for (int i = 0; i < m*n; i++) assert( q1[i] == q2[i] );
+        A1 = A; A2 = A; y1 = y; y2 = y;
+        rc = ls_qrsolve(A1.data(), y1.data(), m, n);
+        assert( !rc );
+        rc = ls_qrsolve(A2.data(), y2.data(), m, n, ws);
+        assert( !rc );
+        for (int i = 0; i < n; i++) assert( y1[i] == y2[i] );
+
+        // pivoted QR and LS
+        A1 = A; A2 = A;
+        householder_qr_pivot(A1.data(), b1.data(), p1, m, n, rank1, sign);
+        assert( !sign );
+        rc = householder_qr_pivot(A2.data(), b2.data(), p2, m, n, rank2, ws);
+        assert( !rc );
+        assert( rank1 == rank2 && std::equal(p1, p1+n, p2) && A1 == A2 && b1 == b2 );
+        A1 = A; A2 = A; y1 = y; y2 = y;
+        rc = ls_qrsolve_pivot(A1.data(), y1.data(), x1.data(), m, n, rank1);
+        assert( !rc );
+        rc = ls_qrsolve_pivot(A2.data(), y2.data(), x2.data(), m, n, rank2, ws);
+        assert( !rc );
+        assert( rank1 == rank2 && x1 == x2 );
+
+        // Q^T C and multiple right-hand sides
+        A1 = A;
+        rc = householder_qr_blocked(A1.data(), b1.data(), m, n, ws);
+        assert( !rc );
+        Y1 = Y; Y2 = Y;
+        rc = qr_apply_qt(A1.data(), b1.data(), m, n, Y1.data(), m, k);
+        assert( !rc );
+        rc = qr_apply_qt(A1.data(), b1.data(), m, n, Y2.data(), m, k, ws);
+        assert( !rc );
+        assert( Y1 == Y2 );
+        Y1 = Y; Y2 = Y;
+        rc = ls_qrsolve_multi(A1.data(), b1.data(), m, n, Y1.data(), m, k);
+        assert( !rc );
+        rc = ls_qrsolve_multi(A1.data(), b1.data(), m, n, Y2.data(), m, k, ws);
+        assert( !rc );
+        assert( Y1 == Y2 );
+    }
+
+    // errors are reported
+    rc = ls_qrsolve(A2.data(), y2.data(), n-1, n, ws);
+    assert( rc );
+
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,242 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+#include "srif.hpp"
+#include "eigen3/Eigen/Core"
+#include "eigen3/Eigen/LU"
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+// Count heap allocations, to check that the SRIF updates do not allocate.
+static long num_allocs = 0;
+
+void*
+operator new(std::size_t size)
+{
+    ++num_allocs;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept
+{ std::free(p); }
+
+void
+operator delete(void* p, std::size_t) noexcept
+{ std::free(p); }
+
+// max relative difference between the SRIF estimate/covariance and x/P
+static void
+compare(const srif& f, const Eigen::VectorXd& x, const Eigen::MatrixXd& P,
+    double& dx, double& dp)
+{
+    const int n = f.num_states();
+    std::vector<double> xs(n), cov(n*n);
+    const int rc1 = f.estimate(xs.data()), rc2 = f.covariance(cov.data(), n);
+    assert( !rc1 && !rc2 );
+    dx = dp = 0e0;
+    const double xmax = x.cwiseAbs().maxCoeff(), pmax = P.cwiseAbs().maxCoeff();
+    for (int i = 0; i < n; i++) {
+        dx = std::max(dx, std::abs(xs[i]-x(i))/xmax);
+        for (int j = 0; j < n; j++) dp = std::max(dp, std::abs(cov[j*n+i]-P(i, j))/pmax);
+    }
+}
+
+// Run the SRIF along a (covariance form) Kalman filter on a random linear
+// system with process noise, then eliminate and insert parameters; the
+// estimates and covariance matrices must agree.
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+    std::uniform_real_distribution<double> distr(-1e0, 1e0);
+
+    const int n = 8, p = 3, k = 5;
+    int rc;
+    srif f(n+2, p, 2);
+    f.reset(n);
+
+    Eigen::VectorXd x(n), sx(n);
+    Eigen::MatrixXd P = Eigen::MatrixXd::Zero(n, n);
+    for (int i = 0; i < n; i++) {
+        x(i)  = 10e0*distr(eng);
+        sx(i) = 1e0 + std::abs(distr(eng));
+        P(i, i) = sx(i)*sx(i);
+    }
+    rc = f.set_prior(x.data(), sx.data());
+    assert( !rc );
+
+    Eigen::MatrixXd Phi = Eigen::MatrixXd::Identity(n, n), G(n, p), H(k, n),
+                    Rw = Eigen::MatrixXd::Zero(p, p), Q = Eigen::MatrixXd::Zero(p, p);
+    for (int j = 0; j < n; j++) for (int i = 0; i < n; i++) Phi(i, j) += 0.1e0*distr(eng);
+    for (int j = 0; j < p; j++) for (int i = 0; i < n; i++) G(i, j) = distr(eng);
+    for (int i = 0; i < p; i++) {
+        const double sw = 0.1e0 + 0.5e0*std::abs(distr(eng));
+        Rw(i, i) = 1e0/sw;
+        Q(i, i)  = sw*sw;
+    }
+    Eigen::MatrixXd Phi_inv = Phi.inverse();
+
+    double dx, dp;
+    for (int step = 0; step < 20; step++) {
+        // measurements, with standard deviations s
+        Eigen::VectorXd y(k), s(k);
+        for (int j = 0; j < n; j++) for (int i = 0; i < k; i++) H(i, j) = distr(eng);
+        for (int i = 0; i < k; i++) {
+            s(i) = 0.5e0 + std::abs(distr(eng));
+            y(i) = 10e0*distr(eng);
+        }
+        const long na = num_allocs;
+        rc = f.measurement_update(H.data(), k, y.data(), k, s.data());
+        assert( !rc );
+        rc = f.time_update(Phi_inv.data(), n, G.data(), n, Rw.data(), p, p);
+        assert( !rc );
+        assert( num_allocs == na );
+
+        // information form of the measurement update, then propagation
+        Eigen::MatrixXd Ri = s.cwiseInverse().cwiseAbs2().asDiagonal();
+        Eigen::MatrixXd Pi = P.inverse() + H.transpose()*Ri*H;
+        Eigen::VectorXd xi = P.inverse()*x + H.transpose()*Ri*y;
+        P = Pi.inverse();
+        x = P*xi;
+        x = Phi*x;
+        P = Phi*P*Phi.transpose() + G*Q*G.transpose();
+
+        compare(f, x, P, dx, dp);
+        assert( dx < 1e-10 && dp < 1e-10 );
+    }
+    printf("\nafter 20 steps: max rel. diff x: %.3e, P: %.3e", dx, dp);
+
+    // process noise on every state (G = I), and a deterministic step
+    {
+        Eigen::MatrixXd Rwn = Eigen::MatrixXd::Identity(n, n)*4e0;
+        srif g(n, n);
+        g.reset(n);
+        rc = g.set_prior(x.data(), sx.data());
+        assert( !rc );
+        rc = g.time_update(Phi_inv.data(), n, nullptr, 0, Rwn.data(), n, n);
+        assert( !rc );
+        rc = g.time_update(Phi_inv.data(), n, nullptr, 0, nullptr, 0, 0);
+        assert( !rc );
+        Eigen::MatrixXd P0 = sx.cwiseAbs2().asDiagonal();
+        P0 = Phi*P0*Phi.transpose() + Eigen::MatrixXd::Identity(n, n)/16e0;
+        P0 = Phi*P0*Phi.transpose();
+        Eigen::VectorXd x0 = Phi*Phi*x;
+        compare(g, x0, P0, dx, dp);
+        printf("\nG = I, then p = 0: max rel. diff x: %.3e, P: %.3e", dx, dp);
+        assert( dx < 1e-10 && dp < 1e-10 );
+    }
+
+    // eliminate parameters 5 and 1: the others keep their marginal
+    // estimates and covariances
+    {
+        int idx[] = {5, 1};
+        rc = f.eliminate(idx, 2);
+        assert( !rc );
+        assert( f.num_states() == n-2 );
+        std::vector<int> keep = {0, 2, 3, 4, 6, 7};
+        Eigen::VectorXd xe(n-2);
+        Eigen::MatrixXd Pe(n-2, n-2);
+        for (int i = 0; i < n-2; i++) {
+            xe(i) = x(keep[i]);
+            for (int j = 0; j < n-2; j++) Pe(i, j) = P(keep[i], keep[j]);
+        }
+        compare(f, xe, Pe, dx, dp);
+        printf("\neliminate: max rel. diff x: %.3e, P: %.3e", dx, dp);
+        assert( dx < 1e-10 && dp < 1e-10 );
+        rc = f.eliminate(idx, 1);
+        assert( rc == 0 ); // 5 is a valid index of n-2 states
+        int dup[] = {0, 0};
+        rc = f.eliminate(dup, 2);
+        assert( rc == 1 );
+
+        // insert two parameters at position 2, with a-priori information
+        const int nn = f.num_states();
+        std::vector<double> xo(nn), covo(nn*nn);
+        rc = f.estimate(xo.data());
+        assert( !rc );
+        rc = f.covariance(covo.data(), nn);
+        assert( !rc );
+        double r0[] = {2e0, 0e0, 1e0, 4e0}, z0[] = {3e0, 8e0};
+        rc = f.insert(2, 2, r0, 2, z0);
+        assert( !rc );
+        assert( f.num_states() == nn+2 );
+        std::vector<double> xn(nn+2), covn((nn+2)*(nn+2));
+        rc = f.estimate(xn.data());
+        assert( !rc );
+        rc = f.covariance(covn.data(), nn+2);
+        assert( !rc );
+        auto map = [](int i) { return i < 2 ? i : i+2; };
+        for (int i = 0; i < nn; i++) {
+            assert( std::abs(xn[map(i)]-xo[i]) < 1e-12*(1e0+std::abs(xo[i])) );
+            for (int j = 0; j < nn; j++) {
+                assert( std::abs(covn[map(j)*(nn+2)+map(i)]-covo[j*nn+i]) < 1e-12*(1e0+std::abs(covo[j*nn+i])) );
+            }
+        }
+        // R0 x = z0: x = (0.5, 2)
+        assert( std::abs(xn[2]-0.5e0) < 1e-14 && std::abs(xn[3]-2e0) < 1e-14 );
+        rc = f.insert(0, f.ld()-f.num_states()+1);
+        assert( rc == 1 ); // exceeds max_states
+
+        // a parameter without information: no estimate, until observed
+        rc = f.eliminate(idx, 1);
+        assert( !rc );
+        rc = f.insert(0, 1);
+        assert( !rc );
+        rc = f.estimate(xn.data());
+        assert( rc == 1 );
+        std::vector<double> h(f.num_states(), 0e0);
+        h[0] = 1e0;
+        double y0 = 42e0;
+        rc = f.measurement_update(h.data(), 1, &y0, 1);
+        assert( !rc );
+        rc = f.estimate(xn.data());
+        assert( !rc );
+        assert( std::abs(xn[0]-42e0) < 1e-12 );
+    }
+
+    // timing, for a few hundred states
+    {
+        const int ns = 300, ps = 100, ks = 50;
+        srif big(ns, ps, ks);
+        big.reset(ns);
+        std::vector<double> x0(ns), s0(ns, 10e0), phi(ns*ns, 0e0), gg(ns*ps),
+                            rw(ps*ps, 0e0), hh(ks*ns), yy(ks);
+        for (auto& v : x0) v = distr(eng);
+        for (int i = 0; i < ns; i++) phi[i*ns+i] = 1e0;
+        for (int i = 0; i < ns-1; i++) phi[(i+1)*ns+i] = -0.01e0;
+        for (auto& v : gg) v = distr(eng);
+        for (int i = 0; i < ps; i++) rw[i*ps+i] = 10e0;
+        for (auto& v : hh) v = distr(eng);
+        for (auto& v : yy) v = distr(eng);
+        rc = big.set_prior(x0.data(), s0.data());
+        assert( !rc );
+        const int steps = 10;
+        auto t0 = Clock::now();
+        for (int s = 0; s < steps; s++) {
+            rc = big.measurement_update(hh.data(), ks, yy.data(), ks);
+            assert( !rc );
+        }
+        auto t1 = Clock::now();
+        for (int s = 0; s < steps; s++) {
+            rc = big.time_update(phi.data(), ns, gg.data(), ns, rw.data(), ps, ps);
+            assert( !rc );
+        }
+        auto t2 = Clock::now();
+        printf("\nn=%d: measurement update (%d obs): %.3f ms, time update (p=%d): %.3f ms",
+            ns, ks, duration_cast<microseconds>(t1-t0).count()/1e3/steps,
+            ps, duration_cast<microseconds>(t2-t1).count()/1e3/steps);
+    }
+
+    printf("\n");
+    return 0;
+}
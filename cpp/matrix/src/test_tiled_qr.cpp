@@ -0,0 +1,92 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "qr.hpp"
+#include "tiled_qr.hpp"
+
+// Check that tiled_qr gives the same R (up to the signs of its rows) as
+// householder_qr, and that the tiled_ls_qrsolve residuals are orthogonal to
+// the columns of A, for a number of shapes, tile sizes and thread counts.
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+    std::uniform_real_distribution<double> distr(-125e0, 125e0);
+
+    int shapes[][2] = {{10,4}, {50,50}, {300,77}, {1000,20}, {129,128}, {517,260}};
+    int tiles[]     = {1, 7, 32, 128};
+    int threads[]   = {1, 2, 4};
+    int sign;
+
+    for (auto& s : shapes) {
+        int m = s[0], n = s[1];
+        std::vector<double> A(m*n), y(m), A1, A2, b1(n), t, x2, v;
+        for (auto& x : A) x = distr(eng);
+        for (auto& x : y) x = distr(eng);
+        A1 = A;
+        householder_qr(A1.data(), b1.data(), m, n, sign);
+        assert( !sign );
+        for (int nb : tiles) {
+            // small tiles only on small matrices (task graphs of 1M tasks
+            // and more are slow to build and rejected by tiled_qr)
+            if (nb < 32 && m*n > 20000) {
+                t.assign(tiled_qr_tsize(m, n, nb), 0e0);
+                if (tiled_qr_num_tasks(m, n, nb) > tiled_qr_max_tasks) {
+                    A2 = A;
+                    int rc = tiled_qr(A2.data(), t.data(), m, n, nb, 1);
+                    assert( rc == 1 );
+                    // the solver picks a larger tile size instead
+                    A2 = A;
+                    x2 = y;
+                    rc = tiled_ls_qrsolve(A2.data(), x2.data(), m, n, nb, 4);
+                    assert( !rc );
+                    printf("\n%5d x %5d nb=%3d rejected (%ld tasks)", m, n, nb,
+                        tiled_qr_num_tasks(m, n, nb));
+                }
+                continue;
+            }
+            for (int nt : threads) {
+                A2 = A;
+                t.assign(tiled_qr_tsize(m, n, nb), 0e0);
+                int rc = tiled_qr(A2.data(), t.data(), m, n, nb, nt);
+                assert( !rc );
+                double maxdiff = 0e0;
+                for (int i = 0; i < n; i++) {
+                    // rows of R are unique up to their sign
+                    double sgn = (A1[i*m+i]*A2[i*m+i] < 0e0) ? -1e0 : 1e0;
+                    for (int j = i; j < n; j++) {
+                        maxdiff = std::max(maxdiff,
+                            std::abs(A1[j*m+i]-sgn*A2[j*m+i])/(1e0+std::abs(A1[j*m+i])));
+                    }
+                }
+                A2 = A;
+                x2 = y;
+                rc = tiled_ls_qrsolve(A2.data(), x2.data(), m, n, nb, nt);
+                assert( !rc );
+                // v = y - A*x; check A^T*v ~ 0 (relative to |A^T||y|)
+                v = y;
+                for (int j = 0; j < n; j++)
+                    for (int i = 0; i < m; i++) v[i] -= A[j*m+i]*x2[j];
+                double maxdx = 0e0, ynorm = 0e0;
+                for (double yi : y) ynorm += yi*yi;
+                for (int j = 0; j < n; j++) {
+                    double dot = 0e0, anorm = 0e0;
+                    for (int i = 0; i < m; i++) {
+                        dot   += A[j*m+i]*v[i];
+                        anorm += A[j*m+i]*A[j*m+i];
+                    }
+                    maxdx = std::max(maxdx, std::abs(dot)/std::sqrt(anorm*ynorm));
+                }
+                printf("\n%5d x %5d nb=%3d threads=%d max rel. diff R: %.3e A^T*v: %.3e",
+                    m, n, nb, nt, maxdiff, maxdx);
+                assert( maxdiff < 1e-9 && maxdx < 1e-10 );
+            }
+        }
+    }
+
+    printf("\n");
+    return 0;
+}
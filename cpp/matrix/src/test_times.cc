@@ -3,15 +3,22 @@
 
 #ifdef DEBUG
 #include <iostream>
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <iostream>
 #include <random>
+#include <thread>
+#include <vector>
 #endif
 
 #include "qr.hpp"
+#include "tiled_qr.hpp"
+#include "tsqr.hpp"
+#include "lu.hpp"
 #include "eigen3/Eigen/Core"
 #include "eigen3/Eigen/QR"
+#include "eigen3/Eigen/LU"
 
 using Clock = std::chrono::steady_clock;
 using std::chrono::time_point;
@@ -25,20 +32,22 @@ int main()
     std::mt19937 eng(rd()); // seed the generator
     std::uniform_real_distribution<double> distr(-125e0, 125e0); // define the range
     std::vector<int> row_vec = {10, 100, 1000, 2000, 3000, 5000, 10000};
-    std::vector<int> col_vec = {5, 10, 20};
+    std::vector<int> col_vec = {5, 10, 20, 100, 500};
     time_point<Clock> start,
                       end;
     milliseconds      diff;
     
-    double *A, *b, *c;
+    double *A, *B, *b, *c;
     int    sign;
+    tsqr   ts;
     for (int cols : col_vec) {
         for (int rows : row_vec) {
             if (rows > cols) {
                 A = new double[cols*rows];
+                B = new double[cols*rows];
                 // b = new double[rows];
                 c = new double[cols];
-                for (int i = 0; i < rows*cols; i++) A[i] = distr(eng);
+                for (int i = 0; i < rows*cols; i++) B[i] = A[i] = distr(eng);
                 // for (int i = 0; i < rows; i++) b[i] = distr(eng);
 
                 start = Clock::now();
@@ -48,7 +57,21 @@ int main()
                 printf("\n%5d x %5d", rows, cols);
                 std::cout << " mine: " << diff.count();
 
+                start = Clock::now();
+                householder_qr_blocked(B, c, rows, cols, sign);
+                end = Clock::now();
+                diff = duration_cast<milliseconds>(end - start);
+                std::cout << " blocked: " << diff.count();
+
+                for (int i = 0; i < rows*cols; i++) B[i] = distr(eng);
+                start = Clock::now();
+                ts.factor(B, rows, cols);
+                end = Clock::now();
+                diff = duration_cast<milliseconds>(end - start);
+                std::cout << " tsqr: " << diff.count();
+
                 delete[] A;
+                delete[] B;
                 delete[] c;
 
                 Eigen::MatrixXd Agn = Eigen::MatrixXd(rows, cols);
@@ -64,6 +87,67 @@ int main()
         }
     }
 
+    // Thread scaling of tiled_qr, for square and tall matrices.
+    int shapes[][2] = {{1000,1000}, {2000,2000}, {10000,500}, {20000,1000}};
+    int max_threads = std::max(1u, std::thread::hardware_concurrency());
+    printf("\ntiled_qr (nb=128), time [ms] / speedup w.r.t. 1 thread:");
+    for (auto& s : shapes) {
+        int rows = s[0], cols = s[1];
+        std::vector<double> A0(rows*cols), A1, T(tiled_qr_tsize(rows, cols, 128));
+        for (auto& x : A0) x = distr(eng);
+        printf("\n%5d x %5d", rows, cols);
+        long t1 = 0;
+        for (int nt = 1; nt <= max_threads; nt *= 2) {
+            A1 = A0;
+            start = Clock::now();
+            tiled_qr(A1.data(), T.data(), rows, cols, 128, nt);
+            end = Clock::now();
+            diff = duration_cast<milliseconds>(end - start);
+            if (nt == 1) t1 = diff.count();
+            printf(" threads=%d: %ld (%.2f)", nt, (long)diff.count(),
+                diff.count() ? (double)t1/diff.count() : 0e0);
+        }
+    }
+
+    // LU factorization (partial pivoting) of square matrices, against
+    // Eigen's PartialPivLU; unblocked, blocked (nb=64) and blocked on all
+    // threads.
+    printf("\nlu_factor, time [ms]:");
+    for (int n : {100, 500, 1000, 2000, 3000}) {
+        std::vector<double> A0(n*n), A1;
+        std::vector<int> ipiv(n);
+        for (auto& x : A0) x = distr(eng);
+        printf("\n%5d x %5d", n, n);
+
+        A1 = A0;
+        start = Clock::now();
+        lu_factor(A1.data(), n, ipiv.data(), 0);
+        end = Clock::now();
+        diff = duration_cast<milliseconds>(end - start);
+        std::cout << " unblocked: " << diff.count();
+
+        A1 = A0;
+        start = Clock::now();
+        lu_factor(A1.data(), n, ipiv.data(), 64, 1);
+        end = Clock::now();
+        diff = duration_cast<milliseconds>(end - start);
+        std::cout << " blocked: " << diff.count();
+
+        A1 = A0;
+        start = Clock::now();
+        lu_factor(A1.data(), n, ipiv.data(), 64, max_threads);
+        end = Clock::now();
+        diff = duration_cast<milliseconds>(end - start);
+        std::cout << " threads=" << max_threads << ": " << diff.count();
+
+        Eigen::MatrixXd Agn = Eigen::Map<Eigen::MatrixXd>(A0.data(), n, n);
+        start = Clock::now();
+        Eigen::PartialPivLU<Eigen::MatrixXd> lu(Agn);
+        end = Clock::now();
+        diff = duration_cast<milliseconds>(end - start);
+        std::cout << " Eigen: " << diff.count();
+    }
+
     std::cout << "\n";
     return 0;
 }
@@ -0,0 +1,116 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "qr.hpp"
+#include "eigen3/Eigen/Core"
+#include "eigen3/Eigen/QR"
+
+// Check triangular_solve (upper/lower, unit/non-unit diagonal, one and many
+// right-hand sides, one and many threads), back_substitution and ls_qrsolve
+// against Eigen.
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+    std::uniform_real_distribution<double> distr(-125e0, 125e0);
+
+    int sizes[]   = {1, 2, 7, 64, 65, 200, 517};
+    int rhs[]     = {1, 3, 4, 63, 130, 300};
+    int threads[] = {1, 3};
+    int rc;
+
+    for (int n : sizes) {
+        const int ld = n + 5;
+        // diagonally dominant triangles, well-conditioned
+        Eigen::MatrixXd T(n, n);
+        for (int j = 0; j < n; j++)
+            for (int i = 0; i < n; i++) T(i, j) = distr(eng)/n;
+        for (int i = 0; i < n; i++) T(i, i) = (T(i, i) < 0e0 ? -1e0 : 1e0)*(50e0 + std::abs(distr(eng)));
+        std::vector<double> t(ld*n);
+        for (int j = 0; j < n; j++)
+            for (int i = 0; i < n; i++) t[j*ld+i] = T(i, j);
+
+        for (int k : rhs) {
+            Eigen::MatrixXd B(n, k);
+            for (int j = 0; j < k; j++)
+                for (int i = 0; i < n; i++) B(i, j) = distr(eng);
+            for (int upper = 0; upper < 2; upper++) {
+                for (int unit = 0; unit < 2; unit++) {
+                    Eigen::MatrixXd X;
+                    if (upper && unit) {
+                        X = T.triangularView<Eigen::UnitUpper>().solve(B);
+                    } else if (upper) {
+                        X = T.triangularView<Eigen::Upper>().solve(B);
+                    } else if (unit) {
+                        X = T.triangularView<Eigen::UnitLower>().solve(B);
+                    } else {
+                        X = T.triangularView<Eigen::Lower>().solve(B);
+                    }
+                    const double xmax = X.cwiseAbs().maxCoeff();
+                    for (int nt : threads) {
+                        std::vector<double> b(ld*k);
+                        for (int j = 0; j < k; j++)
+                            for (int i = 0; i < n; i++) b[j*ld+i] = B(i, j);
+                        rc = triangular_solve(upper, unit, t.data(), ld, b.data(), ld, n, k, nt);
+                        assert( !rc );
+                        double maxdiff = 0e0;
+                        for (int j = 0; j < k; j++)
+                            for (int i = 0; i < n; i++)
+                                maxdiff = std::max(maxdiff, std::abs(b[j*ld+i]-X(i, j)));
+                        if (maxdiff >= 1e-12*xmax) {
+                            printf("\nn=%d k=%d upper=%d unit=%d threads=%d max rel. diff: %.3e",
+                                n, k, upper, unit, nt, maxdiff/xmax);
+                        }
+                        assert( maxdiff < 1e-12*xmax );
+                    }
+                }
+            }
+        }
+
+        // back_substitution (single right-hand side, ld = n)
+        std::vector<double> u(n*n), x(n);
+        for (int j = 0; j < n; j++)
+            for (int i = 0; i < n; i++) u[j*n+i] = T(i, j);
+        Eigen::VectorXd bv(n);
+        for (int i = 0; i < n; i++) x[i] = bv(i) = distr(eng);
+        Eigen::VectorXd xv = T.triangularView<Eigen::Upper>().solve(bv);
+        back_substitution(u.data(), x.data(), n);
+        double maxdiff = 0e0;
+        for (int i = 0; i < n; i++) maxdiff = std::max(maxdiff, std::abs(x[i]-xv(i)));
+        printf("\nn=%4d back_substitution max rel. diff: %.3e", n, maxdiff/xv.cwiseAbs().maxCoeff());
+        assert( maxdiff < 1e-12*xv.cwiseAbs().maxCoeff() );
+    }
+
+    // ls_qrsolve
+    int shapes[][2] = {{3,1}, {10,4}, {50,50}, {300,41}, {2000,130}};
+    for (auto& s : shapes) {
+        const int m = s[0], n = s[1];
+        std::vector<double> A(m*n), y(m);
+        Eigen::MatrixXd Ae(m, n);
+        Eigen::VectorXd ye(m);
+        for (int j = 0; j < n; j++)
+            for (int i = 0; i < m; i++) A[j*m+i] = Ae(i, j) = distr(eng);
+        for (int i = 0; i < m; i++) y[i] = ye(i) = distr(eng);
+        Eigen::VectorXd xe = Ae.householderQr().solve(ye);
+        rc = ls_qrsolve(A.data(), y.data(), m, n);
+        assert( !rc );
+        double maxdiff = 0e0;
+        for (int j = 0; j < n; j++)
+            maxdiff = std::max(maxdiff, std::abs(y[j]-xe(j))/(1e0+std::abs(xe(j))));
+        printf("\n%4d x %4d ls_qrsolve max rel. diff: %.3e", m, n, maxdiff);
+        assert( maxdiff < 1e-9 );
+    }
+
+    // singular matrix
+    double z[] = {1e0, 0e0, 2e0, 0e0}, w[] = {1e0, 1e0};
+    rc = triangular_solve(true, false, z, 2, w, 2, 2, 1);
+    assert( rc == 1 );
+    rc = triangular_solve(true, true, z, 2, w, 2, 2, 1);
+    assert( !rc );
+
+    printf("\n");
+    return 0;
+}
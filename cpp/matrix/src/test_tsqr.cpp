@@ -0,0 +1,78 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "qr.hpp"
+#include "tsqr.hpp"
+
+// Check that tsqr gives the same R (up to the signs of its rows) as
+// householder_qr, and that the tsqr LS residuals are orthogonal to the
+// columns of A, for a number of shapes, chunk and thread counts.
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+    std::uniform_real_distribution<double> distr(-125e0, 125e0);
+
+    int shapes[][2] = {{10,4}, {50,50}, {300,7}, {10000,20}, {5003,13}};
+    int chunks[]    = {1, 2, 3, 8, 13};
+    int threads[]   = {1, 2, 5};
+    int sign, rc;
+    tsqr ts;
+
+    for (auto& s : shapes) {
+        int m = s[0], n = s[1];
+        std::vector<double> A(m*n), y(m), A1, A2, b1(n), x2, v;
+        for (auto& x : A) x = distr(eng);
+        for (auto& x : y) x = distr(eng);
+        A1 = A;
+        householder_qr(A1.data(), b1.data(), m, n, sign);
+        assert( !sign );
+        for (int nc : chunks) {
+            for (int nt : threads) {
+                A2 = A;
+                rc = ts.factor(A2.data(), m, n, nc, nt);
+                assert( !rc );
+                const double *R = ts.r();
+                double maxdiff = 0e0;
+                for (int i = 0; i < n; i++) {
+                    // rows of R are unique up to their sign
+                    double sgn = (A1[i*m+i]*R[i*n+i] < 0e0) ? -1e0 : 1e0;
+                    for (int j = i; j < n; j++) {
+                        maxdiff = std::max(maxdiff,
+                            std::abs(A1[j*m+i]-sgn*R[j*n+i])/(1e0+std::abs(A1[j*m+i])));
+                    }
+                }
+                x2 = y;
+                rc = ts.solve(x2.data(), nt);
+                assert( !rc );
+                // v = y - A*x; check A^T*v ~ 0 (relative to |A^T||y|)
+                v = y;
+                for (int j = 0; j < n; j++)
+                    for (int i = 0; i < m; i++) v[i] -= A[j*m+i]*x2[j];
+                double maxdx = 0e0, ynorm = 0e0, rnorm = 0e0, dnorm = 0e0;
+                for (double yi : y) ynorm += yi*yi;
+                for (double vi : v) rnorm += vi*vi;
+                for (int i = n; i < m; i++) dnorm += x2[i]*x2[i];
+                for (int j = 0; j < n; j++) {
+                    double dot = 0e0, anorm = 0e0;
+                    for (int i = 0; i < m; i++) {
+                        dot   += A[j*m+i]*v[i];
+                        anorm += A[j*m+i]*A[j*m+i];
+                    }
+                    maxdx = std::max(maxdx, std::abs(dot)/std::sqrt(anorm*ynorm));
+                }
+                printf("\n%5d x %5d chunks=%2d(%2d) threads=%d max rel. diff R: %.3e A^T*v: %.3e",
+                    m, n, nc, ts.num_chunks(), nt, maxdiff, maxdx);
+                assert( maxdiff < 1e-9 && maxdx < 1e-10 );
+                // the residual norm is the norm of d
+                assert( std::abs(std::sqrt(rnorm)-std::sqrt(dnorm)) <= 1e-9*(1e0+std::sqrt(ynorm)) );
+            }
+        }
+    }
+
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "updatable_qr.hpp"
+
+// Compare the solution and residual norm of a sliding window to the ones
+// of a new factorization of the window observations.
+void
+check_window(const sliding_window_qr& sw, const std::vector<double>& A,
+    const std::vector<double>& y, int m, int n, int last)
+{
+    updatable_qr ls(n);
+    std::vector<double> row(n), x1(n), x2(n);
+    for (int i = last-sw.size()+1; i <= last; i++) {
+        for (int j = 0; j < n; j++) row[j] = A[j*m+i];
+        ls.add_row(row.data(), y[i]);
+    }
+    const int rc1 = ls.solution(x1.data()), rc2 = sw.ls().solution(x2.data());
+    assert( !rc1 && !rc2 );
+    for (int j = 0; j < n; j++) {
+        assert( std::abs(x1[j]-x2[j]) <= 1e-8*(1e0+std::abs(x1[j])) );
+    }
+    assert( std::abs(ls.residual_norm()-sw.ls().residual_norm())
+            <= 1e-8*(1e0+ls.residual_norm()) );
+}
+
+// Absorb the rows of a LS system one at a time and in batches, and check
+// the solution (normal equations), the residual norm and the covariance
+// matrix against direct computations. Then run sliding windows over the
+// rows, with and without ill-conditioned downdates.
+int main()
+{
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 eng(rd()); // seed the generator
+    std::uniform_real_distribution<double> distr(-125e0, 125e0);
+
+    int shapes[][2] = {{10,4}, {50,50}, {300,7}, {5000,20}};
+    int batches[]   = {1, 3, 64, 10000};
+    int rc;
+
+    for (auto& s : shapes) {
+        int m = s[0], n = s[1];
+        std::vector<double> A(m*n), y(m), x(n), v(m), cov(n*n), row(n);
+        for (auto& a : A) a = distr(eng);
+        for (auto& a : y) a = distr(eng);
+        for (int batch : batches) {
+            updatable_qr ls(n);
+            for (int i = 0; i < m; ) {
+                int k = std::min(batch, m-i);
+                if (k == 1) {
+                    for (int j = 0; j < n; j++) row[j] = A[j*m+i];
+                    ls.add_row(row.data(), y[i]);
+                } else {
+                    rc = ls.add_rows(A.data()+i, m, y.data()+i, k);
+                    assert( !rc );
+                }
+                i += k;
+            }
+            assert( ls.num_obs() == m );
+            rc = ls.solution(x.data());
+            assert( !rc );
+            // v = y - A*x; check A^T*v ~ 0 and |v| == residual_norm
+            v = y;
+            for (int j = 0; j < n; j++)
+                for (int i = 0; i < m; i++) v[i] -= A[j*m+i]*x[j];
+            double maxdx = 0e0, ynorm = 0e0, rnorm = 0e0;
+            for (double yi : y) ynorm += yi*yi;
+            for (double vi : v) rnorm += vi*vi;
+            for (int j = 0; j < n; j++) {
+                double dot = 0e0, anorm = 0e0;
+                for (int i = 0; i < m; i++) {
+                    dot   += A[j*m+i]*v[i];
+                    anorm += A[j*m+i]*A[j*m+i];
+                }
+                maxdx = std::max(maxdx, std::abs(dot)/std::sqrt(anorm*ynorm));
+            }
+            assert( maxdx < 1e-10 );
+            assert( std::abs(std::sqrt(rnorm)-ls.residual_norm()) <= 1e-9*(1e0+std::sqrt(ynorm)) );
+            // (unscaled) covariance times A^T*A ~ I
+            rc = ls.covariance(cov.data(), false);
+            assert( !rc );
+            double maxdi = 0e0;
+            for (int j = 0; j < n; j++) {
+                for (int i = 0; i < n; i++) {
+                    double sum = 0e0;
+                    for (int l = 0; l < n; l++) {
+                        double ata = 0e0;
+                        for (int p = 0; p < m; p++) ata += A[l*m+p]*A[j*m+p];
+                        sum += cov[l*n+i]*ata;
+                    }
+                    maxdi = std::max(maxdi, std::abs(sum - (i==j ? 1e0 : 0e0)));
+                }
+            }
+            printf("\n%5d x %5d batch=%5d A^T*v: %.3e |cov*A^T*A-I|: %.3e",
+                m, n, batch, maxdx, maxdi);
+            assert( maxdi < 1e-8 );
+        }
+    }
+
+    // sliding windows
+    {
+        int m = 2000, n = 10, window = 50;
+        std::vector<double> A(m*n), y(m), row(n);
+        for (auto& a : A) a = distr(eng);
+        for (auto& a : y) a = distr(eng);
+        for (int refresh : {0, 100}) {
+            sliding_window_qr sw(n, window, refresh);
+            for (int i = 0; i < m; i++) {
+                for (int j = 0; j < n; j++) row[j] = A[j*m+i];
+                sw.push(row.data(), y[i]);
+                assert( sw.size() == std::min(i+1, window) );
+                if (i >= n) check_window(sw, A, y, m, n, i);
+            }
+            printf("\nwindow=%d refresh=%d refactorizations: %ld", window,
+                refresh, sw.num_refactorizations());
+            assert( sw.num_refactorizations() == (refresh ? (m-window)/refresh : 0) );
+        }
+        // every 100th row dominates the information on the first parameter,
+        // so that removing it is ill-conditioned
+        for (int i = 0; i < m; i += 100) A[i] *= 1e9;
+        sliding_window_qr sw(n, window);
+        for (int i = 0; i < m; i++) {
+            for (int j = 0; j < n; j++) row[j] = A[j*m+i];
+            sw.push(row.data(), y[i]);
+            if (i >= n) check_window(sw, A, y, m, n, i);
+        }
+        printf("\nwindow=%d ill-conditioned downdates, refactorizations: %ld",
+            window, sw.num_refactorizations());
+        assert( sw.num_refactorizations() > 0 );
+    }
+
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,414 @@
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <vector>
+#include "qr.hpp"
+#include "tiled_qr.hpp"
+#include "gemm_kernels.hpp"
+#include "run_threads.hpp"
+
+/// @brief TSQRT kernel; QR of a triangle on top of a square.
+///
+/// Compute the QR factorization of the (mi+kb)-by-kb matrix
+/// \f$[R; A]\f$, where R is kb-by-kb upper triangular and A is mi-by-kb.
+/// At output R is overwritten by the new triangular factor, A by the
+/// (non-trivial part of the) Householder vectors \f$v_j = [e_j; A(:,j)]\f$
+/// and t by the triangular factor of the block reflector (see
+/// block_reflector_t).
+static void
+tsqrt(double *__restrict__ r, int ldr, double *__restrict__ a, int lda,
+    int mi, int kb, double *__restrict__ t, int ldt)
+noexcept
+{
+    int c, j, i;
+    double sigma, mu, v0, beta, s;
+
+    for (c = 0; c < kb; c++) {
+        double *__restrict__ ac = a + c*lda;
+        const double x0 = r[c*ldr+c];
+        for (sigma = 0e0, i = 0; i < mi; i++) sigma += ac[i]*ac[i];
+        if (sigma == 0e0) {
+            beta = 0e0;
+        } else {
+            mu   = std::sqrt(x0*x0+sigma);
+            v0   = (x0 <= 0e0) ? (x0-mu) : (-sigma/(x0+mu));
+            beta = 2e0*v0*v0/(sigma+v0*v0);
+            for (i = 0; i < mi; i++) ac[i] /= v0;
+            r[c*ldr+c] = mu;
+        }
+        // apply to the remaining columns; only row c of R is affected
+        for (j = c+1; j < kb; j++) {
+            double *__restrict__ aj = a + j*lda;
+            for (s = r[j*ldr+c], i = 0; i < mi; i++) s += ac[i]*aj[i];
+            s *= beta;
+            r[j*ldr+c] -= s;
+            for (i = 0; i < mi; i++) aj[i] -= s*ac[i];
+        }
+        // column c of T; the identity parts of the vectors are orthogonal
+        for (j = 0; j < c; j++) {
+            const double *__restrict__ aj = a + j*lda;
+            for (s = 0e0, i = 0; i < mi; i++) s += aj[i]*ac[i];
+            t[c*ldt+j] = s;
+        }
+        for (j = 0; j < c; j++) {
+            for (s = 0e0, i = j; i < c; i++) s += t[i*ldt+j]*t[c*ldt+i];
+            t[c*ldt+j] = -beta*s;
+        }
+        t[c*ldt+c] = beta;
+    }
+}
+
+/// @brief TSMQR kernel; apply the TSQRT reflectors to two tiles.
+///
+/// Overwrite \f$[C_1; C_2]\f$ with \f$Q^T [C_1; C_2]\f$, where
+/// \f$Q = I - V T V^T\f$, \f$V = [I; V_2]\f$ as computed by tsqrt. C1 is
+/// kb-by-nc, C2 and V2 are mi-by-nc and mi-by-kb respectively. w is a
+/// workspace of size >= kb*nc.
+static void
+tsmqr(double *__restrict__ c1, int ldc1, double *__restrict__ c2, int ldc2,
+    const double *__restrict__ v2, int ldv, const double *__restrict__ t,
+    int ldt, int mi, int kb, int nc, double *__restrict__ w)
+noexcept
+{
+    int i, j;
+    // W = C1 + V2^T C2
+    for (j = 0; j < nc; j++) {
+        for (i = 0; i < kb; i++) w[j*kb+i] = c1[j*ldc1+i];
+    }
+    gemm_tn_acc(mi, kb, nc, v2, ldv, c2, ldc2, w, kb);
+    // W = T^T W
+    trmm_tn(kb, nc, t, ldt, w, kb);
+    // C1 -= W, C2 -= V2 W
+    for (j = 0; j < nc; j++) {
+        for (i = 0; i < kb; i++) c1[j*ldc1+i] -= w[j*kb+i];
+    }
+    gemm_nn_sub(mi, kb, nc, v2, ldv, w, kb, c2, ldc2);
+}
+
+namespace
+{
+
+/// Tile geometry of an m-by-n matrix, split in nb-by-nb tiles.
+struct tile_layout
+{
+    int m, n, nb, mt, nt;
+
+    tile_layout(int m_, int n_, int nb_) noexcept
+    : m{m_}, n{n_}, nb{nb_}, mt{(m_+nb_-1)/nb_}, nt{(n_+nb_-1)/nb_}
+    {}
+
+    /// Number of rows in tile row i.
+    int rows(int i) const noexcept { return std::min(nb, m-i*nb); }
+    /// Number of columns in tile column j.
+    int cols(int j) const noexcept { return std::min(nb, n-j*nb); }
+    /// Offset of tile (i,j) in a column-major array of leading dimension m.
+    long tile(int i, int j) const noexcept { return (long)j*nb*m + (long)i*nb; }
+    /// Offset of the T factor of tile (i,k).
+    long tfac(int i, int k) const noexcept { return ((long)k*mt+i)*nb*nb; }
+};
+
+enum class tile_op : char { geqrt, unmqr, tsqrt, tsmqr };
+
+/// A tile kernel invocation.
+struct tile_task
+{
+    tile_op op;
+    int     i, j, k;
+};
+
+/// Per-thread workspace for the tile kernels.
+struct tile_work
+{
+    std::vector<double> u, tau, w;
+
+    explicit
+    tile_work(int nb)
+    : u(nb), tau(nb), w(block_reflector_worksize(nb, nb))
+    {}
+};
+
+/// Run a tile kernel on the matrix a (with T factors t) or, if c is not
+/// null, apply it to the m-by-nc matrix c (leading dimension ldc).
+void
+run_task(const tile_task& tk, const tile_layout& l, double *a, double *t,
+    double *c, int ldc, int nc, tile_work& wk)
+noexcept
+{
+    const int k = tk.k, kb = l.cols(k), mk = l.rows(k);
+    double *akk = a + l.tile(k,k);
+    switch (tk.op) {
+        case tile_op::geqrt:
+            householder_qr_panel(akk, l.m, wk.tau.data(), mk, kb, wk.u.data());
+            block_reflector_t(akk, l.m, wk.tau.data(), mk, kb, t+l.tfac(k,k), l.nb);
+            break;
+        case tile_op::unmqr:
+            if (c) {
+                apply_block_reflector(true, akk, l.m, t+l.tfac(k,k), l.nb, mk,
+                    kb, c+k*l.nb, ldc, nc, wk.w.data());
+            } else {
+                apply_block_reflector(true, akk, l.m, t+l.tfac(k,k), l.nb, mk,
+                    kb, a+l.tile(k,tk.j), l.m, l.cols(tk.j), wk.w.data());
+            }
+            break;
+        case tile_op::tsqrt:
+            tsqrt(akk, l.m, a+l.tile(tk.i,k), l.m, l.rows(tk.i), kb,
+                t+l.tfac(tk.i,k), l.nb);
+            break;
+        case tile_op::tsmqr:
+            if (c) {
+                tsmqr(c+k*l.nb, ldc, c+tk.i*l.nb, ldc, a+l.tile(tk.i,k), l.m,
+                    t+l.tfac(tk.i,k), l.nb, l.rows(tk.i), kb, nc, wk.w.data());
+            } else {
+                tsmqr(a+l.tile(k,tk.j), l.m, a+l.tile(tk.i,tk.j), l.m,
+                    a+l.tile(tk.i,k), l.m, t+l.tfac(tk.i,k), l.nb,
+                    l.rows(tk.i), kb, l.cols(tk.j), wk.w.data());
+            }
+            break;
+    }
+}
+
+/// @brief A task graph, with dependencies inferred from tile accesses.
+///
+/// Tasks are added in sequential program order, each declaring the
+/// resources (tiles) it reads and writes. A task depends on the last writer
+/// of every resource it accesses and, if it writes a resource, on all of its
+/// readers since that write.
+class task_graph
+{
+public:
+    explicit
+    task_graph(int num_resources)
+    : _last_writer(num_resources, -1),
+      _readers(num_resources)
+    {}
+
+    void
+    add(const tile_task& tk, std::initializer_list<int> reads,
+        std::initializer_list<int> writes)
+    {
+        const int id = static_cast<int>(_tasks.size());
+        _tasks.push_back(tk);
+        _succ.emplace_back();
+        _ndeps.push_back(0);
+        for (int r : reads) {
+            this->depend(_last_writer[r], id);
+            _readers[r].push_back(id);
+        }
+        for (int r : writes) {
+            this->depend(_last_writer[r], id);
+            for (int rd : _readers[r]) this->depend(rd, id);
+            _readers[r].clear();
+            _last_writer[r] = id;
+        }
+    }
+
+    /// Execute all tasks on num_threads threads; work(task, thread) runs a
+    /// single task. Ready tasks are run in (sequential) program order, which
+    /// favours the critical path.
+    void
+    run(int num_threads, const std::function<void(const tile_task&, int)>& work)
+    {
+        const int ntasks = static_cast<int>(_tasks.size());
+        std::vector<std::atomic<int>> remaining(ntasks);
+        std::priority_queue<int, std::vector<int>, std::greater<int>> ready;
+        for (int i = 0; i < ntasks; i++) {
+            remaining[i] = _ndeps[i];
+            if (!_ndeps[i]) ready.push(i);
+        }
+        std::mutex              mtx;
+        std::condition_variable cv;
+        int                     done = 0;
+
+        auto worker = [&](int tid) {
+            std::unique_lock<std::mutex> lock(mtx);
+            for (;;) {
+                cv.wait(lock, [&]{ return !ready.empty() || done == ntasks; });
+                if (done == ntasks) return;
+                int id = ready.top();
+                ready.pop();
+                lock.unlock();
+                work(_tasks[id], tid);
+                int released = 0;
+                lock.lock();
+                for (int s : _succ[id]) {
+                    if (--remaining[s] == 0) {
+                        ready.push(s);
+                        ++released;
+                    }
+                }
+                if (++done == ntasks) {
+                    cv.notify_all();
+                } else if (released > 1) {
+                    cv.notify_all();
+                } else if (released) {
+                    cv.notify_one();
+                }
+            }
+        };
+
+        // the workers share the ready queue, so if a thread cannot be
+        // started the ones created so far do its tasks
+        run_threads(num_threads, worker);
+    }
+
+private:
+    void
+    depend(int from, int to)
+    {
+        if (from < 0 || from == to) return;
+        if (!_succ[from].empty() && _succ[from].back() == to) return;
+        _succ[from].push_back(to);
+        ++_ndeps[to];
+    }
+
+    std::vector<tile_task>        _tasks;
+    std::vector<std::vector<int>> _succ;
+    std::vector<int>              _ndeps;
+    std::vector<int>              _last_writer;
+    std::vector<std::vector<int>> _readers;
+};
+
+} // namespace
+
+/// @brief Tiled QR factorization, run on a pool of threads.
+///
+/// See tiled_qr.hpp for a description of the algorithm and of the output.
+///
+/// @param[in,out] a           The matrix \f$A\in{\Re}^{m\times n}\f$,
+///                            \f$m \geq n\f$ (column-wise). At output, R
+///                            (upper triangle) and the tile Householder
+///                            vectors.
+/// @param[out]    t           Array of size tiled_qr_tsize(m, n, nb); at
+///                            output the T factors of the tile reflectors.
+/// @param[in]     m           Number of rows of A.
+/// @param[in]     n           Number of columns of A.
+/// @param[in]     nb          Tile size; one giving more than
+///                            tiled_qr_max_tasks tasks is rejected.
+/// @param[in]     num_threads Number of threads; if <= 0, then
+///                            std::thread::hardware_concurrency is used.
+/// @return        0 on success; any other value denotes an error (invalid
+///                arguments, too many tasks or allocation failure).
+int
+tiled_qr(double *__restrict__ a, double *__restrict__ t, int m, int n, int nb,
+    int num_threads)
+{
+    if (m < n || n < 1 || nb < 1) return 1;
+    if (tiled_qr_num_tasks(m, n, nb) > tiled_qr_max_tasks) return 1;
+    num_threads = resolve_threads(num_threads);
+
+    const tile_layout l(m, n, nb);
+    // resources: every tile, plus the upper triangle (R) of diagonal tiles
+    auto tile  = [&](int i, int j) { return i*l.nt+j; };
+    auto upper = [&](int k) { return l.mt*l.nt+k; };
+
+    try {
+        task_graph g(l.mt*l.nt + l.nt);
+        for (int k = 0; k < l.nt; k++) {
+            g.add({tile_op::geqrt, k, k, k}, {}, {tile(k,k), upper(k)});
+            for (int j = k+1; j < l.nt; j++) {
+                g.add({tile_op::unmqr, k, j, k}, {tile(k,k)}, {tile(k,j)});
+            }
+            for (int i = k+1; i < l.mt; i++) {
+                g.add({tile_op::tsqrt, i, k, k}, {}, {upper(k), tile(i,k)});
+                for (int j = k+1; j < l.nt; j++) {
+                    g.add({tile_op::tsmqr, i, j, k}, {tile(i,k)},
+                          {tile(k,j), tile(i,j)});
+                }
+            }
+        }
+        std::vector<tile_work> work(num_threads, tile_work(nb));
+        g.run(num_threads, [&](const tile_task& tk, int tid) {
+            run_task(tk, l, a, t, nullptr, 0, 0, work[tid]);
+        });
+    } catch (std::bad_alloc&) {
+        return 1;
+    }
+    return 0;
+}
+
+/// @brief Apply \f$Q^T\f$ of a tiled QR factorization to a matrix.
+///
+/// Overwrite the m-by-nc matrix C with \f$Q^T C\f$, where Q is the
+/// orthogonal factor computed by tiled_qr.
+///
+/// @param[in]     a   The output of tiled_qr (m-by-n, column-wise).
+/// @param[in]     t   The T factors, as computed by tiled_qr.
+/// @param[in]     m   Number of rows of A and C.
+/// @param[in]     n   Number of columns of A.
+/// @param[in]     nb  Tile size (same as in the call to tiled_qr).
+/// @param[in,out] c   The matrix C (column-wise, leading dimension ldc).
+/// @param[in]     ldc Leading dimension of c (\f$ldc \geq m\f$).
+/// @param[in]     nc  Number of columns of C.
+/// @return        0 on success; any other value denotes an error.
+int
+tiled_qr_apply_qt(const double *__restrict__ a, const double *__restrict__ t,
+    int m, int n, int nb, double *__restrict__ c, int ldc, int nc)
+{
+    if (m < n || n < 1 || nb < 1) return 1;
+    const tile_layout l(m, n, nb);
+    try {
+        tile_work wk(std::max(nb, 1));
+        wk.w.resize(std::max(block_reflector_worksize(nb, nc), nb*nc));
+        double *aa = const_cast<double*>(a), *tt = const_cast<double*>(t);
+        for (int k = 0; k < l.nt; k++) {
+            run_task({tile_op::unmqr, k, 0, k}, l, aa, tt, c, ldc, nc, wk);
+            for (int i = k+1; i < l.mt; i++) {
+                run_task({tile_op::tsmqr, i, 0, k}, l, aa, tt, c, ldc, nc, wk);
+            }
+        }
+    } catch (std::bad_alloc&) {
+        return 1;
+    }
+    return 0;
+}
+
+/// @brief Tiled-QR LS solution.
+///
+/// Solves the (overdetermined) Least Squares system \f$Ax=b\f$ (A of full
+/// column rank), as ls_qrsolve does, but using the (multithreaded) tiled_qr
+/// factorization.
+///
+/// @param[in,out] a           The design matrix (m-by-n, column-wise); at
+///                            output, overwritten by its tiled QR factors.
+/// @param[in,out] b           The observation vector, of size m. At output,
+///                            its first n elements hold the LS solution.
+/// @param[in]     m           Number of observations (rows of a and b).
+/// @param[in]     n           Number of parameters (columns of a).
+/// @param[in]     nb          Tile size; doubled (as many times as needed)
+///                            if it gives more than tiled_qr_max_tasks
+///                            tasks.
+/// @param[in]     num_threads Number of threads; if <= 0, then
+///                            std::thread::hardware_concurrency is used.
+/// @return        0 on success; any other value denotes an error.
+int
+tiled_ls_qrsolve(double *__restrict__ a, double *__restrict__ b, int m, int n,
+    int nb, int num_threads)
+{
+    if (m < n || n < 1 || nb < 1) return 1;
+    // the factors are not returned, so any tile size will do
+    while (tiled_qr_num_tasks(m, n, nb) > tiled_qr_max_tasks) nb *= 2;
+    double *t;
+    try {
+        t = new double[tiled_qr_tsize(m, n, nb)];
+    } catch (std::bad_alloc&) {
+        return 1;
+    }
+
+    int status = tiled_qr(a, t, m, n, nb, num_threads);
+    if (!status) status = tiled_qr_apply_qt(a, t, m, n, nb, b, m, 1);
+    delete[] t;
+    if (status) return status;
+
+    // Solve R(1:n,1:n) * x = b(1:n)
+    for (int j = n-1; j >= 0; j--) {
+        if (a[(long)j*m+j] == 0e0) return 1;
+        b[j] /= a[(long)j*m+j];
+        for (int i = 0; i < j; i++) b[i] -= b[j]*a[(long)j*m+i];
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+#ifndef __TILED_QR_HPP__
+#define __TILED_QR_HPP__
+
+/// @brief Tiled (multithreaded) QR factorization.
+///
+/// The m-by-n matrix A (column-major, \f$m \geq n\f$) is split in nb-by-nb
+/// tiles \f$A_{ij}\f$, which are factored in place by four kernels:
+///   - GEQRT(k):     QR of the diagonal tile \f$A_{kk}\f$,
+///   - UNMQR(k,j):   apply \f$Q_{kk}^T\f$ to \f$A_{kj}\f$, j>k,
+///   - TSQRT(i,k):   QR of the triangle-on-top-of-square \f$[R_{kk}; A_{ik}]\f$,
+///                   i>k,
+///   - TSMQR(i,k,j): apply the TSQRT reflectors to \f$[A_{kj}; A_{ij}]\f$,
+///                   i,j>k.
+/// The kernels are generated in the order of the sequential algorithm, and
+/// a task scheduler runs them on a pool of threads as soon as the tiles they
+/// read/write are ready (i.e. respecting read-after-write, write-after-read
+/// and write-after-write dependencies), so that independent tile updates of
+/// the same (and of subsequent) steps run concurrently.
+///
+/// At output, the upper triangle of A holds R (as for householder_qr); the
+/// tiles below it hold the Householder vectors of the tile kernels (note
+/// that this is **not** the householder_qr format, so thin_q/ls_qrsolve can
+/// not be used; use tiled_qr_apply_qt and tiled_ls_qrsolve instead). The
+/// triangular factors of the (per tile) block reflectors are stored in a
+/// separate array t, of size tiled_qr_tsize(m, n, nb).
+///
+/// Reference: Buttari, A., Langou, J., Kurzak, J. & Dongarra, J., A class of
+///            parallel tiled linear algebra algorithms for multicore
+///            architectures, Parallel Computing 35 (2009), 38-53
+
+/// Size of the array (number of doubles) holding the T factors of a tiled QR.
+inline int
+tiled_qr_tsize(int m, int n, int nb) noexcept
+{ return ((m+nb-1)/nb) * ((n+nb-1)/nb) * nb * nb; }
+
+/// Number of tasks (tile kernels) of the tiled QR of an m-by-n matrix.
+inline long
+tiled_qr_num_tasks(int m, int n, int nb) noexcept
+{
+    const long mt = (m+nb-1)/nb, nt = (n+nb-1)/nb;
+    long count = 0;
+    for (long k = 0; k < nt; k++) count += nt-k + (mt-k-1)*(nt-k);
+    return count;
+}
+
+/// Max number of tasks of a tiled QR. The whole task graph (some 100 bytes
+/// per task) is built before it is run, and a small tile size on a large
+/// matrix would need millions of tasks (e.g. 14.6M for 517-by-260 and
+/// nb=1), so tiled_qr rejects a tile size exceeding this.
+constexpr long tiled_qr_max_tasks = 1L << 20;
+
+int
+tiled_qr(double *__restrict__ a, double *__restrict__ t, int m, int n, int nb,
+    int num_threads = 0);
+
+int
+tiled_qr_apply_qt(const double *__restrict__ a, const double *__restrict__ t,
+    int m, int n, int nb, double *__restrict__ c, int ldc, int nc);
+
+int
+tiled_ls_qrsolve(double *__restrict__ a, double *__restrict__ b, int m, int n,
+    int nb = 128, int num_threads = 0);
+
+#endif
@@ -0,0 +1,217 @@
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include "qr.hpp"
+#include "tsqr.hpp"
+#include "run_threads.hpp"
+
+/// @brief Apply the Householder reflectors of a QR factorization to a vector.
+///
+/// Overwrite x with \f$Q^T x\f$, where Q is given by the n Householder
+/// vectors stored (householder_qr style) below the diagonal of the m-by-n
+/// matrix v (column-wise, leading dimension ldv) and the coefficients beta.
+static void
+apply_householder_qt(const double *__restrict__ v, int ldv,
+    const double *__restrict__ beta, int m, int n, double *__restrict__ x)
+noexcept
+{
+    double sum;
+    int    i, j;
+    for (j = 0; j < n && j < m; j++) {
+        const double *__restrict__ vj = v + j*ldv;
+        for (sum = x[j], i = j+1; i < m; i++) sum += vj[i]*x[i];
+        sum *= beta[j];
+        x[j] -= sum;
+        for (i = j+1; i < m; i++) x[i] -= sum*vj[i];
+    }
+}
+
+/// @brief Reduction tree node; QR of two stacked triangles.
+///
+/// Compute the QR factorization of \f$[R_i; R_j]\f$ (the current triangular
+/// factors of chunks i and j) into the node buffer of chunk j, which then
+/// holds (in its top n rows) the current R factor of chunk i.
+void
+tsqr::merge(int i, int j, double *__restrict__ u) noexcept
+{
+    const int n = _n, ld = 2*n;
+    double *__restrict__ node = _node.data() + (long)(j-1)*ld*n;
+    const double *__restrict__ ri = _rp[i];
+    const double *__restrict__ rj = _rp[j];
+    for (int c = 0; c < n; c++) {
+        double *__restrict__ col = node + c*ld;
+        std::fill(col, col+ld, 0e0);
+        for (int r = 0; r <= c; r++) {
+            col[r]   = ri[c*_ldr[i]+r];
+            col[n+r] = rj[c*_ldr[j]+r];
+        }
+    }
+    householder_qr_panel(node, ld, _nbeta.data()+(long)(j-1)*n, ld, n, u);
+    _rp[i]  = node;
+    _ldr[i] = ld;
+}
+
+/// @brief TSQR factorization.
+///
+/// Factor the m-by-n matrix A (column-wise, \f$m \geq n\f$) in num_chunks
+/// row chunks, on num_threads threads. At output, each chunk of A is
+/// overwritten by its householder_qr factorization (R factor and Householder
+/// vectors); the final R factor is available via r().
+///
+/// @param[in,out] a           The matrix \f$A\in{\Re}^{m\times n}\f$
+///                            (column-wise). It must outlive the object (or
+///                            the next call to factor), as it holds part of
+///                            the implicit Q.
+/// @param[in]     m           Number of rows of A.
+/// @param[in]     n           Number of columns of A.
+/// @param[in]     num_chunks  Number of row chunks; if <= 0 then the number
+///                            of threads is used. It is reduced if needed, so
+///                            that every chunk has at least 2n rows.
+/// @param[in]     num_threads Number of threads; if <= 0, then
+///                            std::thread::hardware_concurrency is used.
+/// @return        0 on success; any other value denotes an error (invalid
+///                arguments or allocation failure).
+int
+tsqr::factor(double *__restrict__ a, int m, int n, int num_chunks,
+    int num_threads)
+{
+    if (m < n || n < 1) return 1;
+    num_threads = resolve_threads(num_threads, m);
+    if (num_chunks <= 0) num_chunks = num_threads;
+    num_chunks  = std::max(1, std::min(num_chunks, m/(2*n)));
+    num_threads = std::min(num_threads, num_chunks);
+
+    std::vector<double> work;
+    int maxrows = 0;
+    try {
+        _row0.resize(num_chunks+1);
+        for (int i = 0; i <= num_chunks; i++) {
+            _row0[i] = static_cast<int>((long)m*i/num_chunks);
+        }
+        for (int i = 0; i < num_chunks; i++) {
+            maxrows = std::max(maxrows, _row0[i+1]-_row0[i]);
+        }
+        _beta.assign((long)num_chunks*n, 0e0);
+        _node.assign((long)(num_chunks-1)*2*n*n, 0e0);
+        _nbeta.assign((long)(num_chunks-1)*n, 0e0);
+        _rp.assign(num_chunks, nullptr);
+        _ldr.assign(num_chunks, m);
+        _r.assign((long)n*n, 0e0);
+        work.resize((long)num_threads*std::max(maxrows, 2*n));
+    } catch (std::bad_alloc&) {
+        return 1;
+    }
+    _a = a;
+    _m = m;
+    _n = n;
+
+    // arrival counters of the tree nodes, indexed by their right child
+    std::vector<std::atomic<int>> arrived(num_chunks);
+    for (auto& c : arrived) c.store(0, std::memory_order_relaxed);
+    std::atomic<int> next {0};
+
+    auto worker = [&](int tid) {
+        double *u = work.data() + (long)tid*std::max(maxrows, 2*n);
+        for (int c = next++; c < num_chunks; c = next++) {
+            const int r0 = _row0[c], rows = _row0[c+1]-r0;
+            householder_qr_panel(a+r0, m, _beta.data()+(long)c*n, rows, n, u);
+            _rp[c] = a+r0;
+            // climb the tree for as long as this thread completes nodes
+            int i = c;
+            for (int step = 1; step < num_chunks; step *= 2) {
+                const int left = i / (2*step) * (2*step), right = left+step;
+                if (right >= num_chunks) continue; // no sibling at this level
+                if (arrived[right].fetch_add(1, std::memory_order_acq_rel) == 0) {
+                    break; // sibling not done yet; it will merge
+                }
+                this->merge(left, right, u);
+                i = left;
+            }
+        }
+    };
+
+    run_threads(num_threads, worker);
+
+    for (int c = 0; c < n; c++) {
+        for (int r = 0; r <= c; r++) _r[c*n+r] = _rp[0][c*_ldr[0]+r];
+    }
+    return 0;
+}
+
+/// @brief Apply \f$Q^T\f$ of a TSQR factorization to a vector.
+///
+/// Overwrite the vector b (of size m) with \f$Q^T b\f$. At output, the first
+/// n elements of b hold c and the remaining m-n elements hold (a
+/// permutation of) d, where \f$Q^T b = [c; d]\f$, so that the LS residual
+/// norm is \f$\|d\|\f$ (see qr.hpp).
+///
+/// @param[in,out] b           Vector of size m.
+/// @param[in]     num_threads Number of threads (for the per-chunk part); if
+///                            <= 0, then std::thread::hardware_concurrency is
+///                            used.
+/// @return        0 on success; any other value denotes an error (i.e. no
+///                factorization).
+int
+tsqr::apply_qt(double *__restrict__ b, int num_threads) const
+{
+    const int p = this->num_chunks(), n = _n;
+    if (!_a || p < 1) return 1;
+    num_threads = resolve_threads(num_threads, p);
+
+    std::atomic<int> next {0};
+    auto worker = [&](int) {
+        for (int c = next++; c < p; c = next++) {
+            const int r0 = _row0[c];
+            apply_householder_qt(_a+r0, _m, _beta.data()+(long)c*n,
+                _row0[c+1]-r0, n, b+r0);
+        }
+    };
+    run_threads(num_threads, worker);
+
+    // the tree, level by level; nodes are tiny, so this is done serially
+    std::vector<double> x;
+    try {
+        x.resize(2*n);
+    } catch (std::bad_alloc&) {
+        return 1;
+    }
+    for (int step = 1; step < p; step *= 2) {
+        for (int left = 0; left + step < p; left += 2*step) {
+            const int right = left+step;
+            std::copy(b+_row0[left],  b+_row0[left]+n,  x.data());
+            std::copy(b+_row0[right], b+_row0[right]+n, x.data()+n);
+            apply_householder_qt(_node.data()+(long)(right-1)*2*n*n, 2*n,
+                _nbeta.data()+(long)(right-1)*n, 2*n, n, x.data());
+            std::copy(x.data(),   x.data()+n,   b+_row0[left]);
+            std::copy(x.data()+n, x.data()+2*n, b+_row0[right]);
+        }
+    }
+    return 0;
+}
+
+/// @brief TSQR LS solution.
+///
+/// Given the TSQR factorization of the design matrix A, compute the vector
+/// \f$x_{LS}\f$ minimizing \f$\|Ax-b\|\f$ (A of full column rank).
+///
+/// @param[in,out] b           The observation vector, of size m. At output,
+///                            its first n elements hold the LS solution and
+///                            the remaining ones d (see apply_qt).
+/// @param[in]     num_threads Number of threads; see apply_qt.
+/// @return        0 on success; any other value denotes an error (no
+///                factorization or singular R).
+int
+tsqr::solve(double *__restrict__ b, int num_threads) const
+{
+    if (int status = this->apply_qt(b, num_threads)) return status;
+
+    // Solve R * x = b(1:n)
+    const int n = _n;
+    for (int j = n-1; j >= 0; j--) {
+        if (_r[j*n+j] == 0e0) return 1;
+        b[j] /= _r[j*n+j];
+        for (int i = 0; i < j; i++) b[i] -= b[j]*_r[j*n+i];
+    }
+    return 0;
+}
@@ -0,0 +1,72 @@
+#ifndef __TSQR_HPP__
+#define __TSQR_HPP__
+
+#include <vector>
+
+/// @brief TSQR (Tall Skinny QR) factorization.
+///
+/// A communication-avoiding QR factorization for matrices with many more
+/// rows than columns (\f$m \gg n\f$). The rows of A are split in p chunks
+/// \f$A_0, A_1, ..., A_{p-1}\f$, each of which is factored independently
+/// (and concurrently) with the householder_qr kernel, i.e.
+/// \f$A_i = Q_i R_i\f$. The p small (n-by-n) triangular factors are then
+/// combined pairwise along a binary reduction tree, where each node computes
+/// the QR factorization of two stacked triangles \f$[R_i; R_j] = Q_{ij}
+/// R_{ij}\f$, until a single R is left. A node is processed by the thread
+/// that finishes the second of its two children, so that there is no
+/// synchronization between tree levels.
+///
+/// Q is kept in implicit form: the Householder vectors of each chunk are
+/// stored in place of the chunk (below its R, as for householder_qr) and
+/// the ones of the tree nodes are kept within the object. Use apply_qt to
+/// compute \f$Q^T b\f$ and solve for the LS solution.
+///
+/// The factorization (but not its cost) depends on the number of chunks;
+/// for a given number of chunks, the result is independent of the number of
+/// threads used.
+///
+/// Reference: Demmel, J., Grigori, L., Hoemmen, M. & Langou, J.,
+///            Communication-optimal parallel and sequential QR and LU
+///            factorizations, SIAM J. Sci. Comput. 34 (2012), A206-A239
+///
+/// @example test_tsqr.cpp
+class tsqr
+{
+public:
+    int
+    factor(double *__restrict__ a, int m, int n, int num_chunks = 0,
+        int num_threads = 0);
+
+    int
+    apply_qt(double *__restrict__ b, int num_threads = 0) const;
+
+    int
+    solve(double *__restrict__ b, int num_threads = 0) const;
+
+    /// The (n-by-n, column-wise) upper triangular factor R.
+    const double*
+    r() const noexcept
+    { return _r.data(); }
+
+    /// Number of chunks used in the (last) factorization.
+    int
+    num_chunks() const noexcept
+    { return static_cast<int>(_row0.size()) - 1; }
+
+private:
+    void
+    merge(int i, int j, double *__restrict__ u) noexcept;
+
+    const double*       _a {nullptr}; ///< factored matrix (not owned)
+    int                 _m {0},       ///< rows of A
+                        _n {0};       ///< columns of A
+    std::vector<int>    _row0;        ///< first row of each chunk (plus m)
+    std::vector<double> _beta;        ///< chunk beta coefficients, n per chunk
+    std::vector<double> _node;        ///< tree nodes, 2n-by-n each
+    std::vector<double> _nbeta;       ///< tree node beta coefficients
+    std::vector<const double*> _rp;   ///< current R factor of each chunk
+    std::vector<int>    _ldr;         ///< leading dimension of each _rp
+    std::vector<double> _r;           ///< the final R, n-by-n
+};
+
+#endif
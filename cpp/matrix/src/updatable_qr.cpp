@@ -0,0 +1,295 @@
+#include <cmath>
+#include <algorithm>
+#include <new>
+#include "qr_covariance.hpp"
+#include "updatable_qr.hpp"
+#include "qr_append.hpp"
+
+/// @brief Constructor; no observations.
+///
+/// @param[in] n Number of parameters (columns of the design matrix), > 0.
+/// @throw     std::bad_alloc if memory allocation fails.
+updatable_qr::updatable_qr(int n)
+: _n{n}, _nobs{0}, _rss{0e0}, _r((long)n*n, 0e0), _c(n, 0e0), _row(n, 0e0),
+  _cs(n, 0e0), _sn(n, 0e0)
+{}
+
+void
+updatable_qr::reset() noexcept
+{
+    std::fill(_r.begin(), _r.end(), 0e0);
+    std::fill(_c.begin(), _c.end(), 0e0);
+    _nobs = 0;
+    _rss  = 0e0;
+}
+
+/// @brief Add a single observation (row), via Givens rotations.
+///
+/// Absorb the observation equation \f$a^T x = b\f$, with weight w, in
+/// \f$O(n^2)\f$. Row j of R is rotated against the (remaining) observation
+/// row, so as to annihilate its j-th element, for j=0,...,n-1; what remains
+/// of b is the contribution of the observation to the residual norm.
+///
+/// @param[in] a The row of the design matrix, of size n.
+/// @param[in] b The observation.
+/// @param[in] w The weight of the observation (> 0); the row and the
+///              observation are scaled by \f$\sqrt{w}\f$.
+void
+updatable_qr::add_row(const double *__restrict__ a, double b, double w)
+noexcept
+{
+    const int n = _n;
+    double *__restrict__ row = _row.data();
+    double *__restrict__ r   = _r.data();
+    double *__restrict__ c   = _c.data();
+    const double sw = (w == 1e0) ? 1e0 : std::sqrt(w);
+    for (int j = 0; j < n; j++) row[j] = sw*a[j];
+    b *= sw;
+
+    double cs, sn, rho, u, v;
+    for (int j = 0; j < n; j++) {
+        if (row[j] == 0e0) continue;
+        // rotation zeroing row[j] against R(j,j)
+        rho = std::hypot(r[j*n+j], row[j]);
+        cs  = r[j*n+j] / rho;
+        sn  = row[j] / rho;
+        r[j*n+j] = rho;
+        for (int k = j+1; k < n; k++) {
+            u = r[k*n+j];
+            v = row[k];
+            r[k*n+j] =  cs*u + sn*v;
+            row[k]   = -sn*u + cs*v;
+        }
+        u = c[j];
+        c[j] =  cs*u + sn*b;
+        b    = -sn*u + cs*b;
+    }
+    _rss += b*b;
+    ++_nobs;
+}
+
+/// @brief Add a batch of observations, via Householder reflections.
+///
+/// Absorb the k observation equations \f$A_k x = b_k\f$ in \f$O(kn^2)\f$, by
+/// computing the QR factorization of \f$[R; A_k]\f$ (see qr_append_rows).
+///
+/// @param[in] a   The k-by-n design matrix block (column-wise, leading
+///                dimension lda >= k).
+/// @param[in] lda Leading dimension of a.
+/// @param[in] b   The k observations.
+/// @param[in] k   Number of observations (rows of a).
+/// @return    0 on success; any other value denotes an error (allocation
+///            failure or invalid arguments).
+int
+updatable_qr::add_rows(const double *__restrict__ a, int lda,
+    const double *__restrict__ b, int k)
+{
+    const int n = _n;
+    if (k < 0 || lda < k) return 1;
+    if (!k) return 0;
+    try {
+        if ((long)_work.size() < (long)k*(n+1)) _work.resize((long)k*(n+1));
+    } catch (std::bad_alloc&) {
+        return 1;
+    }
+    // copy [A_k b_k] to the workspace (column-wise, leading dimension k)
+    double *__restrict__ x = _work.data();
+    for (int j = 0; j < n; j++) std::copy(a+(long)j*lda, a+(long)j*lda+k, x+(long)j*k);
+    std::copy(b, b+k, x+(long)n*k);
+
+    qr_append_rows(_r.data(), n, _c.data(), x, k, n);
+    // what is left of b_k goes to the residuals
+    const double *__restrict__ xb = x + (long)n*k;
+    for (int i = 0; i < k; i++) _rss += xb[i]*xb[i];
+    _nobs += k;
+    return 0;
+}
+
+/// @brief Remove a single observation (row), via LINPACK downdating.
+///
+/// Remove the observation equation \f$a^T x = b\f$ (with weight w) from the
+/// system, in \f$O(n^2)\f$. With \f$R^T p = \sqrt{w}a\f$, the downdate is
+/// possible only if \f$\|p\| < 1\f$, and rounding errors are amplified by
+/// about \f$1/\alpha^2\f$, where \f$\alpha = \sqrt{1-\|p\|^2}\f$; this is
+/// the health check of the algorithm. Failure is reported (and nothing is
+/// changed) if \f$\alpha < tol\f$; the default tolerance keeps the relative
+/// errors of a downdate below ~1e-8.
+///
+/// @param[in] a   The row of the design matrix, of size n.
+/// @param[in] b   The observation.
+/// @param[in] w   The weight of the observation (as used in add_row).
+/// @param[in] tol Minimum \f$\alpha\f$ for the downdate to be accepted.
+/// @return    0 on success; 1 if the downdate is (numerically) impossible,
+///            in which case the object is unchanged.
+int
+updatable_qr::remove_row(const double *__restrict__ a, double b, double w,
+    double tol)
+noexcept
+{
+    const int n = _n;
+    double *__restrict__ p  = _row.data();
+    double *__restrict__ r  = _r.data();
+    double *__restrict__ c  = _c.data();
+    double *__restrict__ cs = _cs.data();
+    double *__restrict__ sn = _sn.data();
+    const double sw = (w == 1e0) ? 1e0 : std::sqrt(w);
+    int i, j;
+
+    // solve R^T p = sqrt(w)*a
+    double norm = 0e0, sum;
+    for (j = 0; j < n; j++) {
+        if (r[j*n+j] == 0e0) return 1;
+        for (sum = sw*a[j], i = 0; i < j; i++) sum -= r[j*n+i]*p[i];
+        p[j] = sum / r[j*n+j];
+        norm += p[j]*p[j];
+    }
+    if (norm >= 1e0) return 1;
+    double alpha = std::sqrt(1e0-norm);
+    if (alpha < tol) return 1;
+
+    // the rotations
+    double scale, x, y;
+    for (i = n-1; i >= 0; i--) {
+        scale = alpha + std::abs(p[i]);
+        x     = alpha / scale;
+        y     = p[i] / scale;
+        norm  = std::sqrt(x*x+y*y);
+        cs[i] = x / norm;
+        sn[i] = y / norm;
+        alpha = scale*norm;
+    }
+
+    // apply them to R, column by column
+    double xx, t;
+    for (j = 0; j < n; j++) {
+        xx = 0e0;
+        for (i = j; i >= 0; i--) {
+            t        = cs[i]*xx + sn[i]*r[j*n+i];
+            r[j*n+i] = cs[i]*r[j*n+i] - sn[i]*xx;
+            xx       = t;
+        }
+    }
+
+    // and to c; what is left of b is removed from the residuals
+    double zeta = sw*b;
+    for (i = 0; i < n; i++) {
+        c[i] = (c[i] - sn[i]*zeta) / cs[i];
+        zeta = cs[i]*zeta - sn[i]*c[i];
+    }
+    _rss = std::max(0e0, _rss - zeta*zeta);
+    --_nobs;
+    return 0;
+}
+
+/// @brief The current LS solution.
+///
+/// Solve \f$R x = c\f$ by back substitution.
+///
+/// @param[out] x Vector of size n; at output the LS solution.
+/// @return     0 on success; any other value denotes an error (i.e. R is
+///             singular, e.g. less than n independent observations).
+int
+updatable_qr::solution(double *__restrict__ x) const noexcept
+{
+    const int n = _n;
+    const double *__restrict__ r = _r.data();
+    std::copy(_c.begin(), _c.end(), x);
+    for (int j = n-1; j >= 0; j--) {
+        if (r[j*n+j] == 0e0) return 1;
+        x[j] /= r[j*n+j];
+        for (int i = 0; i < j; i++) x[i] -= x[j]*r[j*n+i];
+    }
+    return 0;
+}
+
+double
+updatable_qr::residual_norm() const noexcept
+{ return std::sqrt(_rss); }
+
+/// @brief The a-posteriori variance factor.
+///
+/// @return \f$\hat{\sigma}_0^2 = \|Ax_{LS}-b\|^2 / (m-n)\f$, where m is the
+///         number of observations; 0 if \f$m \leq n\f$.
+double
+updatable_qr::variance_factor() const noexcept
+{ return (_nobs > _n) ? _rss / (_nobs - _n) : 0e0; }
+
+/// @brief The covariance matrix of the LS solution.
+///
+/// Compute \f$(A^T A)^{-1} = R^{-1} R^{-T}\f$ (see r_covariance),
+/// optionally scaled by the a-posteriori variance factor.
+///
+/// @param[out] cov   Array of size n*n; at output the (symmetric) covariance
+///                   matrix, column-wise.
+/// @param[in]  scale If true, the matrix is scaled by variance_factor().
+/// @return     0 on success; any other value denotes an error (R singular or
+///             allocation failure).
+int
+updatable_qr::covariance(double *__restrict__ cov, bool scale) const
+{
+    const double f = scale ? this->variance_factor() : 1e0;
+    return r_covariance(_r.data(), _n, cov, _n, _n, f);
+}
+
+/// @brief Constructor; empty window.
+///
+/// @param[in] n       Number of parameters, > 0.
+/// @param[in] window  Max number of observations in the window, > 0.
+/// @param[in] refresh If > 0, the factorization is rebuilt from the window
+///                    every refresh downdates.
+/// @param[in] tol     Downdating tolerance (see updatable_qr::remove_row).
+/// @throw     std::bad_alloc if memory allocation fails.
+sliding_window_qr::sliding_window_qr(int n, int window, int refresh, double tol)
+: _ls(n), _window{window}, _refresh{refresh}, _tol{tol}, _head{0}, _count{0},
+  _steps{0}, _nrefac{0}, _rows((long)window*(n+1), 0e0)
+{}
+
+/// @brief Add an observation, dropping the oldest one if the window is full.
+///
+/// @param[in] a The row of the design matrix, of size n.
+/// @param[in] b The observation.
+/// @param[in] w The weight of the observation (> 0).
+void
+sliding_window_qr::push(const double *__restrict__ a, double b, double w)
+noexcept
+{
+    const int n = _ls.num_params();
+    const double sw = (w == 1e0) ? 1e0 : std::sqrt(w);
+    double *row;
+
+    if (_count == _window) {
+        // drop the oldest observation; its slot is reused for the new one
+        row = _rows.data() + (long)_head*(n+1);
+        _head = (_head+1) % _window;
+        --_count;
+        if ((_refresh > 0 && ++_steps >= _refresh)
+            || _ls.remove_row(row, row[n], 1e0, _tol)) {
+            for (int j = 0; j < n; j++) row[j] = sw*a[j];
+            row[n] = sw*b;
+            ++_count;
+            this->refactor();
+            return;
+        }
+    } else {
+        row = _rows.data() + (long)((_head+_count) % _window)*(n+1);
+    }
+
+    for (int j = 0; j < n; j++) row[j] = sw*a[j];
+    row[n] = sw*b;
+    ++_count;
+    _ls.add_row(row, row[n]);
+}
+
+/// Rebuild the factorization from the observations in the window.
+void
+sliding_window_qr::refactor() noexcept
+{
+    const int n = _ls.num_params();
+    _ls.reset();
+    for (int i = 0; i < _count; i++) {
+        const double *row = _rows.data() + (long)((_head+i) % _window)*(n+1);
+        _ls.add_row(row, row[n]);
+    }
+    _steps = 0;
+    ++_nrefac;
+}
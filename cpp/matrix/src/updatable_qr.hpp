@@ -0,0 +1,152 @@
+#ifndef __UPDATABLE_QR_HPP__
+#define __UPDATABLE_QR_HPP__
+
+#include <vector>
+
+/// @brief Recursive (row-updatable) QR Least Squares.
+///
+/// Holds the triangular factor \f$R\in{\Re}^{n\times n}\f$ and the vector
+/// \f$c = Q_1^T b\f$ of the QR factorization of a LS system \f$Ax=b\f$ (see
+/// qr.hpp), plus the residual sum of squares \f$\|d\|^2\f$, but neither A
+/// nor Q. New observations (rows of A and b) are absorbed as they arrive:
+///   - a single row, via n Givens rotations that annihilate it against R,
+///     in \f$O(n^2)\f$,
+///   - a batch of k rows, via n Householder reflections of the stacked
+///     matrix \f$[R; A_k]\f$ (exploiting the triangular structure of R), in
+///     \f$O(kn^2)\f$.
+/// The part of the (rotated) observation that is not absorbed in c is
+/// accumulated in the residual sum of squares. The LS solution, the
+/// residual norm and the covariance matrix are available at any time.
+///
+/// The object starts with \f$R=0\f$, i.e. with no information; the solution
+/// is defined once n linearly independent rows have been added.
+///
+/// Observations can also be removed (downdated), in \f$O(n^2)\f$, with the
+/// LINPACK (dchdd) algorithm; see remove_row. Downdating is not backward
+/// stable: it fails (and leaves the object untouched) when the row to be
+/// removed carries (almost) all the information on some parameter, in which
+/// case the factorization must be rebuilt from the remaining observations
+/// (see sliding_window_qr).
+///
+/// Reference: Matrix Computations, G.H. Colub, CF.V. Loan, 1996, pg. 610
+///            Dongarra, J.J., Bunch, J.R., Moler, C.B. & Stewart, G.W.,
+///            LINPACK Users' Guide, SIAM, 1979, ch. 10
+///
+/// @example test_updatable_qr.cpp
+class updatable_qr
+{
+public:
+    explicit
+    updatable_qr(int n);
+
+    void
+    add_row(const double *__restrict__ a, double b, double w = 1e0) noexcept;
+
+    int
+    add_rows(const double *__restrict__ a, int lda, const double *__restrict__ b,
+        int k);
+
+    int
+    remove_row(const double *__restrict__ a, double b, double w = 1e0,
+        double tol = 1e-4) noexcept;
+
+    int
+    solution(double *__restrict__ x) const noexcept;
+
+    int
+    covariance(double *__restrict__ cov, bool scale = true) const;
+
+    /// Reset to the initial state (no observations).
+    void
+    reset() noexcept;
+
+    /// Number of parameters n.
+    int
+    num_params() const noexcept
+    { return _n; }
+
+    /// Number of observations absorbed so far.
+    long
+    num_obs() const noexcept
+    { return _nobs; }
+
+    /// The (n-by-n, column-wise) upper triangular factor R.
+    const double*
+    r() const noexcept
+    { return _r.data(); }
+
+    /// The vector \f$c = Q_1^T b\f$ (of size n).
+    const double*
+    qtb() const noexcept
+    { return _c.data(); }
+
+    /// The residual norm \f$\|Ax_{LS}-b\|\f$.
+    double
+    residual_norm() const noexcept;
+
+    double
+    variance_factor() const noexcept;
+
+private:
+    int                 _n;        ///< number of parameters
+    long                _nobs;     ///< number of observations
+    double              _rss;      ///< residual sum of squares
+    std::vector<double> _r;        ///< R, n-by-n column-wise
+    std::vector<double> _c;        ///< Q_1^T b
+    std::vector<double> _row;      ///< workspace for add_row/remove_row
+    std::vector<double> _cs, _sn;  ///< rotations of remove_row
+    std::vector<double> _work;     ///< workspace for add_rows
+};
+
+/// @brief Sliding-window QR Least Squares.
+///
+/// LS estimation over the last (at most) N observations: every new
+/// observation is added to an updatable_qr (Givens update) and, once the
+/// window is full, the oldest one is removed from it (LINPACK downdate), so
+/// that a step costs \f$O(n^2)\f$ instead of the \f$O(Nn^2)\f$ of a new
+/// factorization. The observations in the window are kept (in a ring
+/// buffer) so that, when a downdate is ill-conditioned (see
+/// updatable_qr::remove_row) the factorization is rebuilt from them. It can
+/// also be rebuilt every refresh steps, to bound the accumulation of
+/// rounding errors.
+///
+/// @example test_updatable_qr.cpp
+class sliding_window_qr
+{
+public:
+    sliding_window_qr(int n, int window, int refresh = 0, double tol = 1e-4);
+
+    void
+    push(const double *__restrict__ a, double b, double w = 1e0) noexcept;
+
+    /// The LS system of the current window.
+    const updatable_qr&
+    ls() const noexcept
+    { return _ls; }
+
+    /// Number of observations in the window.
+    int
+    size() const noexcept
+    { return _count; }
+
+    /// Number of times the factorization was rebuilt from the window.
+    long
+    num_refactorizations() const noexcept
+    { return _nrefac; }
+
+private:
+    void
+    refactor() noexcept;
+
+    updatable_qr        _ls;       ///< LS system of the window
+    int                 _window;   ///< max number of observations
+    int                 _refresh;  ///< rebuild every _refresh steps (0: never)
+    double              _tol;      ///< downdating tolerance
+    int                 _head;     ///< ring buffer index of the oldest row
+    int                 _count;    ///< observations in the window
+    long                _steps;    ///< downdates since last rebuild
+    long                _nrefac;   ///< number of rebuilds
+    std::vector<double> _rows;     ///< ring buffer; rows [sqrt(w)*a, sqrt(w)*b]
+};
+
+#endif